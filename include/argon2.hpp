@@ -0,0 +1,69 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Argon2id (RFC 9106) key derivation.
+ *
+ * Lanes are filled on their own threads and meet at the four
+ * synchronization points of every pass, so a large memory cost
+ * is spread over the available cores.
+ */
+class argon2 {
+public:
+    /// Costs in the units of the PHC string format: m=KiB, t=passes, p=lanes
+    struct parameters {
+        std::uint32_t memory_kib = 64 * 1024;
+        std::uint32_t passes = 3;
+        std::uint32_t lanes = 4;
+    };
+
+    static auto derive(std::string_view password, std::string_view salt, const parameters &cost,
+                       std::size_t tag_size = key_size, std::string_view secret = { },
+                       std::string_view associated = { }) -> std::pmr::string;
+    static auto generate_salt() -> std::string;
+    static auto configured() -> parameters;
+    static auto parse(std::string_view text, parameters &cost) -> bool;
+    static auto valid(const parameters &cost) -> bool;
+    static auto self_test() -> bool;
+    static auto calibrate(std::chrono::milliseconds target) -> bool;
+
+    static constexpr std::size_t key_size = 32;
+    static constexpr std::size_t salt_size = 16;
+
+private:
+    using block = std::array<std::uint64_t, 128>;
+
+    /// Layout of the memory matrix shared by the lane threads
+    struct matrix {
+        block *memory;
+        std::uint32_t lanes;
+        std::uint32_t lane_length;
+        std::uint32_t segment_length;
+        std::uint32_t passes;
+    };
+
+    static auto long_hash(void *digest, std::size_t digest_size, const void *data, std::size_t size) -> void;
+    static auto compress(const block &previous, const block &reference, block &next, bool with_xor) -> void;
+    static auto next_addresses(block &address, block &input) -> void;
+    static auto fill_segment(const matrix &state, std::uint32_t pass, std::uint32_t lane, std::uint32_t slice) -> void;
+    static auto reference_index(const matrix &state, std::uint32_t pass, std::uint32_t slice,
+                                std::uint32_t index, std::uint64_t random, bool same_lane) -> std::uint32_t;
+    static auto measure(const parameters &cost) -> std::chrono::duration<double, std::milli>;
+
+    static constexpr std::uint32_t _version = 0x13;
+    static constexpr std::uint32_t _type = 2;
+    static constexpr std::uint32_t _sync_points = 4;
+    static constexpr std::uint32_t _max_memory_kib = 4 * 1024 * 1024;
+    static constexpr std::uint32_t _max_lanes = 64;
+    static constexpr std::uint32_t _max_passes = 1024;
+};
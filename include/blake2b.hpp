@@ -0,0 +1,39 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief BLAKE2b (RFC 7693) with a digest of 1 to 64 bytes, unkeyed or keyed as a MAC.
+ */
+class blake2b {
+public:
+    explicit blake2b(std::size_t digest_size);
+    blake2b(std::size_t digest_size, std::string_view key);
+
+    auto update(const void *data, std::size_t size) -> void;
+    auto update(std::string_view data) -> void;
+    auto update_u32(std::uint32_t value) -> void;
+    auto final(void *digest) -> void;
+
+    static auto hash(void *digest, std::size_t digest_size, const void *data, std::size_t size) -> void;
+
+    static constexpr std::size_t max_digest_size = 64;
+    static constexpr std::size_t max_key_size = 64;
+
+private:
+    auto compress(bool last) -> void;
+
+    std::array<std::uint64_t, 8> _state { };
+    std::array<std::uint8_t, 128> _buffer { };
+    std::size_t _buffered = 0;
+    std::uint64_t _counter = 0;
+    std::size_t _digest_size;
+};
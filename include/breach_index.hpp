@@ -0,0 +1,81 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Offline lookup of passwords in a breach corpus, such as the
+ *        "ordered by hash" SHA-1 or NTLM downloads of Have I Been Pwned.
+ *
+ * The text corpus is converted once into an index file:
+ *
+ *     header      "GCBI", version, algorithm, record size, record count,
+ *                 Bloom filter bits and hash count
+ *     fan-out     65537 record offsets, one per leading 16-bit hash prefix
+ *     records     the rest of every hash after its prefix and the times it
+ *                 was seen, sorted
+ *     Bloom       optional filter over all hashes
+ *
+ * The index is mapped read-only. A lookup reads one fan-out entry and
+ * guesses the record position from the hash, since hashes are uniform,
+ * so it touches one or two pages. The Bloom filter is copied into memory
+ * and turns most misses away without touching the file at all.
+ */
+class breach_index {
+public:
+    enum class algorithm : std::uint32_t { sha1, ntlm };
+
+    ~breach_index();
+    breach_index(const breach_index&) = delete;
+    auto operator=(const breach_index&) -> breach_index& = delete;
+
+    static auto build(const std::string &source, const std::string &target,
+                      algorithm type, unsigned bloom_bits_per_hash) -> bool;
+    static auto open(const std::string &filename, bool load_bloom = true) -> std::unique_ptr<breach_index>;
+    static auto configured() -> const breach_index*;
+    static auto scan(const categories &category, const passwords &password) -> void;
+
+    [[nodiscard]] auto occurrences(std::string_view password) const -> std::uint32_t;
+    [[nodiscard]] auto records() const -> std::uint64_t { return _record_count; }
+
+private:
+    breach_index() = default;
+
+    [[nodiscard]] auto find(std::span<const std::uint8_t> digest) const -> std::uint32_t;
+    [[nodiscard]] auto bloom_contains(std::span<const std::uint8_t> digest) const -> bool;
+
+    static auto parse_hex(std::string_view text, std::span<std::uint8_t> digest) -> bool;
+    static auto bloom_positions(std::span<const std::uint8_t> digest) -> std::pair<std::uint64_t, std::uint64_t>;
+
+    static constexpr std::string_view _magic = "GCBI";
+    static constexpr std::uint32_t _version = 1;
+    static constexpr std::size_t _header_size = 64;
+    static constexpr std::size_t _prefix_size = 2;
+    static constexpr std::size_t _fanout_entries = (1U << 16) + 1;
+    static constexpr std::size_t _count_size = 4;
+
+    void *_mapping = nullptr;
+    std::size_t _mapping_size = 0;
+    algorithm _type = algorithm::sha1;
+    std::size_t _digest_size = 0;
+    std::size_t _record_size = 0;
+    std::uint64_t _record_count = 0;
+    const std::uint8_t *_fanout = nullptr;
+    const std::uint8_t *_records = nullptr;
+
+    std::uint64_t _bloom_bits = 0;
+    std::uint32_t _bloom_hashes = 0;
+    std::vector<std::uint64_t> _bloom;
+};
@@ -11,6 +11,7 @@
 #include <variant>
 #include <optional>
 #include <iostream>
+#include <memory_resource>
 #include <fmt/core.h>
 
 class categories {
@@ -19,19 +20,32 @@ public:
         std::size_t ID { };
         std::string name;
         std::size_t _pass_id = 1;
-        std::map<std::size_t, std::string> passwords;
+        std::pmr::map<std::size_t, std::pmr::string> passwords;
     };
 
     auto add() -> void;
+    auto insert(const std::string &category_name) -> std::size_t;
+    auto insert_password(std::size_t category_ID,
+                         const std::string &password) -> std::optional<std::size_t>;
     auto remove() -> void;
-    auto is_printable() -> bool;
+    [[nodiscard]] auto empty() const -> bool;
     [[nodiscard]] auto get_ID(std::size_t category_ID) const -> std::optional<category>;
     [[nodiscard]] auto get_name(const std::string &category_name) const -> std::optional<category>;
+    [[nodiscard]] auto complete(const std::string &prefix) const -> std::optional<category>;
     [[nodiscard]] auto get(const std::variant<std::size_t,
                            std::string> &identifier) const -> std::optional<category>;
 
     std::map<std::size_t, category> categories_map;
 
 private:
+    friend class vault_file;
+    friend class fixture;
+    friend class transaction;
+    friend class sealed_vault;
+    friend class vault_watcher;
+
     std::size_t _current_ID = 1;
+
+    /// Categories listed when an abbreviated name is ambiguous
+    static constexpr std::size_t _suggestions = 5;
 };
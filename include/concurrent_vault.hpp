@@ -0,0 +1,79 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <atomic>
+
+#include "vault_state.hpp"
+
+/**
+ * @brief Thread-safe vault with read-copy-update semantics.
+ *
+ * Readers announce the current epoch, load the published version and leave,
+ * so they never wait for writers. Writers are serialized by a mutex, copy the
+ * current version in O(1), mutate the copy (O(log n) new nodes) and publish
+ * it atomically. A replaced version is reclaimed once no reader is left in
+ * an epoch that could still see it.
+ */
+class concurrent_vault {
+public:
+    struct match {
+        std::size_t category_ID;
+        std::size_t password_ID;
+        std::pmr::string password;
+    };
+
+    concurrent_vault();
+    explicit concurrent_vault(const vault_state &initial);
+    ~concurrent_vault();
+
+    concurrent_vault(const concurrent_vault &) = delete;
+    auto operator=(const concurrent_vault &) -> concurrent_vault& = delete;
+
+    [[nodiscard]] auto snapshot() const -> std::shared_ptr<const vault_state>;
+    [[nodiscard]] auto get(std::size_t category_ID, std::size_t password_ID) const -> std::optional<std::pmr::string>;
+    [[nodiscard]] auto search(std::string_view search_param) const -> std::vector<match>;
+
+    auto add_category(const std::string &category_name) -> std::size_t;
+    auto remove_category(std::size_t category_ID) -> bool;
+    auto add_password(std::size_t category_ID, std::string_view password) -> std::optional<std::size_t>;
+    auto edit_password(std::size_t category_ID, std::size_t password_ID, std::string_view password) -> bool;
+    auto remove_password(std::size_t category_ID, std::size_t password_ID) -> bool;
+
+private:
+    struct published {
+        std::shared_ptr<const vault_state> state;
+    };
+
+    struct retired {
+        published *version;
+        std::uint64_t epoch;
+    };
+
+    /// Atomics are value-initialized, so a slot starts unused and outside of any epoch
+    struct alignas(64) reader_slot {
+        std::atomic<std::uint64_t> epoch;
+        std::atomic<bool> used;
+    };
+
+    template <typename Mutation>
+    auto update(Mutation &&mutation) -> decltype(mutation(std::declval<vault_state&>()));
+    auto reclaim() -> void;
+    static auto reader_index() -> std::size_t;
+
+    std::atomic<published*> _current;
+    std::vector<retired> _retired;
+    std::mutex _writer;
+    std::size_t _next_category_ID = 1;
+    std::size_t _next_password_ID = 1;
+
+    static constexpr std::size_t _max_readers = 256;
+    inline static std::atomic<std::uint64_t> _epoch { 1 };
+    inline static std::array<reader_slot, _max_readers> _readers;
+};
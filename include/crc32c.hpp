@@ -0,0 +1,29 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief CRC-32C (Castagnoli), the checksum of iSCSI and ext4.
+ *
+ * Uses the crc32 instruction of SSE4.2 when the processor has it and
+ * eight lookup tables otherwise. Both give the same checksums.
+ */
+class crc32c {
+public:
+    static auto compute(const void *data, std::size_t size, std::uint32_t crc = 0) -> std::uint32_t;
+    static auto compute(std::string_view data, std::uint32_t crc = 0) -> std::uint32_t;
+    static auto hardware() -> bool;
+
+private:
+    static auto software(const std::uint8_t *data, std::size_t size, std::uint32_t state) -> std::uint32_t;
+#if defined(__x86_64__)
+    static auto sse42(const std::uint8_t *data, std::size_t size, std::uint32_t state) -> std::uint32_t;
+#endif
+};
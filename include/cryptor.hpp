@@ -5,22 +5,19 @@
 
 #pragma once
 
+#include "exporter.hpp"
 #include "categories.hpp"
 
 class cryptor {
 public:
-    static auto encrypt(const std::string &plaintext,
-                 const std::string &key) -> std::string;
+    static auto encrypt(std::string_view plaintext,
+                 std::string_view key) -> std::pmr::string;
     static auto initialize_encrypt(categories &category) -> void;
-    static auto encrypt_map(std::map<std::size_t, std::string> &passwords,
-                            const std::string &encryption_key) -> void;
-    static auto write(const categories &category,
-                      const std::map<std::size_t, std::string> &data,
-                      const std::string &filename) -> bool;
+    static auto encrypt_map(std::pmr::map<std::size_t, std::pmr::string> &passwords,
+                            std::string_view encryption_key) -> void;
+    static auto write(const categories &category, const std::string &filename,
+                      std::string_view preamble = { }) -> bool;
 
-    [[maybe_unused]] static auto decrypt(const std::string &ciphertext,
-                                         const std::string &key) -> std::string;
-
-private:
-    inline static std::string _secret_key;
+    [[maybe_unused]] static auto decrypt(std::string_view ciphertext,
+                                         std::string_view key) -> std::pmr::string;
 };
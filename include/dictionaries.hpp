@@ -0,0 +1,169 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <string_view>
+
+/**
+ * @brief Word lists of the strength estimator, most common first.
+ *
+ * Everything is lowercase, the estimator folds case and undoes common
+ * substitutions before it looks a word up. The estimator only reads the
+ * lists at compile time, to build its tries. The fixture generator also
+ * draws category names from the words.
+ */
+namespace dictionaries {
+    inline constexpr auto passwords = std::to_array<std::string_view>({
+            "123456", "password", "12345678", "qwerty", "123456789", "12345", "1234", "111111", "1234567",
+            "dragon", "123123", "baseball", "abc123", "football", "monkey", "letmein", "696969", "shadow",
+            "master", "666666", "qwertyuiop", "123321", "mustang", "1234567890", "michael", "654321", "superman",
+            "1qaz2wsx", "7777777", "121212", "000000", "qazwsx", "123qwe", "killer", "trustno1", "jordan",
+            "jennifer", "zxcvbnm", "asdfgh", "hunter", "buster", "soccer", "harley", "batman", "andrew", "tigger",
+            "sunshine", "iloveyou", "2000", "charlie", "robert", "thomas", "hockey", "ranger", "daniel",
+            "starwars", "klaster", "112233", "george", "computer", "michelle", "jessica", "pepper", "1111",
+            "zxcvbn", "555555", "11111111", "131313", "freedom", "777777", "pass", "maggie", "159753", "aaaaaa",
+            "ginger", "princess", "joshua", "cheese", "amanda", "summer", "love", "ashley", "nicole", "chelsea",
+            "biteme", "matthew", "access", "yankees", "987654321", "dallas", "austin", "thunder", "taylor",
+            "matrix", "william", "corvette", "hello", "martin", "heather", "secret", "merlin", "diamond",
+            "1234qwer", "gfhjkm", "hammer", "silver", "222222", "88888888", "anthony", "justin", "test",
+            "bailey", "q1w2e3r4t5", "patrick", "internet", "scooter", "orange", "11111", "golfer", "cookie",
+            "richard", "samantha", "bigdog", "guitar", "jackson", "whatever", "mickey", "chicken", "sparky",
+            "snoopy", "maverick", "phoenix", "camaro", "peanut", "morgan", "welcome", "falcon", "cowboy",
+            "ferrari", "samsung", "andrea", "smokey", "steelers", "joseph", "mercedes", "dakota", "arsenal",
+            "eagles", "melissa", "boomer", "booboo", "spider", "nascar", "monster", "tigers", "yellow", "xxxxxx",
+            "123123123", "gateway", "marina", "diablo", "bulldog", "qwer1234", "compaq", "purple", "hardcore",
+            "banana", "junior", "hannah", "123654", "porsche", "lakers", "iceman", "money", "cowboys", "987654",
+            "london", "tennis", "999999", "ncc1701", "coffee", "scooby", "0000", "miller", "boston", "q1w2e3r4",
+            "brandon", "yamaha", "chester", "mother", "forever", "johnny", "edward", "333333", "oliver",
+            "redsox", "player", "nikita", "knight", "fender", "barney", "midnight", "please", "brandy",
+            "chicago", "badboy", "slayer", "rangers", "charles", "angel", "flower", "bigdaddy", "rabbit",
+            "wizard", "jasper", "enter", "rachel", "chris", "steven", "winner", "adidas", "victoria",
+            "natasha", "1q2w3e4r", "jasmine", "winter", "prince", "panties", "marine", "ghbdtn", "fishing",
+            "cocacola", "casper", "james", "232323", "raiders", "888888", "marlboro", "gandalf", "asdfasdf",
+            "crystal", "87654321", "12344321", "golden", "8675309", "panther", "lauren", "angela", "thx1138",
+            "angels", "madison", "winston", "shannon", "mike", "toyota", "blowme", "jordan23", "canada",
+            "sophie", "apples", "dick", "tiger", "razz", "123abc", "pokemon", "qazxsw", "55555", "qwaszx",
+            "muffin", "johnson", "murphy", "cooper", "jonathan", "liverpoo", "david", "danielle", "159357",
+            "jackie", "1990", "123456a", "789456", "turtle", "horny", "abcd1234", "scorpion", "qazwsxedc",
+            "101010", "butter", "carlos", "password1", "dennis", "slipknot", "qwerty123", "booger", "asdf",
+            "1991", "black", "startrek", "12341234", "cameron", "newyork", "rainbow", "nathan", "john",
+            "1992", "rocket", "viking", "redskins", "butthead", "asdfghjkl", "1212", "sierra", "peaches",
+            "gemini", "doctor", "wilson", "sandra", "helpme", "qwertyui", "victor", "florida", "dolphin",
+            "pookie", "captain", "tucker", "blue", "liverpool", "theman", "bandit", "dolphins", "maddog",
+            "packers", "jaguar", "lovers", "nicholas", "united", "tiffany", "maxwell", "zzzzzz", "nirvana",
+            "jeremy", "suckit", "stupid", "porn", "monica", "elephant", "giants", "jackass", "hotdog", "rosebud",
+            "success", "debbie", "mountain", "444444", "xxxxxxxx", "warrior", "1q2w3e4r5t", "q1w2e3",
+            "123456q", "albert", "metallic", "lucky", "azerty", "7777", "shithead", "alex", "bond007",
+            "alexis", "1111111", "samson", "5150", "willie", "scorpio", "bonnie", "gators", "benjamin",
+            "voodoo", "driver", "dexter", "2112", "jason", "calvin", "freddy", "212121", "creative",
+            "12345a", "sydney", "rush2112", "1989", "asdfghjk", "red123", "bubba", "4815162342", "passw0rd",
+            "trouble", "gunner", "happy", "gordon", "legend", "jessie", "stella", "qwert", "eminem", "arthur",
+            "apple", "nissan", "bullshit", "bear", "america", "1qazxsw2", "nothing", "parker", "4444",
+            "rebecca", "qweqwe", "garfield", "01012011", "beavis", "69696969", "jack", "asdasd", "december",
+            "2222", "102030", "252525", "11223344", "magic", "apollo", "skippy", "315475", "girls", "kitten",
+            "golf", "copper", "braves", "shelby", "godzilla", "beaver", "fred", "tomcat", "august", "buddy",
+            "airborne", "1993", "1988", "lifehack", "qqqqqq", "brooklyn", "animal", "platinum", "phantom",
+            "online", "xavier", "darkness", "blink182", "power", "fish", "green", "789456123", "voyager",
+            "police", "travis", "12qwaszx", "heaven", "snowball", "lover", "abcdef", "00000", "pakistan",
+            "007007", "walter", "playboy", "blazer", "cricket", "sniper", "donkey", "willow", "loveme",
+            "saturn", "therock", "redwings", "admin", "admin123", "changeme", "default", "guest", "root",
+            "toor", "login", "passpass", "p@ssw0rd", "letmein1", "welcome1", "iloveyou1", "monkey1",
+            "football1", "abc12345", "qwerty1", "password123", "1q2w3e", "zaq12wsx", "master1", "superman1",
+    });
+
+    inline constexpr auto words = std::to_array<std::string_view>({
+            "the", "you", "and", "that", "this", "have", "what", "for", "not", "with", "are", "was", "your",
+            "but", "all", "just", "can", "get", "there", "like", "know", "here", "out", "now", "one", "yeah",
+            "about", "well", "want", "right", "going", "how", "think", "come", "good", "they", "his", "him",
+            "who", "she", "back", "time", "her", "look", "take", "tell", "why", "then", "did", "could", "would",
+            "make", "really", "see", "something", "okay", "never", "sure", "when", "need", "some", "let",
+            "say", "from", "more", "way", "mean", "people", "thing", "man", "very", "were", "much", "only",
+            "little", "give", "should", "maybe", "great", "life", "because", "call", "over", "thank", "where",
+            "yes", "still", "night", "work", "down", "long", "find", "first", "before", "after", "nothing",
+            "always", "help", "talk", "home", "other", "place", "those", "again", "things", "keep", "these",
+            "even", "day", "kind", "world", "old", "girl", "boy", "big", "friend", "father", "mother", "family",
+            "love", "dead", "house", "live", "believe", "stop", "money", "game", "happy", "hand", "head",
+            "heart", "best", "school", "car", "new", "year", "years", "name", "real", "stay", "city", "baby",
+            "sorry", "woman", "women", "water", "light", "dark", "fire", "blood", "music", "party", "kill",
+            "death", "hell", "god", "jesus", "christ", "lord", "king", "queen", "prince", "princess", "angel",
+            "devil", "demon", "dragon", "tiger", "lion", "eagle", "wolf", "bear", "horse", "snake", "monkey",
+            "rabbit", "bunny", "kitty", "puppy", "doggy", "dog", "cat", "bird", "fish", "shark", "spider",
+            "mouse", "pony", "sun", "moon", "star", "stars", "sky", "earth", "ocean", "river", "rain", "snow",
+            "storm", "thunder", "winter", "summer", "spring", "autumn", "fall", "red", "blue", "green",
+            "yellow", "black", "white", "orange", "purple", "pink", "silver", "gold", "golden", "diamond",
+            "crystal", "magic", "power", "secret", "hidden", "freedom", "peace", "hope", "faith", "dream",
+            "dreams", "forever", "always", "sweet", "sugar", "honey", "candy", "chocolate", "cookie", "apple",
+            "banana", "cherry", "lemon", "peach", "coffee", "pizza", "cheese", "butter", "bacon", "chicken",
+            "soccer", "football", "baseball", "hockey", "tennis", "golf", "basketball", "player", "team",
+            "winner", "champion", "master", "killer", "hunter", "warrior", "soldier", "ninja", "pirate",
+            "knight", "wizard", "hero", "super", "captain", "doctor", "teacher", "student", "computer",
+            "internet", "online", "system", "server", "admin", "user", "login", "access", "pass", "word",
+            "welcome", "hello", "change", "default", "guest", "test", "testing", "private", "public",
+            "office", "company", "business", "summer", "monday", "tuesday", "wednesday", "thursday", "friday",
+            "saturday", "sunday", "january", "february", "march", "april", "may", "june", "july", "august",
+            "september", "october", "november", "december", "morning", "evening", "today", "tomorrow",
+            "birthday", "christmas", "holiday", "vacation", "beach", "island", "mountain", "forest", "garden",
+            "flower", "rose", "lily", "daisy", "tree", "stone", "rock", "metal", "steel", "iron", "paper",
+            "book", "story", "movie", "star", "rocket", "space", "planet", "galaxy", "universe", "shadow",
+            "ghost", "zombie", "vampire", "monster", "alien", "robot", "machine", "matrix", "cyber", "hacker",
+            "guitar", "piano", "drum", "song", "dance", "rock", "metal", "punk", "funk", "jazz", "blues",
+            "lucky", "crazy", "funny", "silly", "pretty", "beautiful", "sexy", "cute", "cool", "hot", "cold",
+            "fast", "slow", "strong", "smart", "brave", "wild", "free", "true", "blue", "wonder", "wonderful",
+            "miracle", "heaven", "paradise", "destiny", "victory", "glory", "legend", "mystery", "trust",
+            "nobody", "everybody", "someone", "anything", "everything", "welcome", "goodbye", "please",
+            "thanks", "letme", "letmein", "open", "sesame", "door", "key", "lock", "safe", "vault", "guard",
+            "cipher", "code", "crypto", "shield", "castle", "tower", "bridge", "road", "street", "town",
+            "country", "america", "england", "london", "paris", "berlin", "tokyo", "china", "russia",
+            "canada", "texas", "florida", "california", "boston", "chicago", "dallas", "miami", "vegas",
+            "hollywood", "disney", "mickey", "batman", "superman", "spiderman", "pokemon", "naruto", "mario",
+            "zelda", "sonic", "starwars", "jedi", "yoda", "vader", "hobbit", "gandalf", "frodo", "harry",
+            "potter", "simpson", "homer", "bart", "snoopy", "garfield", "scooby", "tigger", "winnie", "pooh",
+            "qwerty", "azerty", "letter", "number", "phone", "mobile", "email", "google", "apple", "yahoo",
+            "facebook", "twitter", "amazon", "microsoft", "windows", "linux", "android", "iphone", "samsung",
+            "nokia", "sony", "nintendo", "xbox", "playstation", "minecraft", "fortnite", "roblox", "steam",
+    });
+
+    inline constexpr auto names = std::to_array<std::string_view>({
+            "james", "john", "robert", "michael", "william", "david", "richard", "charles", "joseph", "thomas",
+            "christopher", "daniel", "paul", "mark", "donald", "george", "kenneth", "steven", "edward", "brian",
+            "ronald", "anthony", "kevin", "jason", "matthew", "gary", "timothy", "jose", "larry", "jeffrey",
+            "frank", "scott", "eric", "stephen", "andrew", "raymond", "gregory", "joshua", "jerry", "dennis",
+            "walter", "patrick", "peter", "harold", "douglas", "henry", "carl", "arthur", "ryan", "roger",
+            "joe", "juan", "jack", "albert", "jonathan", "justin", "terry", "gerald", "keith", "samuel",
+            "willie", "ralph", "lawrence", "nicholas", "roy", "benjamin", "bruce", "brandon", "adam", "harry",
+            "fred", "wayne", "billy", "steve", "louis", "jeremy", "aaron", "randy", "howard", "eugene", "carlos",
+            "russell", "bobby", "victor", "martin", "ernest", "phillip", "todd", "jesse", "craig", "alan",
+            "shawn", "clarence", "sean", "philip", "chris", "johnny", "earl", "jimmy", "antonio", "danny",
+            "bryan", "tony", "luis", "mike", "stanley", "leonard", "nathan", "dale", "manuel", "rodney",
+            "curtis", "norman", "allen", "marvin", "vincent", "glenn", "jeffery", "travis", "jeff", "chad",
+            "jacob", "lee", "melvin", "alfred", "kyle", "francis", "bradley", "jesus", "herbert", "frederick",
+            "ray", "joel", "edwin", "don", "eddie", "ricky", "troy", "randall", "barry", "alexander", "bernard",
+            "mario", "leroy", "francisco", "marcus", "micheal", "theodore", "clifford", "miguel", "oscar", "jay",
+            "jim", "tom", "calvin", "alex", "jon", "ronnie", "bill", "lloyd", "tommy", "leon", "derek", "warren",
+            "darrell", "jerome", "floyd", "leo", "alvin", "tim", "wesley", "gordon", "dean", "greg", "jorge",
+            "dustin", "pedro", "derrick", "dan", "lewis", "zachary", "corey", "herman", "maurice", "vernon",
+            "mary", "patricia", "linda", "barbara", "elizabeth", "jennifer", "maria", "susan", "margaret",
+            "dorothy", "lisa", "nancy", "karen", "betty", "helen", "sandra", "donna", "carol", "ruth", "sharon",
+            "michelle", "laura", "sarah", "kimberly", "deborah", "jessica", "shirley", "cynthia", "angela",
+            "melissa", "brenda", "amy", "anna", "rebecca", "virginia", "kathleen", "pamela", "martha", "debra",
+            "amanda", "stephanie", "carolyn", "christine", "marie", "janet", "catherine", "frances", "ann",
+            "joyce", "diane", "alice", "julie", "heather", "teresa", "doris", "gloria", "evelyn", "jean",
+            "cheryl", "mildred", "katherine", "joan", "ashley", "judith", "rose", "janice", "kelly", "nicole",
+            "judy", "christina", "kathy", "theresa", "beverly", "denise", "tammy", "irene", "jane", "lori",
+            "rachel", "marilyn", "andrea", "kathryn", "louise", "sara", "anne", "jacqueline", "wanda", "bonnie",
+            "julia", "ruby", "lois", "tina", "phyllis", "norma", "paula", "diana", "annie", "lillian", "emily",
+            "robin", "peggy", "crystal", "gladys", "rita", "dawn", "connie", "florence", "tracy", "edna",
+            "tiffany", "carmen", "rosa", "cindy", "grace", "wendy", "victoria", "edith", "kim", "sherry",
+            "sylvia", "josephine", "thelma", "shannon", "sheila", "ethel", "ellen", "elaine", "marjorie",
+            "carrie", "charlotte", "monica", "esther", "pauline", "emma", "juanita", "anita", "rhonda",
+            "hazel", "amber", "eva", "debbie", "april", "leslie", "clara", "lucille", "jamie", "joanne",
+            "eleanor", "valerie", "danielle", "megan", "alicia", "suzanne", "michele", "gail", "bertha",
+            "darlene", "veronica", "jill", "erin", "geraldine", "lauren", "cathy", "joann", "lorraine", "lynn",
+            "sally", "regina", "erica", "beatrice", "dolores", "bernice", "audrey", "yvonne", "annette",
+            "smith", "johnson", "williams", "jones", "brown", "davis", "miller", "wilson", "moore",
+    });
+}
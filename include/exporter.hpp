@@ -0,0 +1,39 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <fstream>
+#include <optional>
+#include <fmt/format.h>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+class exporter {
+public:
+    enum class format { text, csv, json_lines };
+
+    static auto initialize_export(const categories &category, const passwords &password) -> void;
+    static auto write(const categories &category,
+                      const std::pmr::map<std::size_t, passwords::password> &uncategorized,
+                      const std::string &filename, format type, bool parallel = false,
+                      std::string_view preamble = { }) -> bool;
+    static auto parse_format(const std::string &name) -> std::optional<format>;
+
+private:
+    static auto format_header(fmt::memory_buffer &buffer, format type) -> void;
+    static auto format_category(fmt::memory_buffer &buffer, const categories::category &category,
+                                format type, std::ofstream *file = nullptr) -> void;
+    static auto format_uncategorized(fmt::memory_buffer &buffer,
+                                     const std::pmr::map<std::size_t, passwords::password> &uncategorized,
+                                     format type, std::ofstream *file = nullptr) -> void;
+    static auto append_escaped(fmt::memory_buffer &buffer, std::string_view value, format type) -> void;
+    static auto append_json(fmt::memory_buffer &buffer, std::string_view name, std::string_view value) -> void;
+    static auto flush(std::ofstream &file, fmt::memory_buffer &buffer) -> void;
+
+    /// Buffers are written out once they grow past this many bytes
+    static constexpr std::size_t _block_size = 1 << 20;
+};
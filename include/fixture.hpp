@@ -0,0 +1,56 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Builds synthetic vaults of a given shape for scale testing.
+ *
+ * The vault is filled directly, without going through the history, so
+ * millions of entries take seconds. Categories and slices of the password
+ * list are built on worker threads, each from an engine seeded by the seed
+ * and its own index. The same seed gives the same vault on any number of
+ * threads.
+ */
+class fixture {
+public:
+    struct shape {
+        std::size_t categories = 100;
+        /// Passwords in the whole vault
+        std::size_t entries = 10'000;
+        /// Zipf exponent of the category sizes, 0 makes every category the same size
+        double skew = 1.0;
+        /// Share of the passwords that go to the password list
+        double uncategorized = 0.1;
+        /// Password lengths are normally distributed and clamped to 8 to 50
+        double length_mean = 16;
+        double length_deviation = 4;
+        /// Category name lengths are normally distributed and clamped to 4 to 64
+        double name_mean = 12;
+        double name_deviation = 4;
+        std::uint64_t seed = 1;
+        std::size_t threads = 0;
+    };
+
+    static auto build(const shape &layout, categories &category, passwords &password) -> void;
+    static auto valid(const shape &layout) -> bool;
+
+private:
+    static auto category_sizes(const shape &layout, std::size_t categorized) -> std::vector<std::size_t>;
+    static auto category_name(std::mt19937_64 &engine, const shape &layout, std::size_t ID) -> std::string;
+    static auto password_length(std::mt19937_64 &engine, const shape &layout) -> int;
+    static auto unit_seed(std::uint64_t seed, std::uint64_t unit) -> std::uint64_t;
+
+    /// The password list is built in slices of this many passwords
+    static constexpr std::size_t _list_slice = 1 << 16;
+};
@@ -0,0 +1,42 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "vault_state.hpp"
+
+class history {
+public:
+    struct version : vault_state {
+        std::string label;
+    };
+
+    static auto put_category(const categories::category &category) -> void;
+    static auto erase_category(std::size_t category_ID) -> void;
+    static auto put_password(std::size_t category_ID, std::size_t password_ID,
+                             std::string_view password) -> void;
+    static auto erase_password(std::size_t category_ID, std::size_t password_ID) -> void;
+    static auto put_uncategorized(const passwords::password &password) -> void;
+    static auto erase_uncategorized(std::size_t password_ID) -> void;
+    static auto rebuild(const categories &category, const passwords &password) -> void;
+    static auto clear() -> void;
+
+    static auto commit(const std::string &label) -> void;
+    static auto undo(categories &category, passwords &password) -> void;
+    static auto redo(categories &category, passwords &password) -> void;
+    [[nodiscard]] static auto snapshot() -> version;
+
+private:
+    /// Live mirror of the vault, updated by every mutation, name_index follows it
+    inline static version _current;
+    /// State as of the last commit, which undo returns to
+    inline static version _committed;
+    inline static std::deque<version> _undo;
+    inline static std::deque<version> _redo;
+
+    static constexpr std::size_t _max_depth = 100;
+};
@@ -0,0 +1,68 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <optional>
+#include <memory_resource>
+#include <string_view>
+
+/**
+ * @brief Per-category data keys, wrapped by a master key.
+ *
+ * Every category, and the password list under list_ID, is encrypted with
+ * its own random data key. Vault files store the data keys wrapped by the
+ * master key derived from the secret, so changing the secret only rewraps
+ * one small blob per category. The keys of the open vault stay here
+ * between saves, in the locked arena like the plaintext they protect.
+ *
+ * A data key is wrapped with a key of its own, a keyed BLAKE2b of the
+ * master key over the category ID and a random nonce stored with the blob,
+ * so learning one data key reveals nothing about the master key or the
+ * other data keys. A keyed BLAKE2b over the ID, the nonce and the wrapped
+ * key authenticates the blob.
+ */
+class keyring {
+public:
+    /// A data key as stored in a vault file
+    struct wrapped {
+        /// Empty for vaults written before the nonce-based wrapping
+        std::string nonce;
+        std::string key;
+        /// MAC of the blob, tells a wrong master key apart from a corrupted or swapped blob
+        std::string check;
+    };
+
+    static auto data_key(std::size_t ID) -> std::pmr::string;
+    static auto generate() -> std::pmr::string;
+    static auto wrap(std::size_t ID, std::string_view data_key, std::string_view master_key) -> wrapped;
+    static auto unwrap(std::size_t ID, const wrapped &blob,
+                       std::string_view master_key) -> std::optional<std::pmr::string>;
+    static auto unwrap_legacy(const wrapped &blob, std::string_view master_key) -> std::optional<std::pmr::string>;
+    static auto replace(std::pmr::map<std::size_t, std::pmr::string> loaded) -> void;
+
+    /// Category IDs start at 1, so 0 is free for the password list
+    static constexpr std::size_t list_ID = 0;
+    static constexpr std::size_t key_size = 32;
+    static constexpr std::size_t check_size = 16;
+    static constexpr std::size_t nonce_size = 16;
+
+private:
+    static auto wrapping_key(std::size_t ID, std::string_view nonce, std::string_view master_key) -> std::pmr::string;
+    static auto authenticate(std::size_t ID, const wrapped &blob, std::string_view master_key) -> std::string;
+    static auto equal(std::string_view left, std::string_view right) -> bool;
+    static auto random_bytes(std::size_t size) -> std::pmr::string;
+
+    /// Keep the wrapping keys and the MAC keys apart
+    static constexpr std::string_view _wrap_context = "GuardCipher key wrap";
+    static constexpr std::string_view _check_context = "GuardCipher key check";
+
+    /// Created on first use, so the keys come from the resource main() installs
+    static auto keys() -> std::pmr::map<std::size_t, std::pmr::string>&;
+
+    inline static std::optional<std::pmr::map<std::size_t, std::pmr::string>> _keys;
+};
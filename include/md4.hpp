@@ -0,0 +1,36 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief MD4 (RFC 1320), only used for NTLM hashes of breach corpora.
+ */
+class md4 {
+public:
+    static constexpr std::size_t digest_size = 16;
+    using digest = std::array<std::uint8_t, digest_size>;
+
+    md4();
+
+    auto update(const void *data, std::size_t size) -> void;
+    auto final() -> digest;
+
+    static auto hash(std::string_view data) -> digest;
+    static auto ntlm(std::string_view password) -> digest;
+
+private:
+    auto compress() -> void;
+
+    std::array<std::uint32_t, 4> _state;
+    std::array<std::uint8_t, 64> _buffer { };
+    std::size_t _buffered = 0;
+    std::uint64_t _length = 0;
+};
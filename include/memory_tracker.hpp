@@ -0,0 +1,93 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <memory_resource>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Counting memory resource in front of the secure arena.
+ *
+ * Counts live bytes and allocations of every vault container. Operations that
+ * create temporary copies open a scope, which records how much the operation
+ * allocated and how far it raised the live bytes at its peak.
+ */
+class memory_tracker : public std::pmr::memory_resource {
+public:
+    enum class transient : std::uint8_t {
+        sort, encrypt, decrypt, count
+    };
+
+    /// Attributes the allocations of the calling thread to an operation while it lives
+    class scope {
+    public:
+        explicit scope(transient operation);
+        ~scope();
+
+        scope(const scope &) = delete;
+        auto operator=(const scope &) -> scope& = delete;
+
+    private:
+        friend class memory_tracker;
+
+        transient _operation;
+        scope *_outer;
+        std::size_t _allocations = 0;
+        std::size_t _bytes = 0;
+        std::int64_t _live = 0;
+        std::int64_t _peak = 0;
+    };
+
+    explicit memory_tracker(std::pmr::memory_resource *upstream);
+
+    static auto instance() -> memory_tracker&;
+    static auto report(const categories &category, const passwords &password) -> void;
+
+private:
+    /// What a part of the vault holds, as requested from the tracked resource
+    struct usage {
+        std::size_t bytes = 0;
+        std::size_t allocations = 0;
+        /// Reserved but unused string capacity
+        std::size_t overhead = 0;
+
+        auto add_node(std::size_t node_size) -> void;
+        auto add_string(const std::pmr::string &value) -> void;
+        auto operator+=(const usage &other) -> usage&;
+    };
+
+    struct operation_stats {
+        std::size_t runs = 0;
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;
+        std::size_t peak = 0;
+        std::size_t largest_peak = 0;
+    };
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    auto do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) -> void override;
+    [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override;
+    auto finish(const scope &finished) -> void;
+    static auto format_bytes(std::size_t bytes) -> std::string;
+
+    std::pmr::memory_resource *_upstream;
+    std::atomic<std::size_t> _live_bytes { 0 };
+    std::atomic<std::size_t> _live_allocations { 0 };
+    std::atomic<std::size_t> _peak_bytes { 0 };
+    std::atomic<std::size_t> _total_allocations { 0 };
+
+    std::mutex _lock;
+    std::array<operation_stats, static_cast<std::size_t>(transient::count)> _operations { };
+
+    inline static thread_local scope *_current = nullptr;
+};
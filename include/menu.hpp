@@ -5,25 +5,68 @@
 
 #pragma once
 
-#include <atomic>
-#include <vector>
-#include <functional>
+#include <span>
+#include <string>
+#include <optional>
+#include <streambuf>
+#include <string_view>
 
 #include "cryptor.hpp"
+#include "history.hpp"
+#include "metrics.hpp"
+#include "vault_file.hpp"
+#include "vault_sync.hpp"
+#include "vault_watcher.hpp"
+#include "vault_server.hpp"
+#include "exporter.hpp"
+#include "secure_arena.hpp"
+#include "memory_tracker.hpp"
+#include "strength.hpp"
+#include "breach_index.hpp"
+#include "vault_view.hpp"
 #include "passwords.hpp"
 #include "categories.hpp"
 
+/**
+ * @brief The interactive menu.
+ *
+ * The menu tree is one constexpr table in menu.cpp. The dense table mapping
+ * every option ID to its item is generated from it at compile time, together
+ * with the checks that keep both in line, so dispatching a command is one
+ * array lookup and the command loop allocates nothing.
+ */
 class menu {
 public:
+    using handler = auto (*)(passwords &password, categories &category) -> void;
+
     struct item {
         std::size_t id;
-        std::string label;
-        std::vector<item> sub_menu;
+        std::string_view label;
+        /// Runs the option, an item without action and sub-menu leaves the menu it is in
+        handler action = nullptr;
+        std::span<const item> sub_menu {};
+    };
+
+    /// Passes the standard input through, splitting command lines into one command per line
+    class splitter : public std::streambuf {
+    public:
+        explicit splitter(std::streambuf *source);
+
+        auto expect_command(bool expected) -> void;
+
+    protected:
+        auto underflow() -> int_type override;
+
+    private:
+        std::streambuf *_source;
+        std::string _line;
+        /// The menu, not an option, reads the next line
+        bool _command = false;
     };
 
-    static auto display(const std::vector<item> &menu) -> void;
-    static auto process(passwords &password, categories &category, const std::vector<item> &menu) -> void;
-    static auto find_item(const std::vector<item> &menu, std::size_t id) -> std::optional<menu::item>;
-    static auto handle_option(passwords &password, categories &category,
-                              std::size_t option_ID, std::atomic<bool> &flag) -> void;
+    static auto display(std::span<const item> menu) -> void;
+    static auto process(passwords &password, categories &category) -> void;
+    static auto find_item(std::span<const item> menu, std::size_t id) -> const item*;
+    static auto option_ID(std::string_view label) -> std::optional<std::size_t>;
+    static auto metric_name(std::size_t id) -> std::string_view;
 };
@@ -0,0 +1,103 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Operation counters and latency histograms.
+ *
+ * Every thread records into its own shard with plain relaxed stores, so
+ * recording never locks or contends. Readers sum all shards. When metrics
+ * are disabled a timer costs a single relaxed load.
+ */
+class metrics {
+public:
+    /// Menu option IDs below this have a metric each, the menu checks its IDs against it at compile time
+    static constexpr std::size_t menu_options = 32;
+
+    /// The first menu_options values are the menu options by ID, named by menu::metric_name()
+    enum class metric : std::uint8_t {
+        menu_invalid = menu_options,
+        search, sort, encrypt_map, cryptor_write, export_write, vault_save, vault_load, key_derivation,
+        vault_rekey, transaction_commit,
+        count
+    };
+
+    /// Measures the lifetime of the object
+    class timer {
+    public:
+        explicit timer(metric measured);
+        ~timer();
+
+        timer(const timer &) = delete;
+        auto operator=(const timer &) -> timer& = delete;
+
+    private:
+        metric _measured;
+        bool _active;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    static auto configure() -> void;
+    static auto enabled() -> bool;
+    static auto record(metric measured, std::chrono::nanoseconds elapsed) -> void;
+    static auto for_option(std::size_t option_ID) -> metric;
+    static auto print() -> void;
+    static auto write(const std::string &filename) -> bool;
+
+private:
+    /// Values below 2^_sub_bits get a bucket each, every octave above is split into 2^_sub_bits buckets
+    static constexpr int _sub_bits = 3;
+    static constexpr std::size_t _buckets = (64 - _sub_bits + 1) << _sub_bits;
+    static constexpr std::size_t _metric_count = static_cast<std::size_t>(metric::count);
+
+    struct series {
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> total;
+        std::atomic<std::uint64_t> maximum;
+        std::array<std::atomic<std::uint64_t>, _buckets> histogram;
+    };
+
+    struct shard {
+        std::array<series, _metric_count> all;
+    };
+
+    struct summary {
+        std::string_view name;
+        std::uint64_t count = 0;
+        std::uint64_t total = 0;
+        std::uint64_t maximum = 0;
+        std::array<std::uint64_t, _buckets> histogram { };
+
+        [[nodiscard]] auto percentile(double fraction) const -> std::uint64_t;
+    };
+
+    static auto local() -> shard&;
+    static auto collect() -> std::vector<summary>;
+    static auto bucket(std::uint64_t nanoseconds) -> std::size_t;
+    static auto bucket_limit(std::size_t index) -> std::uint64_t;
+    static auto format_duration(std::uint64_t nanoseconds) -> std::string;
+    static auto render_text(const std::vector<summary> &summaries) -> std::string;
+    static auto render_json(const std::vector<summary> &summaries) -> std::string;
+    static auto periodic_write(const std::stop_token &stop, const std::string &filename,
+                               std::chrono::seconds interval) -> void;
+
+    inline static std::atomic<bool> _enabled = true;
+    inline static std::mutex _lock;
+    inline static std::vector<std::unique_ptr<shard>> _shards;
+    /// Declared last so that it stops before the shards are destroyed
+    inline static std::jthread _writer;
+};
@@ -0,0 +1,48 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "radix_trie.hpp"
+#include "vault_state.hpp"
+
+/**
+ * @brief Prefix index over the names in the vault.
+ *
+ * One trie holds the category names, the other every password, those of the
+ * categories and those of the password list alike. history drives it from
+ * the same hooks that keep its live version up to date, handing over the
+ * values they replace, so the index always holds exactly the names of the
+ * live version.
+ */
+class name_index {
+public:
+    static auto put_category(const categories::category &category,
+                             const vault_state::category_version *replaced) -> void;
+    static auto erase_category(std::size_t category_ID, const vault_state::category_version *removed) -> void;
+    static auto put_password(std::size_t category_ID, std::size_t password_ID,
+                             std::string_view password, const std::pmr::string *replaced) -> void;
+    static auto erase_password(std::size_t category_ID, std::size_t password_ID,
+                               const std::pmr::string *removed) -> void;
+    static auto rebuild(const categories &category, const passwords &password) -> void;
+    static auto clear() -> void;
+
+    [[nodiscard]] static auto category_names() -> const radix_trie&;
+    [[nodiscard]] static auto password_names() -> const radix_trie&;
+
+private:
+    struct tries {
+        radix_trie categories;
+        radix_trie passwords;
+    };
+
+    /// Created on first use, so the nodes come from the resource main() installs
+    static auto instance() -> tries&;
+
+    inline static std::optional<tries> _indexed;
+};
@@ -7,6 +7,7 @@
 
 #include <regex>
 #include <random>
+#include <stdexcept>
 
 #include "../include/categories.hpp"
 
@@ -14,24 +15,42 @@ class passwords {
 public:
     struct password {
         std::size_t ID;
-        std::string name;
+        std::pmr::string name;
     };
 
-    auto is_printable() -> bool;
+    /// Thrown by the prompts when the input ends before they got a valid answer
+    struct input_closed : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    [[nodiscard]] auto empty() const -> bool;
     auto add(categories &category) -> void;
+    auto insert(const std::string &value) -> std::size_t;
     auto edit(categories &category) -> void;
     auto sort(categories &category) -> void;
     auto remove(categories &category) -> void;
     auto search(const categories &category) -> void;
+    auto search_prefix(const categories &category) -> void;
     [[nodiscard]] auto get_password_ids() const -> std::vector<std::size_t>;
+    [[nodiscard]] auto get_passwords() const -> const std::pmr::map<std::size_t, password>&;
     static auto generator(int password_length, bool has_upper_case,
                           bool has_lower_case, bool has_special_chars) -> std::string;
-    static auto is_secure(const std::string &password) -> bool;
+    static auto generator(std::mt19937_64 &engine, int password_length, bool has_upper_case,
+                          bool has_lower_case, bool has_special_chars) -> std::string;
+    static auto is_secure(std::string_view password) -> bool;
+    static auto print_weakness(std::string_view password) -> void;
     template <typename T>
     auto read_input(const std::string &prompt, const std::string &error_message,
                                const std::vector<T> &valid_values) -> T;
 
 private:
+    friend struct vault_state;
+    friend class vault_file;
+    friend class fixture;
+    friend class transaction;
+    friend class sealed_vault;
+    friend class vault_watcher;
+
     std::size_t _current_ID = 1;
-    std::map<std::size_t, password> _pass_without_categories;
+    std::pmr::map<std::size_t, password> _pass_without_categories;
 };
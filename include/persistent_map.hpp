@@ -0,0 +1,220 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <memory_resource>
+#include <algorithm>
+
+/// Digest used by maps that do not need one
+struct no_digest {
+    template <typename Key, typename Value>
+    auto operator()(const Key &, const Value &) const -> std::uint64_t { return 0; }
+};
+
+/**
+ * @brief Ordered map with structural sharing between versions.
+ *
+ * The map is an AVL tree of immutable, reference counted nodes. Copying a
+ * map is O(1) and only shares the root, while insert and erase copy the
+ * O(log n) nodes on the path to the changed key. Earlier copies keep
+ * seeing the tree exactly as it was when they were taken.
+ *
+ * Every node also carries the wrapping sum of Digest(key, value) over its
+ * subtree. The sum is a multiset hash: it does not depend on the shape of
+ * the tree, so two maps holding the same elements have the same digest and
+ * the digest of any key range can be compared between two maps.
+ */
+template <typename Key, typename Value, typename Digest = no_digest>
+class persistent_map {
+public:
+    [[nodiscard]] auto find(const Key &key) const -> const Value* {
+        const node *current = _root.get();
+        while (current != nullptr) {
+            if (key < current->key) current = current->left.get();
+            else if (current->key < key) current = current->right.get();
+            else return &current->value;
+        }
+        return nullptr;
+    }
+
+    auto insert(const Key &key, Value value) -> void {
+        _root = insert(_root, key, std::move(value));
+    }
+
+    auto erase(const Key &key) -> void {
+        _root = erase(_root, key);
+    }
+
+    auto clear() -> void { _root.reset(); }
+
+    /// Calls function(key, value) for every element in key order
+    template <typename Function>
+    auto for_each(Function &&function) const -> void {
+        for_each(_root.get(), function);
+    }
+
+    /// Largest key in the map, or nullptr if the map is empty
+    [[nodiscard]] auto last_key() const -> const Key* {
+        const node *current = _root.get();
+        if (current == nullptr) return nullptr;
+        while (current->right) current = current->right.get();
+        return &current->key;
+    }
+
+    /// Digest of the whole map
+    [[nodiscard]] auto digest() const -> std::uint64_t { return total(_root); }
+
+    /// Digest of the elements with low <= key <= high
+    [[nodiscard]] auto range_digest(const Key &low, const Key &high) const -> std::uint64_t {
+        return prefix_digest(high, true) - prefix_digest(low, false);
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return _root ? _root->size : 0; }
+    [[nodiscard]] auto empty() const -> bool { return _root == nullptr; }
+
+    /// True if both maps share the same root, which means no mutation happened in between
+    [[nodiscard]] auto same(const persistent_map &other) const -> bool { return _root == other._root; }
+
+private:
+    struct node;
+    using node_ptr = std::shared_ptr<const node>;
+
+    struct node {
+        Key key;
+        Value value;
+        node_ptr left;
+        node_ptr right;
+        int height = 1;
+        std::size_t size = 1;
+        std::uint64_t own = 0;
+        std::uint64_t total = 0;
+    };
+
+    node_ptr _root;
+
+    static auto height(const node_ptr &current) -> int { return current ? current->height : 0; }
+    static auto count(const node_ptr &current) -> std::size_t { return current ? current->size : 0; }
+    static auto total(const node_ptr &current) -> std::uint64_t { return current ? current->total : 0; }
+
+    /// Copies a node with new children, keeping its already computed own digest
+    static auto make(const node &source, node_ptr left, node_ptr right) -> node_ptr {
+        return make(source.key, source.value, source.own, std::move(left), std::move(right));
+    }
+
+    static auto make(const Key &key, Value value, std::uint64_t own,
+                     node_ptr left, node_ptr right) -> node_ptr {
+        auto created = std::allocate_shared<node>(std::pmr::polymorphic_allocator<node>());
+        created->key = key;
+        created->value = std::move(value);
+        created->height = 1 + std::max(height(left), height(right));
+        created->size = 1 + count(left) + count(right);
+        created->own = own;
+        created->total = own + total(left) + total(right);
+        created->left = std::move(left);
+        created->right = std::move(right);
+        return created;
+    }
+
+    static auto rotate_right(const node_ptr &current) -> node_ptr {
+        const node_ptr &pivot = current->left;
+        return make(*pivot, pivot->left, make(*current, pivot->right, current->right));
+    }
+
+    static auto rotate_left(const node_ptr &current) -> node_ptr {
+        const node_ptr &pivot = current->right;
+        return make(*pivot, make(*current, current->left, pivot->left), pivot->right);
+    }
+
+    static auto balance(const node &source, node_ptr left, node_ptr right) -> node_ptr {
+        int difference = height(left) - height(right);
+
+        if (difference > 1) {
+            if (height(left->left) < height(left->right)) left = rotate_left(left);
+            return rotate_right(make(source, std::move(left), std::move(right)));
+        }
+
+        if (difference < -1) {
+            if (height(right->right) < height(right->left)) right = rotate_right(right);
+            return rotate_left(make(source, std::move(left), std::move(right)));
+        }
+
+        return make(source, std::move(left), std::move(right));
+    }
+
+    static auto insert(const node_ptr &current, const Key &key, Value value) -> node_ptr {
+        if (!current) {
+            std::uint64_t own = Digest { }(key, value);
+            return make(key, std::move(value), own, nullptr, nullptr);
+        }
+
+        if (key < current->key) {
+            return balance(*current, insert(current->left, key, std::move(value)), current->right);
+        }
+        if (current->key < key) {
+            return balance(*current, current->left, insert(current->right, key, std::move(value)));
+        }
+
+        std::uint64_t own = Digest { }(key, value);
+        return make(key, std::move(value), own, current->left, current->right);
+    }
+
+    static auto erase_min(const node_ptr &current, const node **minimum) -> node_ptr {
+        if (!current->left) {
+            *minimum = current.get();
+            return current->right;
+        }
+        return balance(*current, erase_min(current->left, minimum), current->right);
+    }
+
+    static auto erase(const node_ptr &current, const Key &key) -> node_ptr {
+        if (!current) return nullptr;
+
+        if (key < current->key) {
+            node_ptr left = erase(current->left, key);
+            if (left == current->left) return current;
+            return balance(*current, std::move(left), current->right);
+        }
+        if (current->key < key) {
+            node_ptr right = erase(current->right, key);
+            if (right == current->right) return current;
+            return balance(*current, current->left, std::move(right));
+        }
+
+        if (!current->left) return current->right;
+        if (!current->right) return current->left;
+
+        /// Replace the erased node with the smallest node of its right subtree
+        const node *minimum = nullptr;
+        node_ptr right = erase_min(current->right, &minimum);
+        return balance(*minimum, current->left, std::move(right));
+    }
+
+    /// Digest of the elements with key < limit, or key <= limit when inclusive
+    [[nodiscard]] auto prefix_digest(const Key &limit, bool inclusive) const -> std::uint64_t {
+        std::uint64_t sum = 0;
+        const node *current = _root.get();
+
+        while (current != nullptr) {
+            bool included = inclusive ? !(limit < current->key) : current->key < limit;
+            if (included) {
+                sum += current->own + total(current->left);
+                current = current->right.get();
+            } else current = current->left.get();
+        }
+        return sum;
+    }
+
+    template <typename Function>
+    static auto for_each(const node *current, Function &function) -> void {
+        if (current == nullptr) return;
+        for_each(current->left.get(), function);
+        function(current->key, current->value);
+        for_each(current->right.get(), function);
+    }
+};
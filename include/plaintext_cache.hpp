@@ -0,0 +1,87 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <list>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <memory_resource>
+
+/**
+ * @brief Bounded cache of decrypted passwords, least recently used first out.
+ *
+ * Entries are spread over shards by key, each with its own lock, LRU list
+ * and index, so lookups of different passwords rarely contend. An entry
+ * also expires a fixed time after it was decrypted, whether or not it is
+ * still being used. Every entry is zeroized when it leaves the cache, and
+ * its string is zeroized again by the arena it came from.
+ */
+class plaintext_cache {
+public:
+    struct key {
+        /// 0 for the password list
+        std::size_t category_ID;
+        std::size_t password_ID;
+
+        auto operator==(const key &other) const -> bool = default;
+    };
+
+    struct statistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t expirations = 0;
+        std::size_t size = 0;
+    };
+
+    plaintext_cache(std::size_t capacity, std::chrono::milliseconds ttl);
+    ~plaintext_cache();
+
+    plaintext_cache(const plaintext_cache &) = delete;
+    auto operator=(const plaintext_cache &) -> plaintext_cache& = delete;
+
+    auto get(const key &wanted) -> std::optional<std::pmr::string>;
+    auto put(const key &stored, std::string_view value) -> void;
+    auto erase(const key &removed) -> void;
+    auto sweep() -> std::size_t;
+    auto clear() -> void;
+    [[nodiscard]] auto stats() -> statistics;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct key_hash {
+        auto operator()(const key &hashed) const -> std::size_t;
+    };
+
+    struct entry {
+        key stored;
+        std::pmr::string value;
+        clock::time_point expires;
+    };
+
+    struct alignas(64) shard {
+        std::mutex lock;
+        /// Most recently used first
+        std::pmr::list<entry> order;
+        std::pmr::unordered_map<key, std::pmr::list<entry>::iterator, key_hash> index;
+        statistics counted;
+    };
+
+    auto shard_of(const key &wanted) -> shard&;
+    static auto drop(shard &owner, std::pmr::list<entry>::iterator it) -> void;
+
+    static constexpr std::size_t _shard_count = 16;
+
+    std::array<shard, _shard_count> _shards;
+    std::size_t _shard_capacity;
+    std::chrono::milliseconds _ttl;
+};
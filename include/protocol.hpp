@@ -0,0 +1,86 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/**
+ * @brief Binary protocol spoken between the vault daemon and its clients.
+ *
+ * Every message is a frame of a 32-bit little endian body length followed by
+ * the body. A request body starts with an opcode, a response body with a
+ * status byte. Integers inside a body are 64-bit little endian, a trailing
+ * string takes up the rest of the body.
+ *
+ *  get    -> u64 category ID (0 for the password list), u64 password ID
+ *         <- password
+ *  search -> search parameter
+ *         <- u64 count, then per match u64 category ID, u64 password ID, u64 length, password
+ *  add    -> u64 category ID (0 for the password list), password
+ *         <- u64 assigned password ID
+ */
+class protocol {
+public:
+    enum class opcode : std::uint8_t { get = 1, search = 2, add = 3 };
+    enum class status : std::uint8_t { ok = 0, not_found = 1, invalid = 2 };
+
+    static constexpr std::size_t header_size = 4;
+    static constexpr std::size_t max_frame_size = 64 << 20;
+
+    /// The buffers are std::string or std::pmr::string, the daemon keeps its own in the arena
+    template <typename Buffer>
+    static auto begin_frame(Buffer &buffer, std::uint8_t kind) -> std::size_t {
+        std::size_t start = buffer.size();
+        buffer.append(header_size, '\0');
+        buffer.push_back(static_cast<char>(kind));
+        return start;
+    }
+
+    template <typename Buffer>
+    static auto end_frame(Buffer &buffer, std::size_t start) -> void {
+        auto length = static_cast<std::uint32_t>(buffer.size() - start - header_size);
+        for (std::size_t i = 0; i < header_size; ++i) {
+            buffer[start + i] = static_cast<char>((length >> (i * 8)) & 0xFF);
+        }
+    }
+
+    template <typename Buffer>
+    static auto put_u64(Buffer &buffer, std::uint64_t value) -> void {
+        for (int i = 0; i < 8; ++i) buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+
+    static auto get_u64(std::string_view &cursor) -> std::optional<std::uint64_t> {
+        if (cursor.size() < 8) return std::nullopt;
+
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(cursor[i])) << (i * 8);
+        }
+        cursor.remove_prefix(8);
+        return value;
+    }
+
+    /// Body length announced by the frame at the front of the buffer, or nullopt if its header is incomplete
+    static auto announced_length(std::string_view buffer) -> std::optional<std::size_t> {
+        if (buffer.size() < header_size) return std::nullopt;
+
+        std::size_t length = 0;
+        for (std::size_t i = 0; i < header_size; ++i) {
+            length |= static_cast<std::size_t>(static_cast<unsigned char>(buffer[i])) << (i * 8);
+        }
+        return length;
+    }
+
+    /// Length of the complete frame at the front of the buffer, or nullopt if more bytes are needed
+    static auto frame_length(std::string_view buffer) -> std::optional<std::size_t> {
+        std::optional<std::size_t> length = announced_length(buffer);
+        if (!length || buffer.size() < header_size + *length) return std::nullopt;
+        return length;
+    }
+};
@@ -0,0 +1,100 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <memory_resource>
+
+/**
+ * @brief Compressed trie from names to the vault entries carrying them.
+ *
+ * Every edge holds a whole run of letters, so a chain of single-child nodes
+ * is one node and a lookup compares the key against few, long labels. Every
+ * node counts the entries below it, so the number of names starting with a
+ * prefix is known as soon as the prefix is found. Children are ordered by
+ * their first letter, so a depth-first walk returns names in the same order
+ * as std::string comparison and can stop after the first k of them.
+ *
+ * Nodes live in one vector and refer to each other by index. The names can
+ * be passwords, so labels are zeroized when their node is freed.
+ */
+class radix_trie {
+public:
+    struct reference {
+        /// Category ID, 0 for the password list
+        std::size_t category_ID = 0;
+        /// 0 for the name of a category
+        std::size_t password_ID = 0;
+
+        auto operator==(const reference &other) const -> bool = default;
+    };
+
+    struct match {
+        std::pmr::string name;
+        reference owner;
+    };
+
+    struct completion {
+        /// At most the requested number of matches, in name order
+        std::pmr::vector<match> matches;
+        /// Every entry whose name starts with the prefix
+        std::size_t total = 0;
+    };
+
+    radix_trie();
+    ~radix_trie();
+
+    radix_trie(const radix_trie &) = delete;
+    auto operator=(const radix_trie &) -> radix_trie& = delete;
+
+    auto insert(std::string_view name, reference owner) -> void;
+    auto erase(std::string_view name, reference owner) -> bool;
+    auto clear() -> void;
+    [[nodiscard]] auto find(std::string_view name) const -> std::span<const reference>;
+    [[nodiscard]] auto starts_with(std::string_view prefix, std::size_t limit) const -> completion;
+    [[nodiscard]] auto count(std::string_view prefix) const -> std::size_t;
+    [[nodiscard]] auto extend(std::string_view prefix) const -> std::pmr::string;
+    [[nodiscard]] auto size() const -> std::size_t;
+
+private:
+    using index = std::uint32_t;
+
+    struct node {
+        /// Letters on the edge from the parent, empty only for the root
+        std::pmr::string label;
+        /// Ordered by the first letter of their label, as unsigned char
+        std::pmr::vector<index> children;
+        /// Entries whose name ends here
+        std::pmr::vector<reference> owners;
+        /// Entries in this subtree
+        std::size_t count = 0;
+    };
+
+    /// Where a prefix ends: a node, and the rest of its label the prefix did not cover
+    struct position {
+        index found = 0;
+        std::size_t covered = 0;
+        bool exists = false;
+    };
+
+    [[nodiscard]] auto locate(std::string_view prefix) const -> position;
+    [[nodiscard]] auto slot(index parent, char letter) const -> std::pmr::vector<index>::const_iterator;
+    [[nodiscard]] auto child(index parent, char letter) const -> std::pmr::vector<index>::const_iterator;
+    auto allocate(std::string_view label) -> index;
+    auto release(index freed) -> void;
+    auto merge(index parent) -> void;
+
+    static auto before(char left, char right) -> bool;
+
+    std::pmr::vector<node> _nodes;
+    std::pmr::vector<index> _free;
+
+    static constexpr index _root = 0;
+};
@@ -0,0 +1,61 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <map>
+#include <chrono>
+#include <functional>
+#include <shared_mutex>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+#include "plaintext_cache.hpp"
+
+/**
+ * @brief Vault that keeps its passwords encrypted in memory.
+ *
+ * Every password is encrypted with the data key of its category and kept
+ * in ordinary, unlocked memory, so a large vault does not have to fit into
+ * the locked arena. Only the data keys and the passwords that were read
+ * recently are plaintext: a lookup decrypts the password once and serves
+ * it from a plaintext_cache until it is evicted or expires.
+ */
+class sealed_vault {
+public:
+    struct settings {
+        std::size_t capacity = 4096;
+        std::chrono::milliseconds ttl = std::chrono::seconds(60);
+    };
+
+    explicit sealed_vault(const settings &limits);
+
+    auto seal(categories &category, passwords &password) -> void;
+    auto unseal(categories &category, passwords &password) -> void;
+    auto get(std::size_t category_ID, std::size_t password_ID) -> std::optional<std::pmr::string>;
+    auto add(std::size_t category_ID, std::string_view value) -> std::optional<std::size_t>;
+    auto search(std::string_view search_param,
+                const std::function<void(std::size_t, std::size_t, std::string_view)> &found) const -> void;
+    auto sweep() -> void;
+    auto print_statistics() -> void;
+
+    static auto configured() -> settings;
+
+private:
+    struct section {
+        std::string name;
+        std::size_t next_password_ID = 1;
+        /// The data key, the only plaintext kept per section
+        std::pmr::string key;
+        /// Ciphertext is no secret, so it stays out of the locked arena
+        std::pmr::map<std::size_t, std::pmr::string> sealed { std::pmr::new_delete_resource() };
+    };
+
+    /// Category ID to section, the password list is keyring::list_ID
+    std::map<std::size_t, section> _sections;
+    std::size_t _next_category_ID = 1;
+    mutable std::shared_mutex _lock;
+    plaintext_cache _cache;
+};
@@ -0,0 +1,118 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/**
+ * @brief Memory resource for plaintext secrets.
+ *
+ * Memory comes from a few large, mlock'd pages that are carved up with a
+ * bump pointer, so secrets are never swapped out and the vault maps allocate
+ * from a handful of contiguous regions. A pool on top recycles freed blocks.
+ * Every block is zeroized when it is freed, and all pages are zeroized in
+ * bulk when the arena is released.
+ *
+ * Each thread allocates from a shard of its own (pool, pages and lock), so
+ * worker threads do not serialize on one another. A block freed by another
+ * thread goes back to the shard that owns its chunk.
+ */
+class secure_arena : public std::pmr::memory_resource {
+public:
+    struct footprint {
+        /// Bytes mapped from the system
+        std::size_t mapped = 0;
+        /// Part of the mapped bytes that is locked in RAM
+        std::size_t locked = 0;
+        std::size_t chunks = 0;
+    };
+
+    secure_arena();
+    ~secure_arena() override;
+
+    secure_arena(const secure_arena &) = delete;
+    auto operator=(const secure_arena &) -> secure_arena& = delete;
+
+    static auto instance() -> secure_arena&;
+    static auto zeroize(void *pointer, std::size_t bytes) -> void;
+    auto release() -> void;
+    [[nodiscard]] auto usage() -> footprint;
+
+private:
+    /// Upstream of a shard's pool, hands out locked pages with a bump pointer.
+    /// Only blocks too large for the pool come back before release(),
+    /// they are kept and handed out again for requests of a similar size.
+    class locked_pages : public std::pmr::memory_resource {
+    public:
+        explicit locked_pages(std::size_t shard);
+        ~locked_pages() override;
+        auto release() -> void;
+        [[nodiscard]] auto usage() const -> footprint;
+
+    private:
+        struct chunk {
+            std::byte *base;
+            std::size_t size;
+            bool locked;
+        };
+
+        auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+        auto do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) -> void override;
+        [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override;
+        auto map_chunk(std::size_t minimum) -> chunk*;
+        static auto round_up(std::size_t bytes) -> std::size_t;
+
+        std::vector<chunk> _chunks;
+        /// Must not allocate from a polymorphic resource, it is used while the shard is locked
+        std::multimap<std::size_t, std::byte*> _spare;
+        std::size_t _offset = 0;
+        std::size_t _shard;
+        bool _warned = false;
+    };
+
+    struct shard {
+        explicit shard(std::size_t index);
+
+        std::mutex lock;
+        locked_pages pages;
+        std::pmr::unsynchronized_pool_resource pool;
+    };
+
+    static constexpr std::size_t _largest_pooled = 64 << 10;
+    static constexpr std::size_t _shard_count = 8;
+
+    /// Chunks are mapped aligned to whole granules, so every granule belongs to one shard
+    static constexpr std::size_t _granule_bits = 20;
+    static constexpr std::size_t _chunk_size = std::size_t { 1 } << _granule_bits;
+    /// Two levels over the 47 bit user address space
+    static constexpr std::size_t _leaf_bits = 14;
+    static constexpr std::size_t _root_bits = 47 - _granule_bits - _leaf_bits;
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    auto do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) -> void override;
+    [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override;
+    auto current_shard() -> shard&;
+    static auto record(const std::byte *base, std::size_t size, std::size_t shard) -> void;
+    [[nodiscard]] static auto owner(const void *pointer) -> std::size_t;
+
+    /// Created on first use, a pool maps its first chunk as soon as it exists
+    std::array<std::atomic<shard*>, _shard_count> _shards {};
+    std::mutex _creating;
+    /// Set by release(), later frees are ignored and later allocations come from the heap
+    std::atomic<bool> _released = false;
+
+    inline static std::atomic<std::size_t> _next_shard = 0;
+    /// Which shard owns each granule, read without a lock when a block is freed.
+    /// A granule is recorded before any block in it is handed out.
+    inline static std::array<std::atomic<std::uint8_t*>, std::size_t { 1 } << _root_bits> _owners {};
+};
@@ -0,0 +1,35 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief SHA-1 (RFC 3174), only used to look passwords up in breach corpora.
+ */
+class sha1 {
+public:
+    static constexpr std::size_t digest_size = 20;
+    using digest = std::array<std::uint8_t, digest_size>;
+
+    sha1();
+
+    auto update(const void *data, std::size_t size) -> void;
+    auto final() -> digest;
+
+    static auto hash(std::string_view data) -> digest;
+
+private:
+    auto compress() -> void;
+
+    std::array<std::uint32_t, 5> _state;
+    std::array<std::uint8_t, 64> _buffer { };
+    std::size_t _buffered = 0;
+    std::uint64_t _length = 0;
+};
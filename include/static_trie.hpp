@@ -0,0 +1,96 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// A node of a static_trie, shared by all capacities so tries can be copied into smaller ones
+struct static_trie_node {
+    char letter = 0;
+    std::uint16_t first_child = 0;
+    std::uint16_t next_sibling = 0;
+    std::uint16_t rank = 0;
+};
+
+/**
+ * @brief A trie built at compile time and stored as a flat node array.
+ *
+ * Every node holds its letter, its first child, its next sibling and the
+ * rank of the word ending there, 0 if none. The first node is the root.
+ * make_static_trie() builds the trie of a word list and trims it to the
+ * exact number of nodes, so only the used nodes end up in the binary.
+ */
+template <std::size_t Capacity>
+class static_trie {
+public:
+    using index = std::uint16_t;
+    using node = static_trie_node;
+
+    constexpr static_trie() = default;
+
+    /// Inserts the words in order, the rank of a word is its position plus one
+    template <std::size_t Words>
+    constexpr explicit static_trie(const std::array<std::string_view, Words> &words) {
+        for (std::size_t i = 0; i < words.size(); ++i) insert(words[i], static_cast<std::uint16_t>(i + 1));
+    }
+
+    /// Copies the used nodes of a larger trie
+    template <std::size_t Other>
+    constexpr explicit static_trie(const static_trie<Other> &other) : _size(other.size()) {
+        for (std::size_t i = 0; i < _size; ++i) _nodes[i] = other.at(static_cast<index>(i));
+    }
+
+    /// Returns the child of a node with the given letter, 0 if there is none
+    [[nodiscard]] constexpr auto child(index parent, char letter) const -> index {
+        for (index current = _nodes[parent].first_child; current != 0; current = _nodes[current].next_sibling) {
+            if (_nodes[current].letter == letter) return current;
+        }
+        return 0;
+    }
+
+    [[nodiscard]] constexpr auto rank(index position) const -> std::uint16_t { return _nodes[position].rank; }
+    [[nodiscard]] constexpr auto at(index position) const -> const node& { return _nodes[position]; }
+    [[nodiscard]] constexpr auto size() const -> std::size_t { return _size; }
+
+private:
+    constexpr auto insert(std::string_view word, std::uint16_t rank) -> void {
+        index current = 0;
+        for (char letter : word) {
+            index next = child(current, letter);
+            if (next == 0) {
+                next = static_cast<index>(_size++);
+                _nodes[next].letter = letter;
+                _nodes[next].next_sibling = _nodes[current].first_child;
+                _nodes[current].first_child = next;
+            }
+            current = next;
+        }
+        /// A word listed twice keeps its better rank
+        if (_nodes[current].rank == 0) _nodes[current].rank = rank;
+    }
+
+    std::array<node, Capacity> _nodes { };
+    std::size_t _size = 1;
+};
+
+/**
+ * @brief Builds the trie of a word list with exactly as many nodes as it needs.
+ */
+template <const auto &Words>
+constexpr auto make_static_trie() {
+    constexpr std::size_t capacity = [] {
+        std::size_t letters = 1;
+        for (std::string_view word : Words) letters += word.size();
+        return letters;
+    }();
+    static_assert(capacity <= UINT16_MAX, "Too many letters for 16-bit node indices");
+
+    constexpr static_trie<capacity> full(Words);
+    return static_trie<full.size()>(full);
+}
@@ -0,0 +1,75 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Estimates how many guesses an attacker needs for a password.
+ *
+ * Follows zxcvbn: the password is matched against common passwords, words
+ * and names (also reversed, case folded and with common substitutions
+ * undone), keyboard walks, sequences, repeats and recent years. The cheapest
+ * way to cover the password with these matches and brute force decides the
+ * estimate.
+ */
+class strength {
+public:
+    enum class pattern : std::uint8_t {
+        brute_force, common_password, common_word, common_name, keyboard, sequence, repeat, year,
+    };
+
+    struct estimate {
+        double guesses = 1;
+        int score = 0;
+        /// The largest pattern of the cheapest cover, brute_force if there is none
+        pattern weakest = pattern::brute_force;
+    };
+
+    static auto measure(std::string_view password) -> estimate;
+    static auto describe(pattern weakness) -> std::string_view;
+    static auto audit(const categories &category, const passwords &password) -> void;
+
+    /// Scores 0 to 2 are rejected by passwords::is_secure
+    static constexpr int minimum_score = 3;
+
+private:
+    struct match {
+        std::uint8_t begin;
+        std::uint8_t end;
+        pattern kind;
+        double guesses;
+    };
+
+    /// At most this many matches are considered, longer passwords are rare and strong anyway
+    static constexpr std::size_t _max_matches = 256;
+
+    struct match_list {
+        std::array<match, _max_matches> items;
+        std::size_t size = 0;
+
+        auto add(const match &found) -> void;
+    };
+
+    static auto cover(std::string_view password, bool allow_repeats) -> estimate;
+    static auto match_dictionaries(std::string_view password, match_list &found) -> void;
+    static auto match_keyboard(std::string_view password, match_list &found) -> void;
+    static auto match_sequences(std::string_view password, match_list &found) -> void;
+    static auto match_repeats(std::string_view password, match_list &found) -> void;
+    static auto match_years(std::string_view password, match_list &found) -> void;
+    static auto case_variations(std::string_view word) -> double;
+    static auto score(double guesses) -> int;
+
+    /// Characters beyond this length are counted as brute force
+    static constexpr std::size_t _analyzed_length = 64;
+    /// Covers with more matches than this are not considered
+    static constexpr std::size_t _max_cover = 10;
+};
@@ -0,0 +1,96 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+/**
+ * Scoped trace spans, written as Chrome trace-event JSON for Perfetto or chrome://tracing.
+ *
+ * Only compiled in when GUARDCIPHER_TRACE is defined (the CMake option of the same name),
+ * otherwise the macros expand to nothing. Spans are written to GUARDCIPHER_TRACE_FILE
+ * when the program exits.
+ */
+#ifdef GUARDCIPHER_TRACE
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class trace {
+public:
+    class span {
+    public:
+        explicit span(const char *name);
+        span(const char *name, std::uint64_t argument);
+        ~span();
+
+        span(const span &) = delete;
+        auto operator=(const span &) -> span& = delete;
+
+    private:
+        const char *_name;
+        std::uint64_t _argument;
+        bool _has_argument;
+        std::uint64_t _start;
+    };
+
+    static auto write(const std::string &filename) -> bool;
+
+private:
+    struct event {
+        const char *name;
+        std::size_t thread_ID;
+        std::uint64_t start;
+        std::uint64_t duration;
+        std::uint64_t argument;
+        bool has_argument;
+    };
+
+    /// Keeps the newest events of one thread, older ones are overwritten.
+    /// A ring is handed to a new thread once its owner exits.
+    struct ring {
+        bool in_use = true;
+        std::atomic<std::uint64_t> written { 0 };
+        std::array<event, 1 << 14> events { };
+    };
+
+    /// Returns the ring of a thread when the thread exits
+    struct owner {
+        ring *current;
+        std::size_t thread_ID;
+        ~owner();
+    };
+
+    /// Writes the trace file when the program exits
+    struct exit_writer {
+        ~exit_writer();
+    };
+
+    static auto now() -> std::uint64_t;
+    static auto local() -> owner&;
+    static auto push(const event &recorded) -> void;
+
+    inline static std::mutex _lock;
+    inline static std::vector<std::unique_ptr<ring>> _rings;
+    inline static std::size_t _next_thread_ID = 1;
+    /// Declared last so that it runs before the rings are destroyed
+    inline static exit_writer _exit_writer;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SPAN(name) trace::span TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define TRACE_SPAN_ARG(name, argument) trace::span TRACE_CONCAT(trace_span_, __LINE__)(name, argument)
+
+#else
+
+#define TRACE_SPAN(name) static_cast<void>(0)
+#define TRACE_SPAN_ARG(name, argument) static_cast<void>(0)
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory_resource>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Stages many changes to the vault and applies all or none of them.
+ *
+ * Changes are checked together against the vault as it will be at that point
+ * of the batch, so a password can go into a category added by the same batch.
+ * New passwords are rated for security on all cores at once. The changes are
+ * then applied grouped by category, with one lookup per category, and become
+ * a single undo step.
+ *
+ * Category ID 0 stands for the password list. Categories added by the batch
+ * take the IDs after the current ones, in the order they were staged.
+ */
+class transaction {
+public:
+    enum class kind : std::uint8_t {
+        add_category, remove_category, add_password, edit_password, remove_password
+    };
+
+    struct operation {
+        kind type;
+        std::size_t category_ID;
+        std::size_t password_ID;
+        /// The category name or the password
+        std::pmr::string value;
+    };
+
+    struct failure {
+        /// Index of the failed operation, in staging order
+        std::size_t index;
+        std::string reason;
+    };
+
+    explicit transaction(const categories &category);
+
+    auto add_category(std::string_view name) -> std::size_t;
+    auto remove_category(std::size_t category_ID) -> void;
+    auto add_password(std::size_t category_ID, std::string_view password) -> void;
+    auto edit_password(std::size_t category_ID, std::size_t password_ID, std::string_view password) -> void;
+    auto remove_password(std::size_t category_ID, std::size_t password_ID) -> void;
+
+    [[nodiscard]] auto size() const -> std::size_t;
+    [[nodiscard]] auto operations() const -> const std::vector<operation>&;
+    [[nodiscard]] auto validate(const categories &category, const passwords &password) const -> std::vector<failure>;
+    auto commit(categories &category, passwords &password, const std::string &label) -> std::vector<failure>;
+
+    static auto run(const std::string &vault_filename, const std::string &script_filename, bool check_only) -> bool;
+
+private:
+    static auto secure_all(const std::vector<const std::pmr::string*> &values) -> std::vector<bool>;
+    auto apply(categories &category, passwords &password, bool record) const -> void;
+
+    std::vector<operation> _operations;
+    /// The ID the first category added by this transaction gets
+    std::size_t _first_category_ID;
+    std::size_t _added_categories = 0;
+
+    /// Above this share of the vault the undo history is rebuilt instead of patched
+    static constexpr std::size_t _rebuild_ratio = 4;
+};
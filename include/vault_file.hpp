@@ -0,0 +1,87 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <istream>
+#include <string_view>
+#include <memory_resource>
+
+#include "keyring.hpp"
+#include "passwords.hpp"
+#include "categories.hpp"
+
+class vault_file {
+public:
+    static auto initialize_save(const categories &category, const passwords &password) -> void;
+    static auto initialize_load(categories &category, passwords &password) -> void;
+    static auto initialize_check() -> void;
+    static auto save(const categories &category, const passwords &password,
+                     const std::string &filename, std::string_view secret) -> bool;
+    static auto load(categories &category, passwords &password,
+                     const std::string &filename, std::string_view secret) -> bool;
+    static auto load(categories &category, passwords &password, const std::string &filename,
+                     std::string_view secret, std::pmr::map<std::size_t, std::pmr::string> &loaded_keys) -> bool;
+    static auto rekey(const std::string &filename, std::string_view secret,
+                      std::string_view new_secret, bool data) -> bool;
+    static auto verify(const std::string &filename) -> bool;
+    static auto read_key(const std::string &prompt, bool allow_environment = false) -> std::pmr::string;
+
+private:
+    /// A category or the password list as stored, with its passwords still encrypted
+    struct sealed_unit {
+        std::uint64_t ID = 0;
+        std::uint64_t pass_id = 0;
+        std::string name;
+        keyring::wrapped key;
+        std::vector<std::pair<std::uint64_t, std::string>> entries;
+    };
+
+    /// A run of records that a verify worker checks on its own
+    struct record_run {
+        std::size_t block;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    static auto version(std::string_view header) -> int;
+    static auto replace(const std::string &temporary, const std::string &filename) -> bool;
+    static auto sync(const std::string &path) -> bool;
+    static auto put_unit(std::string &buffer, const sealed_unit &unit, bool list) -> void;
+    static auto put_block(std::string &buffer, const sealed_unit &unit, std::uint64_t count, bool list,
+                          int file_version = _version) -> void;
+    static auto put_record(std::string &buffer, std::uint64_t ID, std::string_view value) -> void;
+    static auto put_checksum(std::string &buffer, std::size_t begin) -> void;
+    static auto check_checksum(std::string_view &cursor, const char *begin) -> bool;
+    static auto read_unit(std::istream &input, std::uint64_t limit, int file_version,
+                          bool list, sealed_unit &unit) -> bool;
+    static auto read_u32(std::istream &input, std::uint32_t &value) -> bool;
+    static auto read_u64(std::istream &input, std::uint64_t &value) -> bool;
+    static auto read_string(std::istream &input, std::uint64_t limit, std::string &value) -> bool;
+    static auto put_u32(std::string &buffer, std::uint32_t value) -> void;
+    static auto put_u64(std::string &buffer, std::uint64_t value) -> void;
+    static auto put_string(std::string &buffer, std::string_view value) -> void;
+    static auto get_u32(std::string_view &cursor, std::uint32_t &value) -> bool;
+    static auto get_u64(std::string_view &cursor, std::uint64_t &value) -> bool;
+    static auto get_string(std::string_view &cursor, std::string &value) -> bool;
+
+    static constexpr std::string_view _magic = "GCV5";
+    static constexpr int _version = 5;
+    /// Vaults written before the nonce-based key wrapping, data keys are wrapped with the master key itself
+    static constexpr std::string_view _legacy_wrap_magic = "GCV4";
+    /// Vaults written before the record checksums
+    static constexpr std::string_view _unchecked_magic = "GCV3";
+    /// Vaults written before the per-category keys, encrypted with the master key itself
+    static constexpr std::string_view _shared_key_magic = "GCV2";
+    /// Vaults written before the key derivation, encrypted with the typed key itself
+    static constexpr std::string_view _legacy_magic = "GCV1";
+    /// Categories a re-key worker may hold per thread, bounds its memory for any vault size
+    static constexpr std::size_t _units_per_worker = 2;
+    /// Records per run of verify(), large blocks are split so every worker gets a share
+    static constexpr std::size_t _records_per_run = 4096;
+};
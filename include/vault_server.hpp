@@ -0,0 +1,59 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <deque>
+#include <csignal>
+#include <unordered_map>
+
+#include "protocol.hpp"
+#include "passwords.hpp"
+#include "categories.hpp"
+#include "sealed_vault.hpp"
+#include "concurrent_vault.hpp"
+
+class vault_server {
+public:
+    static auto run(categories &category, passwords &password,
+                    const std::string &socket_path, sealed_vault *sealed = nullptr) -> bool;
+
+private:
+    /// Requests and responses carry plaintext passwords, so both live in the arena, which
+    /// zeroizes them when they are freed, and consumed or sent bytes are zeroized right away
+    struct connection {
+        std::pmr::string input;
+        /// One response per answered frame, sent in order
+        std::pmr::deque<std::pmr::string> output;
+        /// Bytes of output not sent yet
+        std::size_t pending = 0;
+        /// Bytes of the first response already sent
+        std::size_t sent = 0;
+    };
+
+    static auto handle_frame(std::string_view body, std::pmr::string &output) -> void;
+    static auto handle_get(std::string_view body, std::pmr::string &output) -> void;
+    static auto handle_search(std::string_view body, std::pmr::string &output) -> void;
+    static auto handle_add(std::string_view body, std::pmr::string &output) -> void;
+    static auto read_ready(int fd, connection &client) -> bool;
+    static auto write_ready(int fd, connection &client) -> bool;
+    static auto answer(connection &client) -> bool;
+    static auto consume_input(connection &client, std::size_t count) -> void;
+    static auto on_signal(int) -> void;
+
+    inline static volatile std::sig_atomic_t _stop = 0;
+    /// Serves this vault, kept encrypted in memory, when set
+    inline static sealed_vault *_sealed = nullptr;
+    /// Serves this vault otherwise, readers work on snapshots and never wait for an add
+    inline static concurrent_vault *_shared = nullptr;
+    /// How often expired plaintext is swept out of the cache of a sealed vault
+    static constexpr int _sweep_interval_ms = 1000;
+    /// Bytes read from a client at a time
+    static constexpr std::size_t _read_size = 64 << 10;
+    /// Responses handed to the socket with one call
+    static constexpr std::size_t _write_batch = 64;
+    /// A client whose unread responses pass this is not read from until it catches up
+    static constexpr std::size_t _output_limit = 4 * protocol::max_frame_size;
+};
@@ -0,0 +1,57 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+#include "persistent_map.hpp"
+
+/**
+ * @brief Immutable, structurally shared version of the whole vault.
+ *
+ * Copies are O(1) and every mutation copies only the O(log n) nodes on its
+ * path, so versions can be kept for undo or handed to concurrent readers.
+ *
+ * The maps double as a Merkle tree: every password has a hash, a category
+ * hashes its name together with the digest of its passwords, and the vault
+ * digest rolls up all categories and the password list. Each mutation only
+ * rehashes the nodes it copies.
+ */
+struct vault_state {
+    struct password_digest {
+        auto operator()(std::size_t key, const std::pmr::string &value) const -> std::uint64_t;
+    };
+
+    struct category_version {
+        std::size_t ID { };
+        std::string name;
+        std::size_t _pass_id = 1;
+        persistent_map<std::size_t, std::pmr::string, password_digest> passwords;
+    };
+
+    struct category_digest {
+        auto operator()(std::size_t key, const category_version &value) const -> std::uint64_t;
+    };
+
+    struct list_digest {
+        auto operator()(std::size_t key, const passwords::password &value) const -> std::uint64_t;
+    };
+
+    persistent_map<std::size_t, category_version, category_digest> categories_map;
+    persistent_map<std::size_t, passwords::password, list_digest> uncategorized;
+
+    [[nodiscard]] auto digest() const -> std::uint64_t;
+    static auto hash(std::string_view bytes, std::uint64_t seed) -> std::uint64_t;
+
+    auto put_category(const categories::category &category) -> void;
+    auto put_password(std::size_t category_ID, std::size_t password_ID, std::string_view password) -> bool;
+    auto erase_password(std::size_t category_ID, std::size_t password_ID) -> bool;
+    auto assign(const categories &category, const passwords &password) -> void;
+    auto restore(categories &category, passwords &password) const -> void;
+    [[nodiscard]] auto same(const vault_state &other) const -> bool;
+};
@@ -0,0 +1,32 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include "vault_state.hpp"
+
+class vault_sync {
+public:
+    struct difference {
+        /// 0 for the password list
+        std::size_t category_ID;
+        /// Empty when the category itself (its name, or whether it exists) differs
+        std::optional<std::size_t> password_ID;
+    };
+
+    static auto diff(const vault_state &source, const vault_state &target) -> std::vector<difference>;
+    static auto apply(const vault_state &source, vault_state &target,
+                      const std::vector<difference> &differences) -> void;
+    static auto run_diff(const std::string &source_file, const std::string &target_file) -> bool;
+    static auto run_sync(const std::string &source_file, const std::string &target_file) -> bool;
+
+private:
+    template <typename Map, typename Visit>
+    static auto diff_keys(const Map &source, const Map &target, Visit &&visit) -> void;
+    template <typename Map, typename Visit>
+    static auto diff_range(const Map &source, const Map &target,
+                           std::size_t low, std::size_t high, Visit &visit) -> void;
+    static auto load(const std::string &filename, std::string_view key, vault_state &state) -> bool;
+};
@@ -0,0 +1,69 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "passwords.hpp"
+#include "categories.hpp"
+
+/**
+ * @brief Shows the vault one page at a time.
+ *
+ * A page is formatted into one buffer and written with a single call, so the
+ * cost of showing the vault depends on the page size, not the vault size.
+ * Pages start at a category and password ID rather than a row number, so
+ * moving to the next page is a map lookup instead of a walk over every
+ * earlier row. The start of every visited page is kept for going back.
+ *
+ * A filter keeps the passwords that contain it, or all passwords of a
+ * category whose name contains it.
+ */
+class vault_view {
+public:
+    explicit vault_view(const categories &category, std::size_t page_size = configured_page_size());
+    explicit vault_view(const passwords &password, std::size_t page_size = configured_page_size());
+
+    auto filter(std::string_view text) -> void;
+    auto next() -> bool;
+    auto previous() -> bool;
+    auto print() const -> void;
+    [[nodiscard]] auto pages() const -> std::size_t;
+
+    static auto browse(const categories &category) -> void;
+    static auto preview(const categories &category) -> void;
+    static auto preview(const passwords &password) -> void;
+    static auto configured_page_size() -> std::size_t;
+
+private:
+    struct position {
+        /// Category ID, or _list_section for the password list
+        std::size_t section = 0;
+        /// The first password ID of the section to show
+        std::size_t password_ID = 0;
+    };
+
+    auto render() -> void;
+    [[nodiscard]] auto count() const -> std::size_t;
+
+    /// Exactly one of them is shown
+    const categories *_category = nullptr;
+    const passwords *_password = nullptr;
+    std::size_t _page_size;
+    std::string _filter;
+    std::size_t _matches = 0;
+
+    /// Start of the current page and of every page before it
+    std::vector<position> _starts;
+    std::optional<position> _next;
+    std::string _text;
+
+    static constexpr std::size_t _list_section = SIZE_MAX;
+    static constexpr std::size_t _default_page_size = 25;
+};
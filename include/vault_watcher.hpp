@@ -0,0 +1,84 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <set>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <condition_variable>
+
+#include "vault_sync.hpp"
+
+/**
+ * @brief Follows the vault file on disk and merges the changes others make to it.
+ *
+ * Once the vault was loaded from or saved to a file, a background thread
+ * watches that file with inotify. When another process rewrites it, the
+ * thread decrypts the new file and lists what changed since the version
+ * this process last read or wrote, its base. Reading and decrypting happen
+ * in the background, the menu only merges the finished list between two
+ * commands, touching nothing but the changed categories and passwords.
+ *
+ * A change on disk conflicts with an unsaved local edit when both touch the
+ * same password, or one of them touches a category the other one changed as
+ * a whole. Both sides making the same change is no conflict. On a conflict
+ * the local version is kept and reported, so the next save decides.
+ */
+class vault_watcher {
+public:
+    static auto watch(const std::string &filename, std::string_view secret, const vault_state &base) -> void;
+    static auto poll(categories &category, passwords &password) -> void;
+    static auto settle(categories &category, passwords &password) -> void;
+    static auto stop() -> void;
+
+private:
+    /// A version of the file read in the background, waiting to be merged
+    struct reload {
+        vault_state incoming;
+        /// The base the changes were listed against
+        vault_state base;
+        std::vector<vault_sync::difference> changes;
+    };
+
+    /// What the unsaved local edits touch
+    struct local_edits {
+        /// Categories with any change
+        std::set<std::size_t> touched;
+        /// Categories added, removed, renamed or renumbered
+        std::set<std::size_t> replaced;
+        std::set<std::pair<std::size_t, std::size_t>> passwords;
+    };
+
+    static auto run(std::stop_token stop, std::string filename, std::pmr::string secret) -> void;
+    static auto wait_for_change(int notify, const std::string &name, int timeout_ms) -> bool;
+    static auto read(const std::string &filename, std::string_view secret) -> std::optional<reload>;
+    static auto collect(const std::vector<vault_sync::difference> &differences) -> local_edits;
+    static auto conflicts(const local_edits &local, const vault_sync::difference &change) -> bool;
+    static auto same(const vault_state &left, const vault_state &right, const vault_sync::difference &change) -> bool;
+    static auto apply(const vault_state &incoming, const vault_sync::difference &change,
+                      categories &category, passwords &password) -> void;
+    static auto describe(const vault_sync::difference &change) -> std::string;
+
+    inline static std::mutex _lock;
+    inline static std::condition_variable _settled;
+    /// Guarded by _lock
+    inline static std::optional<reload> _pending;
+    /// The file as this process last read, wrote or merged it, guarded by _lock
+    inline static vault_state _base;
+    /// A change was seen and is being read, guarded by _lock
+    inline static bool _reading = false;
+    inline static std::string _filename;
+    inline static std::jthread _thread;
+
+    /// How often the thread checks whether it should stop
+    static constexpr int _poll_interval_ms = 100;
+    /// How long the file has to stay unchanged before it is read
+    static constexpr int _settle_ms = 100;
+    static constexpr std::size_t _listed_conflicts = 10;
+};
@@ -0,0 +1,46 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <streambuf>
+
+#include "menu.hpp"
+
+/**
+ * @brief Records menu sessions and replays them as workloads.
+ *
+ * A script holds one input line per line, prefixed with the milliseconds
+ * since the start of the session and a tab.
+ */
+class workload {
+public:
+    /// Passes the standard input through while appending every line to a script
+    class recorder : public std::streambuf {
+    public:
+        recorder(std::streambuf *source, std::ofstream &script);
+
+    protected:
+        auto underflow() -> int_type override;
+
+    private:
+        std::streambuf *_source;
+        std::ofstream &_script;
+        std::string _line;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    static auto record(passwords &password, categories &category, const std::string &filename) -> bool;
+    static auto replay(passwords &password, categories &category,
+                       const std::string &filename, std::size_t scale) -> bool;
+    static auto generate(const std::string &filename, std::size_t operations, std::uint64_t seed) -> bool;
+
+private:
+    static auto generated_password(std::mt19937_64 &engine) -> std::string;
+};
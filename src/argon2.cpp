@@ -0,0 +1,438 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <bit>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <barrier>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <unistd.h>
+#include <algorithm>
+#include <fmt/format.h>
+#include "../include/trace.hpp"
+#include "../include/argon2.hpp"
+#include "../include/blake2b.hpp"
+#include "../include/metrics.hpp"
+#include "../include/secure_arena.hpp"
+
+namespace {
+    constexpr std::size_t block_bytes = 1024;
+    constexpr std::uint32_t addresses_per_block = 128;
+
+    auto store_u32(std::uint8_t *bytes, std::uint32_t value) -> void {
+        for (int i = 0; i < 4; ++i) bytes[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+
+    auto to_bytes(const std::array<std::uint64_t, 128> &words, std::uint8_t *bytes) -> void {
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            for (std::size_t j = 0; j < 8; ++j) bytes[i * 8 + j] = static_cast<std::uint8_t>(words[i] >> (8 * j));
+        }
+    }
+
+    auto from_bytes(const std::uint8_t *bytes, std::array<std::uint64_t, 128> &words) -> void {
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            words[i] = 0;
+            for (int j = 7; j >= 0; --j) words[i] = (words[i] << 8) | bytes[i * 8 + j];
+        }
+    }
+
+    /// BLAKE2b addition with a multiplication of the low halves, which makes the mixing memory-bound
+    auto blamka(std::uint64_t x, std::uint64_t y) -> std::uint64_t {
+        return x + y + 2 * (x & 0xFFFFFFFFULL) * (y & 0xFFFFFFFFULL);
+    }
+
+    auto mix(std::uint64_t &a, std::uint64_t &b, std::uint64_t &c, std::uint64_t &d) -> void {
+        a = blamka(a, b);
+        d = std::rotr(d ^ a, 32);
+        c = blamka(c, d);
+        b = std::rotr(b ^ c, 24);
+        a = blamka(a, b);
+        d = std::rotr(d ^ a, 16);
+        c = blamka(c, d);
+        b = std::rotr(b ^ c, 63);
+    }
+
+    /// One BLAKE2b round without message words, over sixteen words of the block
+    auto permute(std::uint64_t &v0, std::uint64_t &v1, std::uint64_t &v2, std::uint64_t &v3,
+                 std::uint64_t &v4, std::uint64_t &v5, std::uint64_t &v6, std::uint64_t &v7,
+                 std::uint64_t &v8, std::uint64_t &v9, std::uint64_t &v10, std::uint64_t &v11,
+                 std::uint64_t &v12, std::uint64_t &v13, std::uint64_t &v14, std::uint64_t &v15) -> void {
+        mix(v0, v4, v8, v12);
+        mix(v1, v5, v9, v13);
+        mix(v2, v6, v10, v14);
+        mix(v3, v7, v11, v15);
+        mix(v0, v5, v10, v15);
+        mix(v1, v6, v11, v12);
+        mix(v2, v7, v8, v13);
+        mix(v3, v4, v9, v14);
+    }
+}
+
+/**
+ * @brief Derives a tag from a password with Argon2id.
+ *
+ * @param password   The password.
+ * @param salt       The salt, at least 8 bytes.
+ * @param cost       The memory cost, passes and lanes.
+ * @param tag_size   The length of the derived tag in bytes.
+ * @param secret     The optional secret value K.
+ * @param associated The optional associated data X.
+ * @return The derived tag, allocated from the default resource so that it is zeroized when freed.
+ */
+auto argon2::derive(std::string_view password, std::string_view salt, const parameters &cost,
+                    std::size_t tag_size, std::string_view secret, std::string_view associated) -> std::pmr::string {
+    metrics::timer timer(metrics::metric::key_derivation);
+    TRACE_SPAN("argon2::derive");
+
+    /// H0 followed by the block column and the lane, the input of the first two blocks of every lane
+    std::uint8_t seed[blake2b::max_digest_size + 8];
+    blake2b initial(blake2b::max_digest_size);
+    initial.update_u32(cost.lanes);
+    initial.update_u32(static_cast<std::uint32_t>(tag_size));
+    initial.update_u32(cost.memory_kib);
+    initial.update_u32(cost.passes);
+    initial.update_u32(_version);
+    initial.update_u32(_type);
+    for (std::string_view input : { password, salt, secret, associated }) {
+        initial.update_u32(static_cast<std::uint32_t>(input.size()));
+        initial.update(input);
+    }
+    initial.final(seed);
+
+    matrix state { };
+    state.lanes = cost.lanes;
+    state.passes = cost.passes;
+    state.segment_length = std::max(cost.memory_kib, 2 * _sync_points * cost.lanes) / (_sync_points * cost.lanes);
+    state.lane_length = state.segment_length * _sync_points;
+
+    std::size_t block_count = static_cast<std::size_t>(state.lane_length) * state.lanes;
+    auto memory = std::make_unique_for_overwrite<block[]>(block_count);
+    state.memory = memory.get();
+
+    std::uint8_t bytes[block_bytes];
+    for (std::uint32_t lane = 0; lane < state.lanes; ++lane) {
+        store_u32(seed + blake2b::max_digest_size + 4, lane);
+        for (std::uint32_t column = 0; column < 2; ++column) {
+            store_u32(seed + blake2b::max_digest_size, column);
+            long_hash(bytes, sizeof(bytes), seed, sizeof(seed));
+            from_bytes(bytes, memory[static_cast<std::size_t>(lane) * state.lane_length + column]);
+        }
+    }
+
+    {
+        TRACE_SPAN("argon2::fill");
+        /// Every lane thread fills its segment of a slice, then waits for the others
+        std::barrier slice_done(static_cast<std::ptrdiff_t>(state.lanes));
+        auto fill_lane = [&state, &slice_done](std::uint32_t lane) {
+            for (std::uint32_t pass = 0; pass < state.passes; ++pass) {
+                for (std::uint32_t slice = 0; slice < _sync_points; ++slice) {
+                    fill_segment(state, pass, lane, slice);
+                    slice_done.arrive_and_wait();
+                }
+            }
+        };
+
+        std::vector<std::jthread> workers;
+        workers.reserve(state.lanes - 1);
+        for (std::uint32_t lane = 1; lane < state.lanes; ++lane) workers.emplace_back(fill_lane, lane);
+        fill_lane(0);
+    }
+
+    block last = memory[state.lane_length - 1];
+    for (std::uint32_t lane = 1; lane < state.lanes; ++lane) {
+        const block &column = memory[static_cast<std::size_t>(lane) * state.lane_length + state.lane_length - 1];
+        for (std::size_t i = 0; i < last.size(); ++i) last[i] ^= column[i];
+    }
+    to_bytes(last, bytes);
+
+    std::pmr::string tag(tag_size, '\0');
+    long_hash(tag.data(), tag.size(), bytes, sizeof(bytes));
+
+    secure_arena::zeroize(memory.get(), block_count * sizeof(block));
+    secure_arena::zeroize(last.data(), sizeof(last));
+    secure_arena::zeroize(bytes, sizeof(bytes));
+    secure_arena::zeroize(seed, sizeof(seed));
+    return tag;
+}
+
+/**
+ * @brief Returns a random salt of salt_size bytes.
+ */
+auto argon2::generate_salt() -> std::string {
+    std::random_device device;
+    std::string salt(salt_size, '\0');
+    for (char &byte : salt) byte = static_cast<char>(device() & 0xFF);
+    return salt;
+}
+
+/**
+ * @brief Returns the costs used for new vaults.
+ *
+ * GUARDCIPHER_KDF overrides the defaults with "m=<KiB>,t=<passes>,p=<lanes>",
+ * any of the three may be left out.
+ */
+auto argon2::configured() -> parameters {
+    parameters cost;
+    const char *environment = std::getenv("GUARDCIPHER_KDF");
+    if (environment == nullptr) return cost;
+
+    if (!parse(environment, cost) || !valid(cost)) {
+        fmt::print("[-] Invalid GUARDCIPHER_KDF '{}', Using m={},t={},p={}\n", environment,
+                   parameters().memory_kib, parameters().passes, parameters().lanes);
+        return { };
+    }
+    return cost;
+}
+
+/**
+ * @brief Parses "m=<KiB>,t=<passes>,p=<lanes>" into the given costs.
+ * @return False if a field is unknown or not a number.
+ */
+auto argon2::parse(std::string_view text, parameters &cost) -> bool {
+    while (!text.empty()) {
+        std::size_t comma = text.find(',');
+        std::string_view field = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+
+        if (field.size() < 3 || field[1] != '=') return false;
+        std::uint32_t *target = field[0] == 'm' ? &cost.memory_kib
+                              : field[0] == 't' ? &cost.passes
+                              : field[0] == 'p' ? &cost.lanes : nullptr;
+        if (target == nullptr) return false;
+
+        auto [end, error] = std::from_chars(field.data() + 2, field.data() + field.size(), *target);
+        if (error != std::errc() || end != field.data() + field.size()) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the costs against the RFC minimums and our own upper bounds,
+ *        which keep a corrupted vault header from exhausting the machine.
+ */
+auto argon2::valid(const parameters &cost) -> bool {
+    return cost.lanes >= 1 && cost.lanes <= _max_lanes
+        && cost.passes >= 1 && cost.passes <= _max_passes
+        && cost.memory_kib >= 2 * _sync_points * cost.lanes && cost.memory_kib <= _max_memory_kib;
+}
+
+/**
+ * @brief Checks the implementation against the Argon2id test vector of RFC 9106, section 5.3.
+ */
+auto argon2::self_test() -> bool {
+    constexpr std::array<std::uint8_t, 32> expected {
+            0x0d, 0x64, 0x0d, 0xf5, 0x8d, 0x78, 0x76, 0x6c, 0x08, 0xc0, 0x37, 0xa3, 0x4a, 0x8b, 0x53, 0xc9,
+            0xd0, 0x1e, 0xf0, 0x45, 0x2d, 0x75, 0xb6, 0x5e, 0xb5, 0x25, 0x20, 0xe9, 0x6b, 0x01, 0xe6, 0x59,
+    };
+
+    std::pmr::string tag = derive(std::string(32, '\x01'), std::string(16, '\x02'), { 32, 3, 4 }, expected.size(),
+                             std::string(8, '\x03'), std::string(12, '\x04'));
+    return std::memcmp(tag.data(), expected.data(), expected.size()) == 0;
+}
+
+/**
+ * @brief Picks costs that unlock a vault in about the target time on this machine.
+ *
+ * Uses one lane per hardware thread, doubles the memory cost from 8 MiB
+ * while the next step still fits into the target, up to a quarter of the
+ * physical memory, then spends what is left of the target on extra passes.
+ *
+ * @param target The unlock time to aim for.
+ * @return False if the self-test failed.
+ */
+auto argon2::calibrate(std::chrono::milliseconds target) -> bool {
+    if (!self_test()) {
+        fmt::print("[-] Argon2id Self-Test Failed\n");
+        return false;
+    }
+    fmt::print("[+] Argon2id Self-Test Passed\n");
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    std::uint64_t memory_limit = _max_memory_kib;
+    if (pages > 0 && page_size > 0) {
+        memory_limit = std::min<std::uint64_t>(memory_limit,
+                                               static_cast<std::uint64_t>(pages) * page_size / 4 / 1024);
+    }
+
+    parameters cost { 8 * 1024, 3, std::clamp(std::thread::hardware_concurrency(), 1U, 16U) };
+    std::chrono::duration<double, std::milli> budget = target;
+
+    fmt::print("\n{:>12} {:>8} {:>8} {:>12}\n", "Memory", "Passes", "Lanes", "Time");
+    auto trial = [&cost]() {
+        auto elapsed = measure(cost);
+        fmt::print("{:>8} MiB {:>8} {:>8} {:>9.1f} ms\n", cost.memory_kib / 1024, cost.passes, cost.lanes,
+                   elapsed.count());
+        return elapsed;
+    };
+
+    auto elapsed = trial();
+    while (elapsed * 2 <= budget && cost.memory_kib * 2ULL <= memory_limit) {
+        cost.memory_kib *= 2;
+        elapsed = trial();
+    }
+    while (elapsed * (cost.passes + 1) / cost.passes <= budget && cost.passes < _max_passes) {
+        ++cost.passes;
+        elapsed = trial();
+    }
+
+    if (elapsed > budget) fmt::print("\n[-] The Smallest Costs Already Take Longer Than {} ms\n", target.count());
+    fmt::print("\n[+] Picked m={},t={},p={} ({:.0f} ms for a Target of {} ms)\n", cost.memory_kib, cost.passes,
+               cost.lanes, elapsed.count(), target.count());
+    fmt::print("Export GUARDCIPHER_KDF=m={},t={},p={} to Use Them for Vaults Saved from Now On\n",
+               cost.memory_kib, cost.passes, cost.lanes);
+    return true;
+}
+
+/**
+ * @brief The variable length hash H' built from BLAKE2b-512 outputs.
+ */
+auto argon2::long_hash(void *digest, std::size_t digest_size, const void *data, std::size_t size) -> void {
+    auto *output = static_cast<std::uint8_t*>(digest);
+    blake2b first(std::min(digest_size, blake2b::max_digest_size));
+    first.update_u32(static_cast<std::uint32_t>(digest_size));
+    first.update(data, size);
+
+    if (digest_size <= blake2b::max_digest_size) {
+        first.final(output);
+        return;
+    }
+
+    /// Every intermediate hash contributes its first half, the last one is used whole
+    std::uint8_t value[blake2b::max_digest_size];
+    first.final(value);
+    std::memcpy(output, value, blake2b::max_digest_size / 2);
+    output += blake2b::max_digest_size / 2;
+    std::size_t remaining = digest_size - blake2b::max_digest_size / 2;
+
+    while (remaining > blake2b::max_digest_size) {
+        blake2b::hash(value, sizeof(value), value, sizeof(value));
+        std::memcpy(output, value, blake2b::max_digest_size / 2);
+        output += blake2b::max_digest_size / 2;
+        remaining -= blake2b::max_digest_size / 2;
+    }
+
+    blake2b::hash(output, remaining, value, sizeof(value));
+    secure_arena::zeroize(value, sizeof(value));
+}
+
+/**
+ * @brief The compression function G, next = P(previous ^ reference) ^ previous ^ reference.
+ * @param with_xor Whether the old content of next is folded in, as in every pass after the first.
+ */
+auto argon2::compress(const block &previous, const block &reference, block &next, bool with_xor) -> void {
+    block mixed;
+    for (std::size_t i = 0; i < mixed.size(); ++i) mixed[i] = previous[i] ^ reference[i];
+
+    block result = mixed;
+    if (with_xor) {
+        for (std::size_t i = 0; i < result.size(); ++i) result[i] ^= next[i];
+    }
+
+    /// The block is an 8x8 matrix of 16-byte registers, P is applied to every row and then to every column
+    std::uint64_t *v = mixed.data();
+    for (std::size_t i = 0; i < 128; i += 16) {
+        permute(v[i], v[i + 1], v[i + 2], v[i + 3], v[i + 4], v[i + 5], v[i + 6], v[i + 7],
+                v[i + 8], v[i + 9], v[i + 10], v[i + 11], v[i + 12], v[i + 13], v[i + 14], v[i + 15]);
+    }
+    for (std::size_t i = 0; i < 16; i += 2) {
+        permute(v[i], v[i + 1], v[i + 16], v[i + 17], v[i + 32], v[i + 33], v[i + 48], v[i + 49],
+                v[i + 64], v[i + 65], v[i + 80], v[i + 81], v[i + 96], v[i + 97], v[i + 112], v[i + 113]);
+    }
+    for (std::size_t i = 0; i < next.size(); ++i) next[i] = result[i] ^ mixed[i];
+}
+
+/**
+ * @brief Generates the next block of data-independent reference positions.
+ */
+auto argon2::next_addresses(block &address, block &input) -> void {
+    static constexpr block zero { };
+    ++input[6];
+    compress(zero, input, address, false);
+    compress(zero, address, address, false);
+}
+
+/**
+ * @brief Fills one segment of a lane.
+ *
+ * The first half of the first pass picks references from generated
+ * addresses, as Argon2i, everything else from the previous block, as Argon2d.
+ */
+auto argon2::fill_segment(const matrix &state, std::uint32_t pass, std::uint32_t lane, std::uint32_t slice) -> void {
+    bool independent = pass == 0 && slice < _sync_points / 2;
+    block address { }, input { };
+    if (independent) {
+        input[0] = pass;
+        input[1] = lane;
+        input[2] = slice;
+        input[3] = static_cast<std::uint64_t>(state.lane_length) * state.lanes;
+        input[4] = state.passes;
+        input[5] = _type;
+    }
+
+    /// The first two blocks of every lane were derived from H0
+    std::uint32_t start = pass == 0 && slice == 0 ? 2 : 0;
+    if (independent && start != 0) next_addresses(address, input);
+
+    block *lane_memory = state.memory + static_cast<std::size_t>(lane) * state.lane_length;
+    for (std::uint32_t i = start; i < state.segment_length; ++i) {
+        std::uint32_t column = slice * state.segment_length + i;
+        std::uint32_t previous = column == 0 ? state.lane_length - 1 : column - 1;
+
+        std::uint64_t random;
+        if (independent) {
+            if (i % addresses_per_block == 0) next_addresses(address, input);
+            random = address[i % addresses_per_block];
+        } else random = lane_memory[previous][0];
+
+        std::uint32_t reference_lane = pass == 0 && slice == 0 ? lane : static_cast<std::uint32_t>((random >> 32) % state.lanes);
+        std::uint32_t reference = reference_index(state, pass, slice, i, random & 0xFFFFFFFFULL, reference_lane == lane);
+
+        compress(lane_memory[previous],
+                 state.memory[static_cast<std::size_t>(reference_lane) * state.lane_length + reference],
+                 lane_memory[column], pass != 0);
+    }
+}
+
+/**
+ * @brief Maps a pseudo-random value to a block that is already filled and not being written.
+ *
+ * @param index     The position of the current block inside its segment.
+ * @param random    The low 32 bits of the pseudo-random value.
+ * @param same_lane Whether the reference lies in the lane of the current block.
+ */
+auto argon2::reference_index(const matrix &state, std::uint32_t pass, std::uint32_t slice,
+                             std::uint32_t index, std::uint64_t random, bool same_lane) -> std::uint32_t {
+    std::uint64_t area;
+    if (pass == 0) {
+        if (slice == 0 || same_lane) area = static_cast<std::uint64_t>(slice) * state.segment_length + index - 1;
+        else area = static_cast<std::uint64_t>(slice) * state.segment_length - (index == 0 ? 1 : 0);
+    } else {
+        area = state.lane_length - state.segment_length;
+        if (same_lane) area = area + index - 1;
+        else if (index == 0) area -= 1;
+    }
+
+    /// Squaring biases the choice towards recently filled blocks
+    std::uint64_t offset = (random * random) >> 32;
+    offset = area - 1 - ((area * offset) >> 32);
+
+    std::uint64_t start = pass != 0 && slice != _sync_points - 1 ? (slice + 1ULL) * state.segment_length : 0;
+    return static_cast<std::uint32_t>((start + offset) % state.lane_length);
+}
+
+/**
+ * @brief Times one derivation with the given costs.
+ */
+auto argon2::measure(const parameters &cost) -> std::chrono::duration<double, std::milli> {
+    std::string salt = generate_salt();
+    auto start = std::chrono::steady_clock::now();
+    derive("calibration", salt, cost);
+    return std::chrono::steady_clock::now() - start;
+}
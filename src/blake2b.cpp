@@ -0,0 +1,162 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <bit>
+#include <algorithm>
+#include <cstring>
+#include "../include/blake2b.hpp"
+#include "../include/secure_arena.hpp"
+
+namespace {
+    constexpr std::array<std::uint64_t, 8> initial_state {
+            0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+            0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+    };
+
+    constexpr std::uint8_t sigma[12][16] {
+            { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+            { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+            { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+            { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+            { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+            { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+            { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+            { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+            { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+            { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+            { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+            { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    };
+
+    auto load_u64(const std::uint8_t *bytes) -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) value = (value << 8) | bytes[i];
+        return value;
+    }
+}
+
+/**
+ * @param digest_size The digest length in bytes, 1 to 64.
+ */
+blake2b::blake2b(std::size_t digest_size) : _state(initial_state), _digest_size(digest_size) {
+    /// Parameter block: digest length, no key, fanout and depth of 1
+    _state[0] ^= 0x01010000ULL ^ digest_size;
+}
+
+/**
+ * @brief Starts a keyed hash, the key is absorbed as a first block of its own.
+ * @param digest_size The digest length in bytes, 1 to 64.
+ * @param key         The key, a longer one than max_key_size bytes is hashed down to that size first.
+ */
+blake2b::blake2b(std::size_t digest_size, std::string_view key) : blake2b(digest_size) {
+    if (key.empty()) return;
+
+    std::size_t key_size = std::min(key.size(), max_key_size);
+    if (key.size() > max_key_size) hash(_buffer.data(), max_key_size, key.data(), key.size());
+    else std::memcpy(_buffer.data(), key.data(), key.size());
+    _state[0] ^= static_cast<std::uint64_t>(key_size) << 8;
+    _buffered = _buffer.size();
+}
+
+auto blake2b::update(const void *data, std::size_t size) -> void {
+    const auto *bytes = static_cast<const std::uint8_t*>(data);
+
+    while (size > 0) {
+        /// The last block is only compressed in final(), with the last block flag
+        if (_buffered == _buffer.size()) {
+            _counter += _buffer.size();
+            compress(false);
+            _buffered = 0;
+        }
+
+        std::size_t taken = std::min(size, _buffer.size() - _buffered);
+        std::memcpy(_buffer.data() + _buffered, bytes, taken);
+        _buffered += taken;
+        bytes += taken;
+        size -= taken;
+    }
+}
+
+auto blake2b::update(std::string_view data) -> void {
+    update(data.data(), data.size());
+}
+
+/**
+ * @brief Absorbs a 32-bit little endian integer, as Argon2 frames its inputs.
+ */
+auto blake2b::update_u32(std::uint32_t value) -> void {
+    std::uint8_t bytes[4] { static_cast<std::uint8_t>(value), static_cast<std::uint8_t>(value >> 8),
+                            static_cast<std::uint8_t>(value >> 16), static_cast<std::uint8_t>(value >> 24) };
+    update(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Writes the digest, the object must not be used afterwards.
+ */
+auto blake2b::final(void *digest) -> void {
+    _counter += _buffered;
+    std::memset(_buffer.data() + _buffered, 0, _buffer.size() - _buffered);
+    compress(true);
+
+    std::uint8_t bytes[max_digest_size];
+    for (std::size_t i = 0; i < 8; ++i) {
+        for (std::size_t j = 0; j < 8; ++j) bytes[i * 8 + j] = static_cast<std::uint8_t>(_state[i] >> (8 * j));
+    }
+    std::memcpy(digest, bytes, _digest_size);
+
+    /// The buffer may still hold the key
+    secure_arena::zeroize(_buffer.data(), _buffer.size());
+    secure_arena::zeroize(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Hashes a buffer in one call.
+ */
+auto blake2b::hash(void *digest, std::size_t digest_size, const void *data, std::size_t size) -> void {
+    blake2b hasher(digest_size);
+    hasher.update(data, size);
+    hasher.final(digest);
+}
+
+/**
+ * @brief Mixes the buffered block into the state.
+ * @param last Whether this is the final block of the message.
+ */
+auto blake2b::compress(bool last) -> void {
+    std::uint64_t message[16];
+    for (std::size_t i = 0; i < 16; ++i) message[i] = load_u64(_buffer.data() + i * 8);
+
+    std::uint64_t v[16];
+    for (std::size_t i = 0; i < 8; ++i) {
+        v[i] = _state[i];
+        v[i + 8] = initial_state[i];
+    }
+    v[12] ^= _counter;
+    if (last) v[14] = ~v[14];
+
+    auto mix = [&v](int a, int b, int c, int d, std::uint64_t x, std::uint64_t y) {
+        v[a] = v[a] + v[b] + x;
+        v[d] = std::rotr(v[d] ^ v[a], 32);
+        v[c] = v[c] + v[d];
+        v[b] = std::rotr(v[b] ^ v[c], 24);
+        v[a] = v[a] + v[b] + y;
+        v[d] = std::rotr(v[d] ^ v[a], 16);
+        v[c] = v[c] + v[d];
+        v[b] = std::rotr(v[b] ^ v[c], 63);
+    };
+
+    for (const auto &round : sigma) {
+        mix(0, 4, 8, 12, message[round[0]], message[round[1]]);
+        mix(1, 5, 9, 13, message[round[2]], message[round[3]]);
+        mix(2, 6, 10, 14, message[round[4]], message[round[5]]);
+        mix(3, 7, 11, 15, message[round[6]], message[round[7]]);
+        mix(0, 5, 10, 15, message[round[8]], message[round[9]]);
+        mix(1, 6, 11, 12, message[round[10]], message[round[11]]);
+        mix(2, 7, 8, 13, message[round[12]], message[round[13]]);
+        mix(3, 4, 9, 14, message[round[14]], message[round[15]]);
+    }
+
+    for (std::size_t i = 0; i < 8; ++i) _state[i] ^= v[i] ^ v[i + 8];
+}
@@ -0,0 +1,479 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <cmath>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <fmt/format.h>
+#include "../include/md4.hpp"
+#include "../include/sha1.hpp"
+#include "../include/breach_index.hpp"
+
+namespace {
+    constexpr std::size_t max_digest_size = 20;
+
+    auto put_le(std::string &buffer, std::uint64_t value, std::size_t bytes) -> void {
+        for (std::size_t i = 0; i < bytes; ++i) buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    auto get_le(const std::uint8_t *bytes, std::size_t size) -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (std::size_t i = size; i > 0; --i) value = (value << 8) | bytes[i - 1];
+        return value;
+    }
+
+    auto get_be(const std::uint8_t *bytes, std::size_t size) -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < size; ++i) value = (value << 8) | bytes[i];
+        return value;
+    }
+
+    /// High 64 bits of the 128-bit product, built from 32-bit halves to stay within standard types
+    auto multiply_high(std::uint64_t a, std::uint64_t b) -> std::uint64_t {
+        std::uint64_t a_low = a & 0xFFFFFFFF, a_high = a >> 32;
+        std::uint64_t b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+
+        std::uint64_t low_low = a_low * b_low;
+        std::uint64_t high_low = a_high * b_low;
+        std::uint64_t low_high = a_low * b_high;
+        std::uint64_t carry = ((low_low >> 32) + (high_low & 0xFFFFFFFF) + (low_high & 0xFFFFFFFF)) >> 32;
+        return a_high * b_high + (high_low >> 32) + (low_high >> 32) + carry;
+    }
+
+    auto page_faults() -> std::pair<long, long> {
+        rusage usage { };
+        getrusage(RUSAGE_SELF, &usage);
+        return { usage.ru_majflt, usage.ru_minflt };
+    }
+}
+
+breach_index::~breach_index() {
+    if (_mapping != nullptr) munmap(_mapping, _mapping_size);
+}
+
+/**
+ * @brief Converts a sorted text corpus into an index file.
+ *
+ * Every line holds a hex hash, optionally followed by ':' and the times it
+ * was seen. The corpus is streamed, so it may be far larger than memory,
+ * but it has to be sorted by hash. Repeated hashes are merged.
+ *
+ * @param source              The text corpus.
+ * @param target              The index file to write.
+ * @param type                Whether the corpus holds SHA-1 or NTLM hashes.
+ * @param bloom_bits_per_hash Size of the Bloom filter, 0 for none.
+ * @return True if the index was written.
+ */
+auto breach_index::build(const std::string &source, const std::string &target,
+                         algorithm type, unsigned bloom_bits_per_hash) -> bool {
+    std::ifstream input(source, std::ios::binary);
+    if (!input) {
+        fmt::print("[-] Failed to Open the File '{}'\n", source);
+        return false;
+    }
+    std::ofstream output(target, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        fmt::print("[-] Failed to Open the File '{}'\n", target);
+        return false;
+    }
+
+    std::size_t digest_size = type == algorithm::sha1 ? sha1::digest_size : md4::digest_size;
+    std::size_t record_size = digest_size - _prefix_size + _count_size;
+
+    /// Header and fan-out are written once the records are known
+    std::string placeholder(_header_size + _fanout_entries * 8, '\0');
+    output.write(placeholder.data(), static_cast<std::streamsize>(placeholder.size()));
+
+    std::vector<std::uint64_t> fanout(_fanout_entries, 0);
+    std::array<std::uint8_t, max_digest_size> current { }, pending { };
+    std::uint64_t pending_count = 0, record_count = 0, line_number = 0;
+    bool has_pending = false;
+    std::string records;
+    records.reserve(1 << 20);
+
+    auto flush_pending = [&]() {
+        records.append(reinterpret_cast<const char*>(pending.data()) + _prefix_size, digest_size - _prefix_size);
+        put_le(records, std::min<std::uint64_t>(pending_count, UINT32_MAX), _count_size);
+        ++fanout[(static_cast<std::size_t>(pending[0]) << 8 | pending[1]) + 1];
+        ++record_count;
+        if (records.size() >= (1 << 20)) {
+            output.write(records.data(), static_cast<std::streamsize>(records.size()));
+            records.clear();
+        }
+    };
+
+    for (std::string line; std::getline(input, line);) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        std::string_view text(line);
+        std::size_t colon = text.find(':');
+        std::uint64_t count = 1;
+        if (colon != std::string_view::npos) {
+            auto [end, error] = std::from_chars(text.data() + colon + 1, text.data() + text.size(), count);
+            if (error != std::errc() || end != text.data() + text.size()) count = 1;
+            text = text.substr(0, colon);
+        }
+
+        if (text.size() != digest_size * 2 || !parse_hex(text, std::span(current.data(), digest_size))) {
+            fmt::print("[-] Line {} is Not a {} Hash\n", line_number, type == algorithm::sha1 ? "SHA-1" : "NTLM");
+            return false;
+        }
+
+        int order = has_pending ? std::memcmp(current.data(), pending.data(), digest_size) : 1;
+        if (order < 0) {
+            fmt::print("[-] Line {} is Out of Order, the Corpus Must Be Sorted by Hash\n", line_number);
+            return false;
+        }
+        if (order == 0) {
+            pending_count += count;
+            continue;
+        }
+
+        if (has_pending) flush_pending();
+        pending = current;
+        pending_count = count;
+        has_pending = true;
+
+        if (line_number % 100'000'000 == 0) fmt::print("[+] Read {} Lines\n", line_number);
+    }
+    if (has_pending) flush_pending();
+    output.write(records.data(), static_cast<std::streamsize>(records.size()));
+    records.clear();
+
+    for (std::size_t i = 1; i < fanout.size(); ++i) fanout[i] += fanout[i - 1];
+
+    /// The Bloom filter needs the final record count, so it is filled from the written records
+    std::uint64_t bloom_bits = 0;
+    std::uint32_t bloom_hashes = 0;
+    if (bloom_bits_per_hash > 0 && record_count > 0) {
+        bloom_bits = (record_count * bloom_bits_per_hash + 63) / 64 * 64;
+        bloom_hashes = std::clamp(static_cast<std::uint32_t>(std::lround(bloom_bits_per_hash * std::log(2.0))), 1U, 16U);
+        std::vector<std::uint64_t> bloom(bloom_bits / 64, 0);
+
+        output.flush();
+        std::ifstream written(target, std::ios::binary);
+        written.seekg(static_cast<std::streamoff>(placeholder.size()));
+
+        std::array<char, 64> record { };
+        std::size_t prefix = 0;
+        for (std::uint64_t i = 0; i < record_count; ++i) {
+            written.read(record.data(), static_cast<std::streamsize>(record_size));
+            while (fanout[prefix + 1] <= i) ++prefix;
+
+            std::array<std::uint8_t, max_digest_size> digest { static_cast<std::uint8_t>(prefix >> 8),
+                                                             static_cast<std::uint8_t>(prefix & 0xFF) };
+            std::memcpy(digest.data() + _prefix_size, record.data(), digest_size - _prefix_size);
+
+            auto [first, step] = bloom_positions(std::span(digest.data(), digest_size));
+            for (std::uint32_t k = 0; k < bloom_hashes; ++k) {
+                std::uint64_t bit = (first + k * step) % bloom_bits;
+                bloom[bit / 64] |= std::uint64_t(1) << (bit % 64);
+            }
+        }
+        if (!written) {
+            fmt::print("[-] Failed to Read Back the File '{}'\n", target);
+            return false;
+        }
+
+        for (std::uint64_t word : bloom) put_le(records, word, 8);
+        output.write(records.data(), static_cast<std::streamsize>(records.size()));
+    }
+
+    std::string header(_magic);
+    put_le(header, _version, 4);
+    put_le(header, static_cast<std::uint32_t>(type), 4);
+    put_le(header, record_size, 4);
+    put_le(header, record_count, 8);
+    put_le(header, bloom_bits, 8);
+    put_le(header, bloom_hashes, 4);
+    header.resize(_header_size, '\0');
+    for (std::uint64_t offset : fanout) put_le(header, offset, 8);
+
+    output.seekp(0);
+    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+    output.close();
+    if (!output) {
+        fmt::print("[-] Failed to Write the File '{}'\n", target);
+        return false;
+    }
+
+    fmt::print("[+] Indexed {} Hashes from {} Lines into '{}'", record_count, line_number, target);
+    if (bloom_bits > 0) fmt::print(" with a {} KiB Bloom Filter", bloom_bits / 8 / 1024);
+    fmt::print("\n");
+    return true;
+}
+
+/**
+ * @brief Maps an index file written by build().
+ *
+ * @param filename   The index file.
+ * @param load_bloom Whether to copy the Bloom filter into memory, if the index has one.
+ * @return The index, or nullptr if the file is missing or malformed.
+ */
+auto breach_index::open(const std::string &filename, bool load_bloom) -> std::unique_ptr<breach_index> {
+    int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        fmt::print("[-] Failed to Open the Breach Index '{}'\n", filename);
+        return nullptr;
+    }
+
+    struct stat status { };
+    void *mapping = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        fmt::print("[-] Failed to Map the Breach Index '{}'\n", filename);
+        return nullptr;
+    }
+
+    std::unique_ptr<breach_index> index(new breach_index());
+    index->_mapping = mapping;
+    index->_mapping_size = static_cast<std::size_t>(status.st_size);
+
+    const auto *bytes = static_cast<const std::uint8_t*>(mapping);
+    std::size_t fixed_size = _header_size + _fanout_entries * 8;
+    if (index->_mapping_size < fixed_size || std::memcmp(bytes, _magic.data(), _magic.size()) != 0
+        || get_le(bytes + 4, 4) != _version || get_le(bytes + 8, 4) > 1) {
+        fmt::print("[-] '{}' is Not a Breach Index\n", filename);
+        return nullptr;
+    }
+
+    index->_type = static_cast<algorithm>(get_le(bytes + 8, 4));
+    index->_digest_size = index->_type == algorithm::sha1 ? sha1::digest_size : md4::digest_size;
+    index->_record_size = get_le(bytes + 12, 4);
+    index->_record_count = get_le(bytes + 16, 8);
+    index->_bloom_bits = get_le(bytes + 24, 8);
+    index->_bloom_hashes = static_cast<std::uint32_t>(get_le(bytes + 32, 4));
+    index->_fanout = bytes + _header_size;
+    index->_records = bytes + fixed_size;
+
+    std::size_t bloom_bytes = index->_bloom_bits / 8;
+    bool consistent = index->_record_size == index->_digest_size - _prefix_size + _count_size
+                      && index->_bloom_bits % 64 == 0
+                      && get_le(index->_fanout + (_fanout_entries - 1) * 8, 8) == index->_record_count
+                      && index->_record_count <= (index->_mapping_size - fixed_size) / index->_record_size
+                      && index->_mapping_size - fixed_size - index->_record_count * index->_record_size >= bloom_bytes;
+    if (!consistent) {
+        fmt::print("[-] Breach Index '{}' is Corrupted\n", filename);
+        return nullptr;
+    }
+
+    /// Lookups jump around, read-ahead would only pull in pages nobody asked for
+    madvise(mapping, index->_mapping_size, MADV_RANDOM);
+
+    if (load_bloom && index->_bloom_bits > 0) {
+        const std::uint8_t *bloom = index->_records + index->_record_count * index->_record_size;
+        index->_bloom.resize(index->_bloom_bits / 64);
+        for (std::size_t i = 0; i < index->_bloom.size(); ++i) index->_bloom[i] = get_le(bloom + i * 8, 8);
+    }
+
+    return index;
+}
+
+/**
+ * @brief Returns the index named by GUARDCIPHER_BREACH_INDEX, opened on first use.
+ *
+ * GUARDCIPHER_BREACH_BLOOM=0 leaves the Bloom filter on disk.
+ *
+ * @return The index, or nullptr if none is configured or it could not be opened.
+ */
+auto breach_index::configured() -> const breach_index* {
+    static const std::unique_ptr<breach_index> index = []() -> std::unique_ptr<breach_index> {
+        const char *filename = std::getenv("GUARDCIPHER_BREACH_INDEX");
+        if (filename == nullptr || *filename == '\0') return nullptr;
+
+        const char *bloom = std::getenv("GUARDCIPHER_BREACH_BLOOM");
+        bool load_bloom = bloom == nullptr || (std::string_view(bloom) != "0" && std::string_view(bloom) != "off");
+        return open(filename, load_bloom);
+    }();
+    return index.get();
+}
+
+/**
+ * @brief Checks every stored password against the configured index, spread over all cores.
+ *
+ * Only the location of a breached password is printed, never the password.
+ *
+ * @param category The categories object to scan.
+ * @param password The passwords object to scan.
+ */
+auto breach_index::scan(const categories &category, const passwords &password) -> void {
+    const breach_index *index = configured();
+    if (index == nullptr) {
+        fmt::print("\n[-] No Breach Index, Set GUARDCIPHER_BREACH_INDEX to a File Built with --build-breach-index\n");
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::string_view>> entries;
+    for (const auto &[category_ID, element] : category.categories_map) {
+        for (const auto &[password_ID, value] : element.passwords) {
+            entries.emplace_back(fmt::format("Category '{}' ID {}", element.name, password_ID), value);
+        }
+    }
+    for (const auto &[password_ID, value] : password.get_passwords()) {
+        entries.emplace_back(fmt::format("Password List ID {}", password_ID), value.name);
+    }
+    if (entries.empty()) {
+        fmt::print("\n[-] No Passwords to Scan\n");
+        return;
+    }
+
+    std::vector<std::uint32_t> seen(entries.size(), 0);
+    std::size_t thread_count = std::clamp<std::size_t>(entries.size() / 64, 1,
+                                                       std::max(1U, std::thread::hardware_concurrency()));
+
+    auto faults_before = page_faults();
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            workers.emplace_back([&, t]() {
+                for (std::size_t i = t; i < entries.size(); i += thread_count) {
+                    seen[i] = index->occurrences(entries[i].second);
+                }
+            });
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    auto faults_after = page_faults();
+
+    std::size_t breached = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (seen[i] == 0) continue;
+        if (breached++ == 0) fmt::print("\n{:<40} {:>12}\n", "Location", "Times Seen");
+        fmt::print("{:<40} {:>12}\n", entries[i].first, seen[i]);
+    }
+
+    fmt::print("\n[+] Checked {} Passwords Against {} Hashes in {:.2f} ms on {} Threads, {} Breached\n",
+               entries.size(), index->records(), elapsed.count(), thread_count, breached);
+    fmt::print("Page Faults: {} Major, {} Minor\n", faults_after.first - faults_before.first,
+               faults_after.second - faults_before.second);
+}
+
+/**
+ * @brief Returns how often the password appears in the corpus, 0 if it does not.
+ */
+auto breach_index::occurrences(std::string_view password) const -> std::uint32_t {
+    if (_type == algorithm::sha1) {
+        sha1::digest digest = sha1::hash(password);
+        if (!bloom_contains(digest)) return 0;
+        return find(digest);
+    }
+
+    md4::digest digest = md4::ntlm(password);
+    if (!bloom_contains(digest)) return 0;
+    return find(digest);
+}
+
+/**
+ * @brief Looks a hash up in its fan-out bucket.
+ *
+ * The position is first guessed by interpolating the next eight bytes of
+ * the hash over the bucket, then bracketed by probing outwards with growing
+ * steps and finished with a binary search. The guess is usually within a
+ * few records, so all probes land on the same page.
+ */
+auto breach_index::find(std::span<const std::uint8_t> digest) const -> std::uint32_t {
+    std::size_t prefix = static_cast<std::size_t>(digest[0]) << 8 | digest[1];
+    std::uint64_t low = get_le(_fanout + prefix * 8, 8);
+    std::uint64_t high = get_le(_fanout + (prefix + 1) * 8, 8);
+    if (low >= high || high > _record_count) return 0;
+
+    std::span<const std::uint8_t> key = digest.subspan(_prefix_size);
+    auto compare = [this, key](std::uint64_t position) -> int {
+        return std::memcmp(_records + position * _record_size, key.data(), key.size());
+    };
+
+    std::uint64_t fraction = get_be(key.data(), 8);
+    std::uint64_t guess = low + multiply_high(fraction, high - low);
+
+    int order = compare(guess);
+    std::uint64_t first = low, last = high;
+    if (order < 0) {
+        first = guess + 1;
+        for (std::uint64_t step = 1;; step *= 2) {
+            if (guess + step >= high) break;
+            if (compare(guess + step) >= 0) {
+                last = guess + step + 1;
+                break;
+            }
+            first = guess + step + 1;
+        }
+    } else if (order > 0) {
+        last = guess;
+        for (std::uint64_t step = 1;; step *= 2) {
+            if (guess < low + step) break;
+            if (compare(guess - step) <= 0) {
+                first = guess - step;
+                break;
+            }
+            last = guess - step;
+        }
+    } else first = guess, last = guess + 1;
+
+    while (first < last) {
+        std::uint64_t middle = first + (last - first) / 2;
+        if (compare(middle) < 0) first = middle + 1;
+        else last = middle;
+    }
+    if (first >= high || compare(first) != 0) return 0;
+
+    return static_cast<std::uint32_t>(get_le(_records + first * _record_size + key.size(), _count_size));
+}
+
+/**
+ * @brief Checks the in-memory Bloom filter, true when there is none.
+ */
+auto breach_index::bloom_contains(std::span<const std::uint8_t> digest) const -> bool {
+    if (_bloom.empty()) return true;
+
+    auto [first, step] = bloom_positions(digest);
+    for (std::uint32_t k = 0; k < _bloom_hashes; ++k) {
+        std::uint64_t bit = (first + k * step) % _bloom_bits;
+        if ((_bloom[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses hex digits into bytes, in either case.
+ */
+auto breach_index::parse_hex(std::string_view text, std::span<std::uint8_t> digest) -> bool {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        int high = nibble(text[i * 2]), low = nibble(text[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        digest[i] = static_cast<std::uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+/**
+ * @brief The two values of the double hashing scheme, taken straight from the hash since it is uniform.
+ */
+auto breach_index::bloom_positions(std::span<const std::uint8_t> digest) -> std::pair<std::uint64_t, std::uint64_t> {
+    return { get_le(digest.data(), 8), get_le(digest.data() + 8, 8) | 1 };
+}
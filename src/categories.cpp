@@ -3,7 +3,11 @@
  * See LICENSE file for license details
  */
 
+#include "../include/trace.hpp"
+#include "../include/history.hpp"
 #include "../include/categories.hpp"
+#include "../include/name_index.hpp"
+#include "../include/vault_view.hpp"
 
 /**
  * @brief Adds a new category.
@@ -12,22 +16,55 @@
  * with an assigned ID to the categories_map. It then prints a success message.
  */
 auto categories::add() -> void {
-    /// Create a new category struct
-    struct category new_category;
-
     /// Prompt the user to enter the category name
     fmt::print("Enter the Category Name: ");
     std::string category_name;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::getline(std::cin, category_name);
 
+    insert(category_name);
+    fmt::print("\n[+] Category Added Successfully\n");
+}
+
+/**
+ * @brief Adds a new category without prompting.
+ *
+ * @param category_name The name of the new category.
+ * @return The ID assigned to the new category.
+ */
+auto categories::insert(const std::string &category_name) -> std::size_t {
+    TRACE_SPAN("categories::insert");
+
+    /// Create a new category struct
+    struct category new_category;
+
     /// Assign the category name and ID
     new_category.name = category_name;
     new_category.ID = _current_ID++;
 
     /// Add the new category to the categories_map
     categories_map[new_category.ID] = new_category;
-    fmt::print("\n[+] Category Added Successfully\n");
+    history::put_category(new_category);
+    return new_category.ID;
+}
+
+/**
+ * @brief Adds a password to a category without prompting.
+ *
+ * @param category_ID The ID of the category to add the password to.
+ * @param password    The password to add.
+ * @return The ID assigned to the password, or an empty optional if the category does not exist.
+ */
+auto categories::insert_password(std::size_t category_ID,
+                                 const std::string &password) -> std::optional<std::size_t> {
+    TRACE_SPAN_ARG("categories::insert_password", category_ID);
+    auto category_it = categories_map.find(category_ID);
+    if (category_it == categories_map.end()) return std::nullopt;
+
+    std::size_t password_ID = category_it->second._pass_id++;
+    category_it->second.passwords[password_ID] = password;
+    history::put_password(category_ID, password_ID, password);
+    return password_ID;
 }
 
 /**
@@ -54,21 +91,45 @@ auto categories::get_ID(std::size_t category_ID) const -> std::optional<category
 /**
  * @brief Retrieves a category by its name.
  *
- * This function searches for a category with the specified name in the categories_map.
- * If a matching category is found, it returns an optional containing the category.
- * Otherwise, it returns an empty optional (std::nullopt).
+ * The name is looked up in the name index, so the cost depends on the
+ * length of the name rather than on the number of categories.
  *
  * @param category_name The name of the category to retrieve.
  * @return An optional containing the found category, or an empty optional if not found.
  */
 auto categories::get_name(const std::string &category_name) const -> std::optional<category> {
-    /// Iterate over each element in the categories_map
-    for (const auto &element : categories_map) {
-        /// Check if the category name matches the specified name
-        if (element.second.name == category_name) {
-            /// Return the found category
-            return element.second;
+    for (const radix_trie::reference &owner : name_index::category_names().find(category_name)) {
+        auto it = categories_map.find(owner.category_ID);
+        if (it != categories_map.end() && it->second.name == category_name) return it->second;
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief Retrieves the only category whose name starts with the given text.
+ *
+ * If several categories match, the first few of them are listed so the
+ * user can type more of the name.
+ *
+ * @param prefix The start of the category name.
+ * @return An optional containing the found category, or an empty optional if none or several match.
+ */
+auto categories::complete(const std::string &prefix) const -> std::optional<category> {
+    if (prefix.empty()) return std::nullopt;
+    radix_trie::completion found = name_index::category_names().starts_with(prefix, _suggestions);
+
+    if (found.total == 1) {
+        std::optional<category> completed = get_ID(found.matches.front().owner.category_ID);
+        if (completed) fmt::print("[+] Completed to '{}'\n", completed->name);
+        return completed;
+    }
+
+    if (found.total > 1) {
+        fmt::print("\n[-] '{}' Matches {} Categories:\n", prefix, found.total);
+        for (const radix_trie::match &suggestion : found.matches) {
+            fmt::print("[ID: {}] {}\n", suggestion.owner.category_ID, suggestion.name);
         }
+        if (found.total > found.matches.size()) fmt::print("... and {} More\n", found.total - found.matches.size());
     }
     return std::nullopt;
 }
@@ -80,6 +141,7 @@ auto categories::get_name(const std::string &category_name) const -> std::option
  * a variant parameter that can hold either a size_t representing the category ID
  * or a string representing the category name. It uses the appropriate helper
  * functions, get_ID() or get_name(), to perform the retrieval based on the variant value.
+ * A name can be abbreviated to any prefix that only one category starts with.
  *
  * @param identifier The variant identifier containing either the category ID or name.
  * @return An optional containing the found category, or an empty optional if not found.
@@ -98,41 +160,24 @@ auto categories::get(const std::variant<std::size_t,
     else if (std::holds_alternative<std::string>(identifier)) {
         /// Retrieve the category name from the identifier
         std::string category_name = std::get<std::string>(identifier);
-        /// Use the get_name() function to retrieve the category by name
-        return get_name(category_name);
+        /// Use the get_name() function to retrieve the category by name,
+        /// and complete() if no category has exactly that name
+        if (std::optional<category> found = get_name(category_name)) return found;
+        return complete(category_name);
     }
 
     return std::nullopt;
 }
 
 /**
- * @brief Checks if there are printable categories.
+ * @brief Checks if there are no categories.
  *
- * This function checks if there are any categories in the categories_map.
- * If there are categories present, it prints the ID, name, and passwords
- * for each category. If no categories are found, it prints a corresponding
- * message. The function returns a boolean value indicating whether there
- * are printable categories or not.
+ * Only checks the map, use vault_view to show the categories.
  *
- * @return True if there are printable categories, false otherwise.
+ * @return True if there are no categories, false otherwise.
  */
-auto categories::is_printable() -> bool {
-    /// Check if there are categories in the categories_map
-    bool has_categories = !categories_map.empty();
-
-    /// If there are categories, print their details
-    if (has_categories) {
-        fmt::print("\n----------- Categories -----------\n");
-        for (const auto &category : categories_map) {
-            fmt::print("\n[+] ID: {} Name: {}\n Passwords:\n",
-                       category.second.ID, category.second.name);
-            for (const auto &password : category.second.passwords) {
-                fmt::print("ID: {}, {}\n", password.first, password.second);
-            }
-        }
-    } else fmt::print("\n[-] No Category Found\n");
-
-    return has_categories;
+auto categories::empty() const -> bool {
+    return categories_map.empty();
 }
 
 /**
@@ -145,7 +190,11 @@ auto categories::is_printable() -> bool {
  * Otherwise, it displays a message indicating that the category was not found.
  */
 auto categories::remove() -> void {
-    if (!is_printable()) return;
+    if (empty()) {
+        fmt::print("\n[-] No Category Found\n");
+        return;
+    }
+    vault_view::preview(*this);
     fmt::print("Choose Category to Delete: ");
 
     /// Prompt user to choose a category for deletion
@@ -173,6 +222,7 @@ auto categories::remove() -> void {
         if (confirmation.size() == 1 && std::toupper(confirmation[0]) == 'Y') {
             /// Remove the category from the categories_map
             categories_map.erase(category_selected->ID);
+            history::erase_category(category_selected->ID);
             fmt::print("\n[+] Category Deleted Successfully\n");
         } else fmt::print("\n[-] Canceled\n");
 
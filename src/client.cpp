@@ -0,0 +1,191 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <vector>
+#include <cstring>
+#include <sstream>
+#include <iostream>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <fmt/core.h>
+
+#include "../include/protocol.hpp"
+
+/**
+ * @brief Encodes one command line into a request frame.
+ *
+ * @param words  The command followed by its arguments.
+ * @param buffer The buffer the request frame is appended to.
+ * @return The opcode of the request, or an empty optional if the command or its arguments are invalid.
+ */
+static auto encode(const std::vector<std::string> &words,
+                   std::string &buffer) -> std::optional<protocol::opcode> {
+    try {
+        if (words.size() == 3 && words[0] == "get") {
+            std::size_t frame = protocol::begin_frame(buffer, static_cast<std::uint8_t>(protocol::opcode::get));
+            protocol::put_u64(buffer, std::stoull(words[1]));
+            protocol::put_u64(buffer, std::stoull(words[2]));
+            protocol::end_frame(buffer, frame);
+            return protocol::opcode::get;
+        }
+        if (words.size() == 2 && words[0] == "search") {
+            std::size_t frame = protocol::begin_frame(buffer, static_cast<std::uint8_t>(protocol::opcode::search));
+            buffer.append(words[1]);
+            protocol::end_frame(buffer, frame);
+            return protocol::opcode::search;
+        }
+        if (words.size() == 3 && words[0] == "add") {
+            std::size_t frame = protocol::begin_frame(buffer, static_cast<std::uint8_t>(protocol::opcode::add));
+            protocol::put_u64(buffer, std::stoull(words[1]));
+            buffer.append(words[2]);
+            protocol::end_frame(buffer, frame);
+            return protocol::opcode::add;
+        }
+    } catch (...) { }
+
+    return std::nullopt;
+}
+
+/**
+ * @brief Prints a response frame of the given request.
+ *
+ * @param op   The opcode of the request that was answered.
+ * @param body The response body, starting with the status byte.
+ * @return True if the daemon answered with success.
+ */
+static auto print_response(protocol::opcode op, std::string_view body) -> bool {
+    auto result = static_cast<protocol::status>(body.front());
+    body.remove_prefix(1);
+
+    if (result == protocol::status::not_found) {
+        fmt::print(stderr, "[-] Not Found\n");
+        return false;
+    }
+    if (result != protocol::status::ok) {
+        fmt::print(stderr, "[-] Invalid Request\n");
+        return false;
+    }
+
+    switch (op) {
+        case protocol::opcode::get:
+            fmt::print("{}\n", body);
+            break;
+        case protocol::opcode::add:
+            fmt::print("[+] ID: {}\n", protocol::get_u64(body).value_or(0));
+            break;
+        case protocol::opcode::search: {
+            std::uint64_t count = protocol::get_u64(body).value_or(0);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                std::uint64_t category_ID = protocol::get_u64(body).value_or(0);
+                std::uint64_t password_ID = protocol::get_u64(body).value_or(0);
+                std::uint64_t length = std::min<std::uint64_t>(protocol::get_u64(body).value_or(0), body.size());
+                fmt::print("[Category: {}, ID: {}] {}\n", category_ID, password_ID, body.substr(0, length));
+                body.remove_prefix(length);
+            }
+            if (count == 0) fmt::print("[-] No Passwords Found\n");
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Command line client of the GuardCipher daemon.
+ *
+ * With a command on the command line, it sends that single request. Without
+ * one, it reads one command per line from the standard input and pipelines
+ * all of them over a single connection.
+ */
+auto main(int argc, char *argv[]) -> int {
+    if (argc < 2) {
+        fmt::print(stderr, "Usage: {} <socket path> [get <category ID> <password ID> | "
+                           "search <parameter> | add <category ID> <password>]\n"
+                           "Category ID 0 selects the password list. Without a command,\n"
+                           "commands are read from the standard input, one per line.\n", argv[0]);
+        return 2;
+    }
+
+    /// Collect the commands to send
+    std::vector<std::vector<std::string>> commands;
+    if (argc > 2) {
+        commands.emplace_back(argv + 2, argv + argc);
+    } else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::istringstream stream(line);
+            std::vector<std::string> words;
+            for (std::string word; stream >> word;) words.push_back(std::move(word));
+            if (!words.empty()) commands.push_back(std::move(words));
+        }
+    }
+
+    std::string requests;
+    std::vector<protocol::opcode> opcodes;
+    for (const auto &words : commands) {
+        std::optional<protocol::opcode> op = encode(words, requests);
+        if (!op) {
+            fmt::print(stderr, "[-] Invalid Command '{}'\n", words.front());
+            return 2;
+        }
+        opcodes.push_back(*op);
+    }
+
+    sockaddr_un address { };
+    address.sun_family = AF_UNIX;
+    std::string socket_path = argv[1];
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        fmt::print(stderr, "[-] Socket Path '{}' is Too Long\n", socket_path);
+        return 1;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        fmt::print(stderr, "[-] Failed to Connect to '{}': {}\n", socket_path, std::strerror(errno));
+        return 1;
+    }
+
+    /// Send every request before reading, the daemon buffers the answers
+    std::size_t sent_total = 0;
+    while (sent_total < requests.size()) {
+        ssize_t sent = send(fd, requests.data() + sent_total, requests.size() - sent_total, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            fmt::print(stderr, "[-] Failed to Send the Requests\n");
+            return 1;
+        }
+        sent_total += static_cast<std::size_t>(sent);
+    }
+
+    int exit_code = 0;
+    std::string responses;
+    std::size_t answered = 0;
+    char chunk[64 * 1024];
+
+    while (answered < opcodes.size()) {
+        std::string_view pending = responses;
+        while (answered < opcodes.size()) {
+            std::optional<std::size_t> length = protocol::frame_length(pending);
+            if (!length) break;
+            std::string_view body = pending.substr(protocol::header_size, *length);
+            if (body.empty() || !print_response(opcodes[answered], body)) exit_code = 1;
+            pending.remove_prefix(protocol::header_size + *length);
+            ++answered;
+        }
+        responses.erase(0, responses.size() - pending.size());
+        if (answered == opcodes.size()) break;
+
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            fmt::print(stderr, "[-] The Daemon Closed the Connection\n");
+            return 1;
+        }
+        responses.append(chunk, static_cast<std::size_t>(received));
+    }
+
+    close(fd);
+    return exit_code;
+}
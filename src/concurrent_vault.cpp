@@ -0,0 +1,276 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <limits>
+#include <thread>
+#include "../include/concurrent_vault.hpp"
+
+/**
+ * @brief Applies a mutation to a private copy of the current version and publishes it.
+ *
+ * The version is only republished when the mutation changed it,
+ * so failed mutations leave readers on the same version.
+ *
+ * @tparam Mutation Callable taking the version to mutate.
+ * @param mutation  The mutation to apply.
+ * @return Whatever the mutation returns.
+ */
+template <typename Mutation>
+auto concurrent_vault::update(Mutation &&mutation) -> decltype(mutation(std::declval<vault_state&>())) {
+    std::lock_guard<std::mutex> lock(_writer);
+
+    /// Only writers replace the version, so holding the mutex keeps it alive
+    const std::shared_ptr<const vault_state> &current = _current.load(std::memory_order_acquire)->state;
+    auto next = std::make_shared<vault_state>(*current);
+    auto result = mutation(*next);
+    if (next->same(*current)) return result;
+
+    published *replaced = _current.exchange(new published { std::move(next) }, std::memory_order_seq_cst);
+    _retired.push_back({ replaced, _epoch.fetch_add(1, std::memory_order_seq_cst) });
+    reclaim();
+
+    return result;
+}
+
+/**
+ * @brief Creates an empty vault.
+ */
+concurrent_vault::concurrent_vault() : _current(new published { std::make_shared<const vault_state>() }) { }
+
+/**
+ * @brief Creates a vault starting at the given version.
+ * @param initial The version to start from, for example a history snapshot.
+ */
+concurrent_vault::concurrent_vault(const vault_state &initial)
+        : _current(new published { std::make_shared<const vault_state>(initial) }) {
+    /// Continue numbering after the highest IDs in use
+    initial.categories_map.for_each([this](std::size_t key, const vault_state::category_version &) {
+        _next_category_ID = std::max(_next_category_ID, key + 1);
+    });
+    initial.uncategorized.for_each([this](std::size_t key, const passwords::password &) {
+        _next_password_ID = std::max(_next_password_ID, key + 1);
+    });
+}
+
+/**
+ * @brief Releases the published version and every retired one.
+ *
+ * No reader may use the vault while it is destroyed.
+ */
+concurrent_vault::~concurrent_vault() {
+    for (const retired &entry : _retired) delete entry.version;
+    delete _current.load();
+}
+
+/**
+ * @brief Returns the current version of the vault.
+ *
+ * The reader announces the epoch it runs in for the few instructions it
+ * takes to copy the reference. The returned version never changes while it
+ * is held, so any number of lookups on it see one consistent vault.
+ *
+ * @return The current version.
+ */
+auto concurrent_vault::snapshot() const -> std::shared_ptr<const vault_state> {
+    std::atomic<std::uint64_t> &announced = _readers[reader_index()].epoch;
+
+    announced.store(_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    std::shared_ptr<const vault_state> state = _current.load(std::memory_order_seq_cst)->state;
+    announced.store(0, std::memory_order_release);
+
+    return state;
+}
+
+/**
+ * @brief Frees retired versions that no reader can reach anymore.
+ *
+ * A version retired in epoch e may still be loaded by a reader that
+ * announced an epoch of at most e. Readers announcing a later epoch
+ * started after the version was replaced. Called with the writer lock held.
+ */
+auto concurrent_vault::reclaim() -> void {
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (const reader_slot &slot : _readers) {
+        std::uint64_t announced = slot.epoch.load(std::memory_order_seq_cst);
+        if (announced != 0) oldest = std::min(oldest, announced);
+    }
+
+    std::erase_if(_retired, [oldest](const retired &entry) -> bool {
+        if (entry.epoch >= oldest) return false;
+        delete entry.version;
+        return true;
+    });
+}
+
+/**
+ * @brief Returns the reader slot of the calling thread, claiming one on first use.
+ *
+ * The slot is given back when the thread exits. If every slot is
+ * taken, the thread waits until another reader thread exits.
+ */
+auto concurrent_vault::reader_index() -> std::size_t {
+    struct registration {
+        std::size_t index = _max_readers;
+
+        registration() {
+            while (index == _max_readers) {
+                for (std::size_t i = 0; i < _max_readers; ++i) {
+                    bool expected = false;
+                    if (_readers[i].used.compare_exchange_strong(expected, true)) {
+                        index = i;
+                        break;
+                    }
+                }
+                if (index == _max_readers) std::this_thread::yield();
+            }
+        }
+
+        ~registration() { _readers[index].used.store(false); }
+    };
+
+    thread_local registration reader;
+    return reader.index;
+}
+
+/**
+ * @brief Retrieves a single password.
+ * @param category_ID The ID of the category, 0 for the password list.
+ * @param password_ID The ID of the password.
+ * @return The password, or an empty optional if it does not exist.
+ */
+auto concurrent_vault::get(std::size_t category_ID,
+                           std::size_t password_ID) const -> std::optional<std::pmr::string> {
+    std::shared_ptr<const vault_state> state = snapshot();
+
+    if (category_ID == 0) {
+        const passwords::password *found = state->uncategorized.find(password_ID);
+        if (found != nullptr) return found->name;
+        return std::nullopt;
+    }
+
+    const vault_state::category_version *category = state->categories_map.find(category_ID);
+    if (category == nullptr) return std::nullopt;
+
+    const std::pmr::string *found = category->passwords.find(password_ID);
+    if (found != nullptr) return *found;
+    return std::nullopt;
+}
+
+/**
+ * @brief Searches for passwords containing the search parameter.
+ * @param search_param The substring to look for.
+ * @return Every match, password list entries first with category ID 0.
+ */
+auto concurrent_vault::search(std::string_view search_param) const -> std::vector<match> {
+    std::shared_ptr<const vault_state> state = snapshot();
+    std::vector<match> matches;
+
+    state->uncategorized.for_each([&](std::size_t key, const passwords::password &password) {
+        if (password.name.find(search_param) != std::string::npos) {
+            matches.push_back({ 0, key, password.name });
+        }
+    });
+
+    state->categories_map.for_each([&](std::size_t category_ID, const vault_state::category_version &category) {
+        category.passwords.for_each([&](std::size_t password_ID, const std::pmr::string &password) {
+            if (password.find(search_param) != std::string::npos) {
+                matches.push_back({ category_ID, password_ID, password });
+            }
+        });
+    });
+
+    return matches;
+}
+
+/**
+ * @brief Adds a new, empty category.
+ * @param category_name The name of the new category.
+ * @return The ID assigned to the category.
+ */
+auto concurrent_vault::add_category(const std::string &category_name) -> std::size_t {
+    return update([&](vault_state &state) -> std::size_t {
+        categories::category created;
+        created.ID = _next_category_ID++;
+        created.name = category_name;
+        state.put_category(created);
+        return created.ID;
+    });
+}
+
+/**
+ * @brief Removes a category with all of its passwords.
+ * @param category_ID The ID of the category.
+ * @return False if the category does not exist.
+ */
+auto concurrent_vault::remove_category(std::size_t category_ID) -> bool {
+    return update([&](vault_state &state) -> bool {
+        if (state.categories_map.find(category_ID) == nullptr) return false;
+        state.categories_map.erase(category_ID);
+        return true;
+    });
+}
+
+/**
+ * @brief Adds a password to a category or to the password list.
+ * @param category_ID The ID of the category, 0 for the password list.
+ * @param password    The password to add.
+ * @return The ID assigned to the password, or an empty optional if the category does not exist.
+ */
+auto concurrent_vault::add_password(std::size_t category_ID,
+                                    std::string_view password) -> std::optional<std::size_t> {
+    return update([&](vault_state &state) -> std::optional<std::size_t> {
+        if (category_ID == 0) {
+            passwords::password created { _next_password_ID++, std::pmr::string(password) };
+            state.uncategorized.insert(created.ID, created);
+            return created.ID;
+        }
+
+        const vault_state::category_version *category = state.categories_map.find(category_ID);
+        if (category == nullptr) return std::nullopt;
+
+        std::size_t password_ID = category->_pass_id;
+        state.put_password(category_ID, password_ID, password);
+        return password_ID;
+    });
+}
+
+/**
+ * @brief Replaces an existing password.
+ * @param category_ID The ID of the category, 0 for the password list.
+ * @param password_ID The ID of the password.
+ * @param password    The new password value.
+ * @return False if the password does not exist.
+ */
+auto concurrent_vault::edit_password(std::size_t category_ID, std::size_t password_ID,
+                                     std::string_view password) -> bool {
+    return update([&](vault_state &state) -> bool {
+        if (category_ID == 0) {
+            if (state.uncategorized.find(password_ID) == nullptr) return false;
+            state.uncategorized.insert(password_ID, passwords::password { password_ID, std::pmr::string(password) });
+            return true;
+        }
+
+        const vault_state::category_version *category = state.categories_map.find(category_ID);
+        if (category == nullptr || category->passwords.find(password_ID) == nullptr) return false;
+        return state.put_password(category_ID, password_ID, password);
+    });
+}
+
+/**
+ * @brief Removes a password.
+ * @param category_ID The ID of the category, 0 for the password list.
+ * @param password_ID The ID of the password.
+ * @return False if the password does not exist.
+ */
+auto concurrent_vault::remove_password(std::size_t category_ID, std::size_t password_ID) -> bool {
+    return update([&](vault_state &state) -> bool {
+        if (category_ID == 0) {
+            if (state.uncategorized.find(password_ID) == nullptr) return false;
+            state.uncategorized.erase(password_ID);
+            return true;
+        }
+        return state.erase_password(category_ID, password_ID);
+    });
+}
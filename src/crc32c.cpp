@@ -0,0 +1,101 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <array>
+#include <cstring>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+#include "../include/crc32c.hpp"
+
+namespace {
+    /// Reflected Castagnoli polynomial
+    constexpr std::uint32_t polynomial = 0x82F63B78;
+
+    /// tables[k][b] is the CRC of byte b followed by k zero bytes, for slicing by eight
+    constexpr auto tables = [] {
+        std::array<std::array<std::uint32_t, 256>, 8> result { };
+        for (std::uint32_t byte = 0; byte < 256; ++byte) {
+            std::uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (polynomial & (0U - (crc & 1)));
+            result[0][byte] = crc;
+        }
+        for (std::size_t k = 1; k < 8; ++k) {
+            for (std::size_t byte = 0; byte < 256; ++byte) {
+                std::uint32_t previous = result[k - 1][byte];
+                result[k][byte] = (previous >> 8) ^ result[0][previous & 0xFF];
+            }
+        }
+        return result;
+    }();
+}
+
+/**
+ * @brief Computes the checksum of a buffer.
+ *
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @param crc  The checksum of the preceding bytes, to checksum a buffer in pieces.
+ * @return The checksum.
+ */
+auto crc32c::compute(const void *data, std::size_t size, std::uint32_t crc) -> std::uint32_t {
+    const auto *bytes = static_cast<const std::uint8_t*>(data);
+#if defined(__x86_64__)
+    if (hardware()) return ~sse42(bytes, size, ~crc);
+#endif
+    return ~software(bytes, size, ~crc);
+}
+
+auto crc32c::compute(std::string_view data, std::uint32_t crc) -> std::uint32_t {
+    return compute(data.data(), data.size(), crc);
+}
+
+/**
+ * @brief Returns whether the checksums are computed with SSE4.2.
+ */
+auto crc32c::hardware() -> bool {
+#if defined(__x86_64__)
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Processes eight bytes per step with one table lookup per byte.
+ */
+auto crc32c::software(const std::uint8_t *data, std::size_t size, std::uint32_t state) -> std::uint32_t {
+    while (size >= 8) {
+        std::uint32_t low = state ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<std::uint32_t>(data[3]) << 24);
+        state = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF]
+                ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+                ^ tables[3][data[4]] ^ tables[2][data[5]] ^ tables[1][data[6]] ^ tables[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) state = (state >> 8) ^ tables[0][(state ^ *data++) & 0xFF];
+    return state;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief Processes eight bytes per crc32 instruction.
+ */
+__attribute__((target("sse4.2")))
+auto crc32c::sse42(const std::uint8_t *data, std::size_t size, std::uint32_t state) -> std::uint32_t {
+    std::uint64_t wide = state;
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+        data += 8;
+        size -= 8;
+    }
+    state = static_cast<std::uint32_t>(wide);
+    while (size-- > 0) state = _mm_crc32_u8(state, *data++);
+    return state;
+}
+#endif
@@ -3,8 +3,11 @@
  * See LICENSE file for license details
  */
 
-#include <fstream>
+#include "../include/argon2.hpp"
 #include "../include/cryptor.hpp"
+#include "../include/trace.hpp"
+#include "../include/metrics.hpp"
+#include "../include/memory_tracker.hpp"
 
 /**
  * @brief Encrypts the plaintext using the provided key.
@@ -13,10 +16,10 @@
  * @param key       The encryption key.
  * @return The encrypted ciphertext.
  */
-auto cryptor::encrypt(const std::string &plaintext,
-                      const std::string &key) -> std::string {
+auto cryptor::encrypt(std::string_view plaintext,
+                      std::string_view key) -> std::pmr::string {
     std::size_t key_index = 0;
-    std::string cipher_text = plaintext;
+    std::pmr::string cipher_text(plaintext);
 
     for (char &i : cipher_text) {
         /// Add the key value to the plaintext character and take modulo 256
@@ -38,10 +41,10 @@ auto cryptor::encrypt(const std::string &plaintext,
  * @param key        The encryption key.
  * @return The decrypted plaintext.
  */
-[[maybe_unused]] auto cryptor::decrypt(const std::string &ciphertext,
-                      const std::string &key) -> std::string {
+[[maybe_unused]] auto cryptor::decrypt(std::string_view ciphertext,
+                      std::string_view key) -> std::pmr::string {
     std::size_t key_index = 0;
-    std::string plain_text = ciphertext;
+    std::pmr::string plain_text(ciphertext);
 
     for (char &i : plain_text) {
         /// XOR the ciphertext character with the lower 8 bits of the key value
@@ -62,8 +65,11 @@ auto cryptor::encrypt(const std::string &plaintext,
  * @param passwords        The map of passwords to encrypt.
  * @param encryption_key   The encryption key.
  */
-auto cryptor::encrypt_map(std::map<std::size_t, std::string> &passwords,
-                          const std::string &encryption_key) -> void {
+auto cryptor::encrypt_map(std::pmr::map<std::size_t, std::pmr::string> &passwords,
+                          std::string_view encryption_key) -> void {
+    metrics::timer timer(metrics::metric::encrypt_map);
+    TRACE_SPAN("cryptor::encrypt_map");
+
     for (auto& [key, value] : passwords) {
         value = encrypt(value, encryption_key);
     }
@@ -73,56 +79,55 @@ auto cryptor::encrypt_map(std::map<std::size_t, std::string> &passwords,
  * @brief Initializes encryption for a given category.
  *        Encrypts the passwords in the category map and writes the encrypted data to a file.
  *
+ * The typed secret is stretched with Argon2id under a fresh salt, the salt
+ * and the costs are written on the first line of the file so the key can
+ * be derived again.
+ *
  * @param category The category to initialize encryption for.
  */
 auto cryptor::initialize_encrypt(categories &category) -> void {
-    if (!category.is_printable()) return;
+    if (category.empty()) {
+        fmt::print("\n[-] No Category Found\n");
+        return;
+    }
     fmt::print("Enter the secret key: ");
 
-    std::string key;
+    std::pmr::string secret;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::getline(std::cin, key);
+    std::getline(std::cin, secret);
 
-    _secret_key = std::move(key);
+    argon2::parameters cost = argon2::configured();
+    std::string salt = argon2::generate_salt();
+    std::pmr::string key = argon2::derive(secret, salt, cost);
+    memory_tracker::scope scope(memory_tracker::transient::encrypt);
 
     for (auto& [category_ID, _category] : category.categories_map) {
-        encrypt_map(_category.passwords, _secret_key);
-        write(category, _category.passwords, "encrypted_map.txt");
+        TRACE_SPAN_ARG("cryptor::encrypt_category", category_ID);
+        encrypt_map(_category.passwords, key);
     }
 
+    /// Write the whole vault once, after every category is encrypted
+    std::string preamble = fmt::format("KDF: argon2id m={},t={},p={} Salt: ", cost.memory_kib, cost.passes, cost.lanes);
+    for (unsigned char byte : salt) preamble += fmt::format("{:02x}", byte);
+    preamble += '\n';
+    if (!write(category, "encrypted_map.txt", preamble)) return;
+
     fmt::print("[+] All Data Encrypted Successfully\n");
 }
 
 /**
  * @brief Writes the category and password data to a file.
  *
+ * Every category is written together with its own passwords,
+ * using the text layout of the export engine.
+ *
  * @param category The category object.
- * @param data     The map of password data.
  * @param filename The name of the file to write to.
+ * @param preamble Written before the categories.
  * @return True if the write operation was successful, false otherwise.
  */
-auto cryptor::write(const categories &category,
-                    const std::map<std::size_t, std::string> &data,
-                    const std::string &filename) -> bool {
-    std::ofstream file(filename);
-
-    if (!file) {
-        fmt::print("[-] Failed to Open the File '{}'", filename);
-        return false;
-    }
-
-    file << "\n----------- Categories -----------\n";
-    for (const auto &element : category.categories_map) {
-        file << "[+] ID: " << element.second.ID <<
-             " Name: " << element.second.name << '\n' << " Passwords:\n";
-        for (const auto& [key, value] : data) {
-            file << "ID: " << key << " Pass: " << value << '\n';
-        }
-        file << '\n';
-    }
-
-    file.close();
-
-    fmt::print("[+] Map data written to file '{}'\n", filename);
-    return true;
-}
\ No newline at end of file
+auto cryptor::write(const categories &category, const std::string &filename, std::string_view preamble) -> bool {
+    metrics::timer timer(metrics::metric::cryptor_write);
+    TRACE_SPAN("cryptor::write");
+    return exporter::write(category, {}, filename, exporter::format::text, false, preamble);
+}
@@ -0,0 +1,365 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <future>
+#include <thread>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include "../include/trace.hpp"
+#include "../include/metrics.hpp"
+#include "../include/exporter.hpp"
+
+namespace {
+    /// Returns the length of the well-formed UTF-8 sequence the text starts with, 0 if there is none.
+    /// Overlong forms, surrogates and code points past U+10FFFF are not well-formed.
+    auto sequence_length(std::string_view text) -> std::size_t {
+        auto byte = [&text](std::size_t i) { return static_cast<unsigned char>(text[i]); };
+        unsigned char first = byte(0);
+        if (first < 0x80) return 1;
+
+        std::size_t length = 0;
+        unsigned char low = 0x80, high = 0xBF;
+        if (first >= 0xC2 && first <= 0xDF) {
+            length = 2;
+        } else if (first >= 0xE0 && first <= 0xEF) {
+            length = 3;
+            if (first == 0xE0) low = 0xA0;
+            if (first == 0xED) high = 0x9F;
+        } else if (first >= 0xF0 && first <= 0xF4) {
+            length = 4;
+            if (first == 0xF0) low = 0x90;
+            if (first == 0xF4) high = 0x8F;
+        } else return 0;
+
+        if (text.size() < length || byte(1) < low || byte(1) > high) return 0;
+        for (std::size_t i = 2; i < length; ++i) {
+            if ((byte(i) & 0xC0) != 0x80) return 0;
+        }
+        return length;
+    }
+
+    auto valid_utf8(std::string_view text) -> bool {
+        for (std::size_t i = 0; i < text.size();) {
+            std::size_t length = sequence_length(text.substr(i));
+            if (length == 0) return false;
+            i += length;
+        }
+        return true;
+    }
+
+    /// Standard base64 with padding
+    auto append_base64(fmt::memory_buffer &buffer, std::string_view value) -> void {
+        constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        auto byte = [&value](std::size_t i) -> std::uint32_t {
+            return i < value.size() ? static_cast<unsigned char>(value[i]) : 0;
+        };
+
+        for (std::size_t i = 0; i < value.size(); i += 3) {
+            std::uint32_t group = byte(i) << 16 | byte(i + 1) << 8 | byte(i + 2);
+            std::size_t produced = std::min<std::size_t>(value.size() - i, 3) + 1;
+            for (std::size_t j = 0; j < 4; ++j) {
+                buffer.push_back(j < produced ? alphabet[(group >> (18 - 6 * j)) & 0x3F] : '=');
+            }
+        }
+    }
+}
+
+/**
+ * @brief Prompts the user for an export format and file name and exports the vault.
+ *
+ * @param category The categories object to export.
+ * @param password The passwords object holding the password list.
+ */
+auto exporter::initialize_export(const categories &category, const passwords &password) -> void {
+    fmt::print("Export Format ([1] Text, [2] CSV, [3] JSON Lines): ");
+    std::string format_input;
+    std::cin >> format_input;
+
+    std::optional<format> type = parse_format(format_input);
+    if (!type.has_value()) {
+        fmt::print("\n[-] Unknown Export Format\n");
+        return;
+    }
+
+    fmt::print("Enter the File Name: ");
+    std::string filename;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, filename);
+
+    fmt::print("Format Categories in Parallel? (Y/N): ");
+    std::string confirmation;
+    std::cin >> confirmation;
+    bool parallel = confirmation.size() == 1 && std::toupper(confirmation[0]) == 'Y';
+
+    write(category, password.get_passwords(), filename, *type, parallel);
+}
+
+/**
+ * @brief Maps a menu choice or format name to an export format.
+ *
+ * @param name Either the menu number ("1", "2", "3") or the format name.
+ * @return The matching format, or an empty optional if the name is unknown.
+ */
+auto exporter::parse_format(const std::string &name) -> std::optional<format> {
+    if (name == "1" || name == "text") return format::text;
+    if (name == "2" || name == "csv") return format::csv;
+    if (name == "3" || name == "json" || name == "jsonl") return format::json_lines;
+
+    return std::nullopt;
+}
+
+/**
+ * @brief Exports the categories and the password list to a file.
+ *
+ * Records are formatted into memory buffers and written in large blocks.
+ * When parallel is set, every category is formatted on its own task and
+ * the resulting buffers are written in category order.
+ *
+ * @param category      The categories object to export.
+ * @param uncategorized The passwords that do not belong to a category.
+ * @param filename      The name of the file to write to.
+ * @param type          The output format.
+ * @param parallel      Whether to format categories concurrently.
+ * @param preamble      Written verbatim before the format header.
+ * @return True if the export was successful, false otherwise.
+ */
+auto exporter::write(const categories &category,
+                     const std::pmr::map<std::size_t, passwords::password> &uncategorized,
+                     const std::string &filename, format type, bool parallel, std::string_view preamble) -> bool {
+    metrics::timer timer(metrics::metric::export_write);
+    TRACE_SPAN("exporter::write");
+    std::ofstream file(filename, std::ios::binary);
+
+    if (!file) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    fmt::memory_buffer buffer;
+    buffer.append(preamble.data(), preamble.data() + preamble.size());
+    format_header(buffer, type);
+
+    if (parallel && category.categories_map.size() > 1) {
+        /// Format at most one wave of categories per hardware thread,
+        /// so only that many category buffers are alive at the same time
+        std::size_t wave_size = std::max(1U, std::thread::hardware_concurrency());
+        auto it = category.categories_map.begin();
+
+        while (it != category.categories_map.end()) {
+            std::vector<std::future<fmt::memory_buffer>> wave;
+            wave.reserve(wave_size);
+
+            for (; it != category.categories_map.end() && wave.size() < wave_size; ++it) {
+                const categories::category &current = it->second;
+                wave.push_back(std::async(std::launch::async, [&current, type]() {
+                    TRACE_SPAN_ARG("exporter::format_category", current.ID);
+                    fmt::memory_buffer category_buffer;
+                    format_category(category_buffer, current, type);
+                    return category_buffer;
+                }));
+            }
+
+            for (auto &task : wave) {
+                fmt::memory_buffer category_buffer = task.get();
+                flush(file, buffer);
+                flush(file, category_buffer);
+            }
+        }
+    } else {
+        for (const auto &element : category.categories_map) {
+            TRACE_SPAN_ARG("exporter::format_category", element.first);
+            format_category(buffer, element.second, type, &file);
+        }
+    }
+
+    format_uncategorized(buffer, uncategorized, type, &file);
+    flush(file, buffer);
+    {
+        TRACE_SPAN("exporter::close");
+        file.close();
+    }
+
+    if (!file) {
+        fmt::print("[-] Failed to Write the File '{}'\n", filename);
+        return false;
+    }
+
+    fmt::print("[+] Map data written to file '{}'\n", filename);
+    return true;
+}
+
+/**
+ * @brief Appends the format specific file header to the buffer.
+ */
+auto exporter::format_header(fmt::memory_buffer &buffer, format type) -> void {
+    switch (type) {
+        case format::text:
+            fmt::format_to(std::back_inserter(buffer), "\n----------- Categories -----------\n");
+            break;
+        case format::csv:
+            fmt::format_to(std::back_inserter(buffer), "category_id,category_name,password_id,password\n");
+            break;
+        case format::json_lines: break;
+    }
+}
+
+/**
+ * @brief Formats every password of a category into the buffer.
+ *
+ * @param buffer   The buffer to append to.
+ * @param category The category to format.
+ * @param type     The output format.
+ * @param file     When set, the buffer is flushed to it whenever it grows past one block.
+ */
+auto exporter::format_category(fmt::memory_buffer &buffer, const categories::category &category,
+                               format type, std::ofstream *file) -> void {
+    auto out = std::back_inserter(buffer);
+
+    if (type == format::text) {
+        fmt::format_to(out, "[+] ID: {} Name: {}\n Passwords:\n", category.ID, category.name);
+    }
+
+    for (const auto &[key, value] : category.passwords) {
+        switch (type) {
+            case format::text:
+                fmt::format_to(out, "ID: {} Pass: {}\n", key, value);
+                break;
+            case format::csv:
+                fmt::format_to(out, "{},", category.ID);
+                append_escaped(buffer, category.name, type);
+                fmt::format_to(out, ",{},", key);
+                append_escaped(buffer, value, type);
+                buffer.push_back('\n');
+                break;
+            case format::json_lines:
+                fmt::format_to(out, "{{\"category_id\":{},", category.ID);
+                append_json(buffer, "category", category.name);
+                fmt::format_to(out, ",\"id\":{},", key);
+                append_json(buffer, "password", value);
+                fmt::format_to(out, "}}\n");
+                break;
+        }
+
+        if (file != nullptr && buffer.size() >= _block_size) flush(*file, buffer);
+    }
+
+    if (type == format::text) buffer.push_back('\n');
+}
+
+/**
+ * @brief Formats the password list into the buffer.
+ *
+ * @param buffer        The buffer to append to.
+ * @param uncategorized The passwords that do not belong to a category.
+ * @param type          The output format.
+ * @param file          When set, the buffer is flushed to it whenever it grows past one block.
+ */
+auto exporter::format_uncategorized(fmt::memory_buffer &buffer,
+                                    const std::pmr::map<std::size_t, passwords::password> &uncategorized,
+                                    format type, std::ofstream *file) -> void {
+    if (uncategorized.empty()) return;
+    auto out = std::back_inserter(buffer);
+
+    if (type == format::text) fmt::format_to(out, "----------- Password List -----------\n");
+
+    for (const auto &[key, value] : uncategorized) {
+        switch (type) {
+            case format::text:
+                fmt::format_to(out, "ID: {} Pass: {}\n", key, value.name);
+                break;
+            case format::csv:
+                fmt::format_to(out, ",,{},", key);
+                append_escaped(buffer, value.name, type);
+                buffer.push_back('\n');
+                break;
+            case format::json_lines:
+                fmt::format_to(out, "{{\"category_id\":null,\"category\":null,\"id\":{},", key);
+                append_json(buffer, "password", value.name);
+                fmt::format_to(out, "}}\n");
+                break;
+        }
+
+        if (file != nullptr && buffer.size() >= _block_size) flush(*file, buffer);
+    }
+}
+
+/**
+ * @brief Appends a value to the buffer, quoted and escaped for the given format.
+ *
+ * CSV fields are always quoted with embedded quotes doubled, JSON strings
+ * escape quotes, backslashes and control characters. JSON has to be valid
+ * UTF-8, so every byte that is not part of a well-formed sequence becomes
+ * U+FFFD, append_json() keeps the exact bytes next to it. Text is appended as is.
+ */
+auto exporter::append_escaped(fmt::memory_buffer &buffer, std::string_view value, format type) -> void {
+    if (type == format::text) {
+        buffer.append(value.data(), value.data() + value.size());
+        return;
+    }
+
+    auto append = [&buffer](std::string_view escaped) -> void {
+        buffer.append(escaped.data(), escaped.data() + escaped.size());
+    };
+
+    buffer.push_back('"');
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (type == format::csv) {
+            if (c == '"') buffer.push_back('"');
+            buffer.push_back(c);
+            continue;
+        }
+
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            std::size_t length = sequence_length(value.substr(i));
+            if (length == 0) {
+                append("\\ufffd");
+                continue;
+            }
+            append(value.substr(i, length));
+            i += length - 1;
+            continue;
+        }
+
+        switch (c) {
+            case '"':  append("\\\""); break;
+            case '\\': append("\\\\"); break;
+            case '\n': append("\\n"); break;
+            case '\r': append("\\r"); break;
+            case '\t': append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fmt::format_to(std::back_inserter(buffer), "\\u{:04x}",
+                                   static_cast<unsigned char>(c));
+                } else buffer.push_back(c);
+        }
+    }
+    buffer.push_back('"');
+}
+
+/**
+ * @brief Appends a JSON member, followed by "<name>_b64" with the exact bytes
+ * when the value is not valid UTF-8 and its string had to replace some of them.
+ */
+auto exporter::append_json(fmt::memory_buffer &buffer, std::string_view name, std::string_view value) -> void {
+    fmt::format_to(std::back_inserter(buffer), "\"{}\":", name);
+    append_escaped(buffer, value, format::json_lines);
+    if (valid_utf8(value)) return;
+
+    fmt::format_to(std::back_inserter(buffer), ",\"{}_b64\":\"", name);
+    append_base64(buffer, value);
+    buffer.push_back('"');
+}
+
+/**
+ * @brief Writes the buffer to the file in a single block and clears it.
+ */
+auto exporter::flush(std::ofstream &file, fmt::memory_buffer &buffer) -> void {
+    if (buffer.size() == 0) return;
+    TRACE_SPAN("exporter::flush");
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
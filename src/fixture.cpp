@@ -0,0 +1,159 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include "../include/fixture.hpp"
+#include "../include/dictionaries.hpp"
+
+/**
+ * @brief Replaces the vault with a synthetic one of the given shape.
+ *
+ * @param layout   The shape of the vault.
+ * @param category The categories object to fill.
+ * @param password The passwords object to fill.
+ */
+auto fixture::build(const shape &layout, categories &category, passwords &password) -> void {
+    std::size_t uncategorized = layout.categories == 0
+            ? layout.entries
+            : std::min(layout.entries, static_cast<std::size_t>(std::llround(layout.entries * layout.uncategorized)));
+    std::vector<std::size_t> sizes = category_sizes(layout, layout.entries - uncategorized);
+
+    std::size_t slice_count = (uncategorized + _list_slice - 1) / _list_slice;
+    std::size_t unit_count = layout.categories + slice_count;
+    std::vector<categories::category> built(layout.categories);
+    std::vector<std::pmr::map<std::size_t, passwords::password>> slices(slice_count);
+
+    /// Every unit draws from its own engine, so the result does not depend on which thread built it
+    std::atomic<std::size_t> next_unit = 0;
+    auto work = [&]() {
+        for (std::size_t unit = next_unit++; unit < unit_count; unit = next_unit++) {
+            std::mt19937_64 engine(unit_seed(layout.seed, unit));
+
+            if (unit < layout.categories) {
+                categories::category &element = built[unit];
+                element.ID = unit + 1;
+                element.name = category_name(engine, layout, element.ID);
+                for (std::size_t ID = 1; ID <= sizes[unit]; ++ID) {
+                    element.passwords.emplace_hint(element.passwords.end(), ID,
+                                                   passwords::generator(engine, password_length(engine, layout),
+                                                                        true, true, true));
+                }
+                element._pass_id = sizes[unit] + 1;
+                continue;
+            }
+
+            std::size_t slice = unit - layout.categories;
+            std::size_t first = slice * _list_slice;
+            std::size_t last = std::min(first + _list_slice, uncategorized);
+            for (std::size_t ID = first + 1; ID <= last; ++ID) {
+                std::string value = passwords::generator(engine, password_length(engine, layout), true, true, true);
+                slices[slice].emplace_hint(slices[slice].end(), ID, passwords::password { ID, std::pmr::string(value) });
+            }
+        }
+    };
+
+    std::size_t thread_count = layout.threads != 0 ? layout.threads : std::max(1U, std::thread::hardware_concurrency());
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < std::min(thread_count, unit_count); ++i) workers.emplace_back(work);
+        work();
+    }
+
+    category.categories_map.clear();
+    for (categories::category &element : built) {
+        category.categories_map.emplace_hint(category.categories_map.end(), element.ID, std::move(element));
+    }
+    category._current_ID = layout.categories + 1;
+
+    /// The slices hold consecutive IDs, so their nodes are moved over in order without copying
+    password._pass_without_categories.clear();
+    for (auto &slice : slices) {
+        while (!slice.empty()) {
+            password._pass_without_categories.insert(password._pass_without_categories.end(),
+                                                     slice.extract(slice.begin()));
+        }
+    }
+    password._current_ID = uncategorized + 1;
+}
+
+/**
+ * @brief Checks that a shape describes a vault that can be built.
+ */
+auto fixture::valid(const shape &layout) -> bool {
+    return layout.skew >= 0 && layout.uncategorized >= 0 && layout.uncategorized <= 1
+           && layout.length_mean > 0 && layout.length_deviation >= 0
+           && layout.name_mean > 0 && layout.name_deviation >= 0;
+}
+
+/**
+ * @brief Splits the categorized passwords over the categories by a Zipf law.
+ *
+ * Sizes are rounded down and the rest goes to the largest categories.
+ * The sizes are then shuffled, so the largest category is not always the first.
+ */
+auto fixture::category_sizes(const shape &layout, std::size_t categorized) -> std::vector<std::size_t> {
+    std::vector<std::size_t> sizes(layout.categories, 0);
+    if (sizes.empty()) return sizes;
+
+    std::vector<double> weights(layout.categories);
+    for (std::size_t i = 0; i < weights.size(); ++i) weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), layout.skew);
+    double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    std::size_t assigned = 0;
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        sizes[i] = static_cast<std::size_t>(static_cast<double>(categorized) * weights[i] / total);
+        assigned += sizes[i];
+    }
+    for (std::size_t i = 0; assigned < categorized; i = (i + 1) % sizes.size(), ++assigned) ++sizes[i];
+
+    std::mt19937_64 engine(unit_seed(layout.seed, UINT64_MAX));
+    std::shuffle(sizes.begin(), sizes.end(), engine);
+    return sizes;
+}
+
+/**
+ * @brief Makes a category name of capitalized dictionary words, ending with the ID so names stay unique.
+ */
+auto fixture::category_name(std::mt19937_64 &engine, const shape &layout, std::size_t ID) -> std::string {
+    std::normal_distribution<double> length(layout.name_mean, layout.name_deviation);
+    std::uniform_int_distribution<std::size_t> pick(0, dictionaries::words.size() - 1);
+
+    std::string suffix = fmt::format(" {}", ID);
+    std::size_t target = static_cast<std::size_t>(std::clamp<long long>(std::llround(length(engine)), 4, 64));
+    std::size_t text_length = target > suffix.size() ? target - suffix.size() : 1;
+
+    std::string name;
+    while (name.size() < text_length) {
+        if (!name.empty()) name += ' ';
+        std::string_view word = dictionaries::words[pick(engine)];
+        name += static_cast<char>(std::toupper(static_cast<unsigned char>(word.front())));
+        name += word.substr(1);
+    }
+    name.resize(text_length);
+    if (name.back() == ' ') name.pop_back();
+    return name + suffix;
+}
+
+/**
+ * @brief Draws a password length from the normal distribution of the shape.
+ */
+auto fixture::password_length(std::mt19937_64 &engine, const shape &layout) -> int {
+    std::normal_distribution<double> length(layout.length_mean, layout.length_deviation);
+    return static_cast<int>(std::clamp<long long>(std::llround(length(engine)), 8, 50));
+}
+
+/**
+ * @brief Derives the seed of one unit of work with SplitMix64.
+ */
+auto fixture::unit_seed(std::uint64_t seed, std::uint64_t unit) -> std::uint64_t {
+    std::uint64_t mixed = seed + (unit + 1) * 0x9E3779B97F4A7C15ULL;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    return mixed ^ (mixed >> 31);
+}
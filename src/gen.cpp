@@ -0,0 +1,114 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <chrono>
+#include <charconv>
+#include <string_view>
+#include <fmt/core.h>
+
+#include "../include/fixture.hpp"
+#include "../include/exporter.hpp"
+#include "../include/vault_file.hpp"
+
+/**
+ * @brief Parses a whole argument as a number.
+ */
+template <typename T>
+static auto parse_number(std::string_view text, T &value) -> bool {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+/**
+ * @brief Parses "MEAN" or "MEAN:DEVIATION", a missing deviation is left unchanged.
+ */
+static auto parse_distribution(std::string_view text, double &mean, double &deviation) -> bool {
+    std::size_t colon = text.find(':');
+    if (colon == std::string_view::npos) return parse_number(text, mean);
+    return parse_number(text.substr(0, colon), mean) && parse_number(text.substr(colon + 1), deviation);
+}
+
+static auto print_usage(const char *program) -> void {
+    fmt::print(stderr, "Usage: {} <output> [options]\n"
+                       "  --format vault|text|csv|jsonl   Output format, vault by default\n"
+                       "  --categories <count>            Number of categories\n"
+                       "  --entries <count>               Number of passwords in the vault\n"
+                       "  --skew <exponent>               Zipf exponent of the category sizes\n"
+                       "  --uncategorized <ratio>         Share of passwords outside of categories\n"
+                       "  --length <mean>[:<deviation>]   Password length distribution\n"
+                       "  --name-length <mean>[:<dev>]    Category name length distribution\n"
+                       "  --seed <number>                 The same seed gives the same passwords\n"
+                       "  --threads <count>               Worker threads, all cores by default\n", program);
+}
+
+auto main(int argc, char *argv[]) -> int {
+    if (argc < 2 || argc % 2 != 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::string output = argv[1];
+    std::string format_name = "vault";
+    fixture::shape layout;
+
+    for (int i = 2; i < argc; i += 2) {
+        std::string_view option = argv[i], value = argv[i + 1];
+        bool parsed = true;
+        if (option == "--format") format_name = value;
+        else if (option == "--categories") parsed = parse_number(value, layout.categories);
+        else if (option == "--entries") parsed = parse_number(value, layout.entries);
+        else if (option == "--skew") parsed = parse_number(value, layout.skew);
+        else if (option == "--uncategorized") parsed = parse_number(value, layout.uncategorized);
+        else if (option == "--length") parsed = parse_distribution(value, layout.length_mean, layout.length_deviation);
+        else if (option == "--name-length") parsed = parse_distribution(value, layout.name_mean, layout.name_deviation);
+        else if (option == "--seed") parsed = parse_number(value, layout.seed);
+        else if (option == "--threads") parsed = parse_number(value, layout.threads);
+        else parsed = false;
+
+        if (!parsed) {
+            fmt::print(stderr, "[-] Invalid Option '{} {}'\n", option, value);
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::optional<exporter::format> type;
+    if (format_name != "vault" && !(type = exporter::parse_format(format_name))) {
+        fmt::print(stderr, "[-] Unknown Format '{}'\n", format_name);
+        return 2;
+    }
+    if (!fixture::valid(layout)) {
+        fmt::print(stderr, "[-] Invalid Vault Shape\n");
+        return 2;
+    }
+
+    /// Fixtures are not secrets and would not fit into locked memory, so the default resource is kept
+    categories category;
+    passwords password;
+
+    auto start = std::chrono::steady_clock::now();
+    fixture::build(layout, category, password);
+    std::chrono::duration<double> built = std::chrono::steady_clock::now() - start;
+    fmt::print("[+] Built {} Categories and {} Passwords in {:.2f} s\n",
+               category.categories_map.size(), layout.entries, built.count());
+
+    start = std::chrono::steady_clock::now();
+    bool written;
+    if (type) {
+        written = exporter::write(category, password.get_passwords(), output, *type, true);
+    } else {
+        std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+        if (key.empty()) {
+            fmt::print(stderr, "[-] The Secret Key Cannot Be Empty\n");
+            return 1;
+        }
+        written = vault_file::save(category, password, output, key);
+    }
+    if (!written) return 1;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("[+] Wrote '{}' in {:.2f} s\n", output, elapsed.count());
+    return 0;
+}
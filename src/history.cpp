@@ -0,0 +1,180 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include "../include/trace.hpp"
+#include "../include/keyring.hpp"
+#include "../include/history.hpp"
+#include "../include/name_index.hpp"
+
+/**
+ * @brief Records a category, including all of its passwords, in the live version.
+ * @param category The category to record.
+ */
+auto history::put_category(const categories::category &category) -> void {
+    name_index::put_category(category, _current.categories_map.find(category.ID));
+    _current.put_category(category);
+}
+
+/**
+ * @brief Removes a category from the live version.
+ * @param category_ID The ID of the removed category.
+ */
+auto history::erase_category(std::size_t category_ID) -> void {
+    name_index::erase_category(category_ID, _current.categories_map.find(category_ID));
+    _current.categories_map.erase(category_ID);
+}
+
+/**
+ * @brief Records a password added to or edited in a category.
+ *
+ * @param category_ID The ID of the category holding the password.
+ * @param password_ID The ID of the password inside of the category.
+ * @param password    The new password value.
+ */
+auto history::put_password(std::size_t category_ID, std::size_t password_ID,
+                           std::string_view password) -> void {
+    const vault_state::category_version *existing = _current.categories_map.find(category_ID);
+    if (existing == nullptr) return;
+
+    name_index::put_password(category_ID, password_ID, password, existing->passwords.find(password_ID));
+    _current.put_password(category_ID, password_ID, password);
+}
+
+/**
+ * @brief Removes a password of a category from the live version.
+ * @param category_ID The ID of the category holding the password.
+ * @param password_ID The ID of the removed password.
+ */
+auto history::erase_password(std::size_t category_ID, std::size_t password_ID) -> void {
+    const vault_state::category_version *existing = _current.categories_map.find(category_ID);
+    if (existing == nullptr) return;
+
+    name_index::erase_password(category_ID, password_ID, existing->passwords.find(password_ID));
+    _current.erase_password(category_ID, password_ID);
+}
+
+/**
+ * @brief Records a password added to or edited in the password list.
+ * @param password The password to record.
+ */
+auto history::put_uncategorized(const passwords::password &password) -> void {
+    const passwords::password *replaced = _current.uncategorized.find(password.ID);
+    name_index::put_password(keyring::list_ID, password.ID, password.name, replaced ? &replaced->name : nullptr);
+    _current.uncategorized.insert(password.ID, password);
+}
+
+/**
+ * @brief Removes a password of the password list from the live version.
+ * @param password_ID The ID of the removed password.
+ */
+auto history::erase_uncategorized(std::size_t password_ID) -> void {
+    const passwords::password *removed = _current.uncategorized.find(password_ID);
+    name_index::erase_password(keyring::list_ID, password_ID, removed ? &removed->name : nullptr);
+    _current.uncategorized.erase(password_ID);
+}
+
+/**
+ * @brief Rebuilds the live version from scratch.
+ *
+ * Used after operations that touch every record anyway, such as
+ * sorting (which renumbers categories) or encrypting the vault.
+ *
+ * @param category The categories object to mirror.
+ * @param password The passwords object to mirror.
+ */
+auto history::rebuild(const categories &category, const passwords &password) -> void {
+    TRACE_SPAN("history::rebuild");
+    _current.assign(category, password);
+    name_index::rebuild(category, password);
+}
+
+/**
+ * @brief Drops the live version, every undo step and the name index.
+ *
+ * Called at shutdown, before the arena that holds their nodes is released.
+ */
+auto history::clear() -> void {
+    _current = {};
+    _committed = {};
+    _undo.clear();
+    _redo.clear();
+    name_index::clear();
+}
+
+/**
+ * @brief Closes the current undo step.
+ *
+ * Takes an O(1) snapshot of the live version. Nothing is
+ * recorded when the vault did not change since the last commit.
+ *
+ * @param label Short description of the operation, shown on undo and redo.
+ */
+auto history::commit(const std::string &label) -> void {
+    TRACE_SPAN("history::commit");
+    if (_current.same(_committed)) return;
+
+    _current.label = label;
+    _undo.push_back(std::move(_committed));
+    if (_undo.size() > _max_depth) _undo.pop_front();
+
+    _committed = _current;
+    _redo.clear();
+}
+
+/**
+ * @brief Reverts the vault to the state before the last committed operation.
+ * @param category The categories object to restore.
+ * @param password The passwords object to restore.
+ */
+auto history::undo(categories &category, passwords &password) -> void {
+    if (_undo.empty()) {
+        fmt::print("\n[-] Nothing to Undo\n");
+        return;
+    }
+
+    std::string label = _committed.label;
+    _redo.push_back(std::move(_committed));
+    _committed = std::move(_undo.back());
+    _undo.pop_back();
+
+    _committed.restore(category, password);
+    _current = _committed;
+    name_index::rebuild(category, password);
+    fmt::print("\n[+] Undone: {}\n", label);
+}
+
+/**
+ * @brief Re-applies the last undone operation.
+ * @param category The categories object to restore.
+ * @param password The passwords object to restore.
+ */
+auto history::redo(categories &category, passwords &password) -> void {
+    if (_redo.empty()) {
+        fmt::print("\n[-] Nothing to Redo\n");
+        return;
+    }
+
+    _undo.push_back(std::move(_committed));
+    _committed = std::move(_redo.back());
+    _redo.pop_back();
+
+    _committed.restore(category, password);
+    _current = _committed;
+    name_index::rebuild(category, password);
+    fmt::print("\n[+] Redone: {}\n", _committed.label);
+}
+
+/**
+ * @brief Returns a point-in-time view of the vault.
+ *
+ * The returned version shares all nodes with the live one, so taking it is
+ * O(1) and later mutations never change what it sees. It can be handed to a
+ * background save or kept around for comparison.
+ *
+ * @return The live version of the vault.
+ */
+auto history::snapshot() -> version {
+    return _current;
+}
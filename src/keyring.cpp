@@ -0,0 +1,153 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <random>
+#include "../include/blake2b.hpp"
+#include "../include/cryptor.hpp"
+#include "../include/keyring.hpp"
+#include "../include/secure_arena.hpp"
+
+/**
+ * @brief Returns the data key of a category, creating one on first use.
+ *
+ * @param ID The category ID, or list_ID for the password list.
+ * @return A copy of the key, so the keyring may be replaced while it is used.
+ */
+auto keyring::data_key(std::size_t ID) -> std::pmr::string {
+    std::pmr::map<std::size_t, std::pmr::string> &current = keys();
+    auto found = current.find(ID);
+    if (found == current.end()) found = current.emplace(ID, generate()).first;
+    return found->second;
+}
+
+/**
+ * @brief Draws a new random data key.
+ */
+auto keyring::generate() -> std::pmr::string {
+    return random_bytes(key_size);
+}
+
+/**
+ * @brief Encrypts a data key with the master key for storage.
+ *
+ * @param ID         The category the key belongs to, bound into the blob.
+ * @param data_key   The data key.
+ * @param master_key The master key derived from the secret.
+ * @return The blob, with a fresh nonce.
+ */
+auto keyring::wrap(std::size_t ID, std::string_view data_key, std::string_view master_key) -> wrapped {
+    wrapped blob;
+    blob.nonce = random_bytes(nonce_size);
+
+    std::pmr::string key = wrapping_key(ID, blob.nonce, master_key);
+    blob.key.assign(data_key);
+    for (std::size_t i = 0; i < blob.key.size(); ++i) blob.key[i] ^= key[i % key.size()];
+
+    blob.check = authenticate(ID, blob, master_key);
+    return blob;
+}
+
+/**
+ * @brief Decrypts a stored data key.
+ *
+ * @param ID The category the blob was read for, a blob moved to another category does not unwrap.
+ * @return The data key, or std::nullopt if the master key is wrong or the blob was changed.
+ */
+auto keyring::unwrap(std::size_t ID, const wrapped &blob,
+                     std::string_view master_key) -> std::optional<std::pmr::string> {
+    if (blob.nonce.size() != nonce_size || blob.key.size() != key_size || blob.check.size() != check_size) {
+        return std::nullopt;
+    }
+    if (!equal(authenticate(ID, blob, master_key), blob.check)) return std::nullopt;
+
+    std::pmr::string key = wrapping_key(ID, blob.nonce, master_key);
+    std::pmr::string data_key(blob.key);
+    for (std::size_t i = 0; i < data_key.size(); ++i) data_key[i] ^= key[i % key.size()];
+    return data_key;
+}
+
+/**
+ * @brief Decrypts a data key of a vault written before the nonce-based wrapping.
+ *
+ * Those blobs are encrypted with the master key itself and carry an
+ * unkeyed hash of the data key. They are only read, every save and
+ * rekey writes the current format.
+ */
+auto keyring::unwrap_legacy(const wrapped &blob, std::string_view master_key) -> std::optional<std::pmr::string> {
+    if (blob.key.size() != key_size || blob.check.size() != check_size) return std::nullopt;
+
+    std::pmr::string data_key = cryptor::decrypt(blob.key, master_key);
+    std::string check(check_size, '\0');
+    blake2b::hash(check.data(), check_size, data_key.data(), data_key.size());
+    if (!equal(check, blob.check)) return std::nullopt;
+    return data_key;
+}
+
+/**
+ * @brief Derives the key a single blob is wrapped with.
+ */
+auto keyring::wrapping_key(std::size_t ID, std::string_view nonce,
+                           std::string_view master_key) -> std::pmr::string {
+    blake2b hasher(key_size, master_key);
+    hasher.update(_wrap_context);
+    hasher.update_u32(static_cast<std::uint32_t>(ID));
+    hasher.update_u32(static_cast<std::uint32_t>(static_cast<std::uint64_t>(ID) >> 32));
+    hasher.update(nonce);
+
+    std::pmr::string key(key_size, '\0');
+    hasher.final(key.data());
+    return key;
+}
+
+/**
+ * @brief Computes the MAC of a blob over its category ID, nonce and wrapped key.
+ */
+auto keyring::authenticate(std::size_t ID, const wrapped &blob, std::string_view master_key) -> std::string {
+    blake2b hasher(check_size, master_key);
+    hasher.update(_check_context);
+    hasher.update_u32(static_cast<std::uint32_t>(ID));
+    hasher.update_u32(static_cast<std::uint32_t>(static_cast<std::uint64_t>(ID) >> 32));
+    hasher.update(blob.nonce);
+    hasher.update(blob.key);
+
+    std::string check(check_size, '\0');
+    hasher.final(check.data());
+    return check;
+}
+
+/**
+ * @brief Compares two strings in time that only depends on their length.
+ */
+auto keyring::equal(std::string_view left, std::string_view right) -> bool {
+    if (left.size() != right.size()) return false;
+
+    unsigned char difference = 0;
+    for (std::size_t i = 0; i < left.size(); ++i) difference |= static_cast<unsigned char>(left[i] ^ right[i]);
+    return difference == 0;
+}
+
+auto keyring::random_bytes(std::size_t size) -> std::pmr::string {
+    std::random_device device;
+    std::pmr::string bytes(size, '\0');
+    for (char &byte : bytes) byte = static_cast<char>(device() & 0xFF);
+    return bytes;
+}
+
+/**
+ * @brief Replaces the keys of the open vault with the keys of a loaded one.
+ *
+ * The old keys are zeroized first. The new ones are copied into the keyring's
+ * own resource if the map was built on another one.
+ */
+auto keyring::replace(std::pmr::map<std::size_t, std::pmr::string> loaded) -> void {
+    std::pmr::map<std::size_t, std::pmr::string> &current = keys();
+    for (auto &[ID, key] : current) secure_arena::zeroize(key.data(), key.size());
+    current = std::move(loaded);
+}
+
+auto keyring::keys() -> std::pmr::map<std::size_t, std::pmr::string>& {
+    if (!_keys) _keys.emplace();
+    return *_keys;
+}
@@ -4,32 +4,169 @@
  */
 
 #include "../include/menu.hpp"
+#include "../include/argon2.hpp"
+#include "../include/workload.hpp"
+#include "../include/transaction.hpp"
+
+namespace {
+    /// Runs on every way out of main, after the vault objects declared below it are gone.
+    /// Drops the secrets held by static objects, then zeroizes and unmaps the arena.
+    struct shutdown {
+        shutdown() = default;
+        shutdown(const shutdown &) = delete;
+        auto operator=(const shutdown &) -> shutdown& = delete;
+
+        ~shutdown() {
+            vault_watcher::stop();
+            history::clear();
+            keyring::replace({});
+            secure_arena::instance().release();
+        }
+    };
+}
+
+auto main(int argc, char *argv[]) -> int {
+    /// Every vault container allocates its plaintext from the locked arena, through
+    /// the memory tracker, so it has to be installed before any of them is created
+    std::pmr::set_default_resource(&memory_tracker::instance());
+    metrics::configure();
+
+    shutdown release_arena;
 
-auto main() -> int {
     /// Creating the objects
     passwords password;
     categories category;
 
-    /// Creating the menu items
-    std::vector<menu::item> menu {
-            {1, "Add Category"},
-            {2, "Remove Category"},
-            {3, "Print Category"},
-            {4, "Search for Passwords"},
-            {5, "Sort Passwords"},
-            {6, "Add Password"},
-            {7, "Edit Password"},
-            {8, "Remove Password"},
-            {9, "Write Changes To File"},
-            {10, "Decryption Test"},
-            {0, "Exit"},
-    };
+    /// Daemon mode, serves the vault over a Unix domain socket instead of the menu
+    /// --sealed keeps the passwords encrypted in memory and caches the ones that are read
+    if (argc > 1 && std::string_view(argv[1]) == "--daemon") {
+        if (argc != 4 && (argc != 5 || std::string_view(argv[4]) != "--sealed")) {
+            fmt::print("Usage: {} --daemon <vault file> <socket path> [--sealed]\n", argv[0]);
+            return 1;
+        }
+
+        std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+        if (key.empty() || !vault_file::load(category, password, argv[2], key)) return 1;
+
+        std::optional<sealed_vault> sealed;
+        if (argc == 5) {
+            sealed.emplace(sealed_vault::configured());
+            sealed->seal(category, password);
+        }
+        bool served = vault_server::run(category, password, argv[3], sealed ? &*sealed : nullptr);
+        if (sealed) sealed->unseal(category, password);
+        if (!served) return 1;
+
+        /// Persist the passwords added through the daemon
+        return vault_file::save(category, password, argv[2], key) ? 0 : 1;
+    }
+
+    /// Compares two vault files, or makes the second one equal to the first one
+    if (argc > 1 && (std::string_view(argv[1]) == "--diff" || std::string_view(argv[1]) == "--sync")) {
+        if (argc != 4) {
+            fmt::print("Usage: {} {} <source vault> <target vault>\n", argv[0], argv[1]);
+            return 1;
+        }
+
+        bool synchronized = std::string_view(argv[1]) == "--diff" ? vault_sync::run_diff(argv[2], argv[3])
+                                                                  : vault_sync::run_sync(argv[2], argv[3]);
+        return synchronized ? 0 : 1;
+    }
+
+    /// Changes the secret of a vault file, --data also replaces the per-category data keys
+    if (argc > 1 && std::string_view(argv[1]) == "--rekey") {
+        if (argc != 3 && (argc != 4 || std::string_view(argv[3]) != "--data")) {
+            fmt::print("Usage: {} --rekey <vault file> [--data]\n", argv[0]);
+            return 1;
+        }
+
+        std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+        std::pmr::string new_key = vault_file::read_key("Enter the new secret key: ");
+        if (key.empty() || new_key.empty()) {
+            fmt::print("[-] The Secret Key Cannot Be Empty\n");
+            return 1;
+        }
+        return vault_file::rekey(argv[2], key, new_key, argc == 4) ? 0 : 1;
+    }
+
+    /// Lists the damaged records of a vault file, no secret is needed
+    if (argc > 1 && std::string_view(argv[1]) == "--verify") {
+        if (argc != 3) {
+            fmt::print("Usage: {} --verify <vault file>\n", argv[0]);
+            return 1;
+        }
+        return vault_file::verify(argv[2]) ? 0 : 1;
+    }
+
+    /// Applies a migration script to a vault file as one transaction, --check only validates it
+    if (argc > 1 && std::string_view(argv[1]) == "--apply") {
+        if (argc != 4 && (argc != 5 || std::string_view(argv[4]) != "--check")) {
+            fmt::print("Usage: {} --apply <vault file> <script> [--check]\n", argv[0]);
+            return 1;
+        }
+        return transaction::run(argv[2], argv[3], argc == 5) ? 0 : 1;
+    }
+
+    /// Writes a synthetic workload script for --replay
+    if (argc > 1 && std::string_view(argv[1]) == "--generate") {
+        if (argc != 4 && argc != 5) {
+            fmt::print("Usage: {} --generate <script> <operations> [seed]\n", argv[0]);
+            return 1;
+        }
+
+        std::size_t operations = std::strtoull(argv[3], nullptr, 10);
+        std::uint64_t seed = argc == 5 ? std::strtoull(argv[4], nullptr, 10) : 1;
+        return workload::generate(argv[2], operations, seed) ? 0 : 1;
+    }
+
+    /// Picks key derivation costs that unlock a vault in the target time on this machine
+    if (argc > 1 && std::string_view(argv[1]) == "--calibrate") {
+        if (argc > 3) {
+            fmt::print("Usage: {} --calibrate [milliseconds]\n", argv[0]);
+            return 1;
+        }
+
+        std::uint64_t target = argc == 3 ? std::strtoull(argv[2], nullptr, 10) : 500;
+        return argon2::calibrate(std::chrono::milliseconds(std::max<std::uint64_t>(target, 1))) ? 0 : 1;
+    }
+
+    /// Converts a sorted SHA-1 or NTLM hash list into an index for GUARDCIPHER_BREACH_INDEX
+    if (argc > 1 && std::string_view(argv[1]) == "--build-breach-index") {
+        if (argc < 4 || argc > 6 || (argc >= 5 && std::string_view(argv[4]) != "sha1" && std::string_view(argv[4]) != "ntlm")) {
+            fmt::print("Usage: {} --build-breach-index <hash list> <index file> [sha1|ntlm] [bloom bits per hash]\n", argv[0]);
+            return 1;
+        }
+
+        auto type = argc >= 5 && std::string_view(argv[4]) == "ntlm" ? breach_index::algorithm::ntlm
+                                                                      : breach_index::algorithm::sha1;
+        unsigned bloom_bits = argc == 6 ? static_cast<unsigned>(std::strtoul(argv[5], nullptr, 10)) : 10;
+        return breach_index::build(argv[2], argv[3], type, bloom_bits) ? 0 : 1;
+    }
+
+    /// Records the input of this session into a script
+    if (argc > 1 && std::string_view(argv[1]) == "--record") {
+        if (argc != 3) {
+            fmt::print("Usage: {} --record <script>\n", argv[0]);
+            return 1;
+        }
+        return workload::record(password, category, argv[2]) ? 0 : 1;
+    }
+
+    /// Feeds a recorded or generated script to the menu and reports the timings
+    if (argc > 1 && std::string_view(argv[1]) == "--replay") {
+        if (argc != 3 && argc != 4) {
+            fmt::print("Usage: {} --replay <script> [scale]\n", argv[0]);
+            return 1;
+        }
+
+        std::size_t scale = argc == 4 ? std::strtoull(argv[3], nullptr, 10) : 1;
+        return workload::replay(password, category, argv[2], std::max<std::size_t>(scale, 1)) ? 0 : 1;
+    }
 
     /// Passing the parameters to the process function
     /// @param password
     /// @param category
-    /// @param menu
-    menu::process(password, category, menu);
+    menu::process(password, category);
 
     return 0;
 }
@@ -0,0 +1,144 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <bit>
+#include <string>
+#include <cstring>
+#include "../include/md4.hpp"
+
+md4::md4() : _state { 0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U } { }
+
+auto md4::update(const void *data, std::size_t size) -> void {
+    const auto *bytes = static_cast<const std::uint8_t*>(data);
+    _length += size;
+
+    while (size > 0) {
+        std::size_t taken = std::min(size, _buffer.size() - _buffered);
+        std::memcpy(_buffer.data() + _buffered, bytes, taken);
+        _buffered += taken;
+        bytes += taken;
+        size -= taken;
+
+        if (_buffered == _buffer.size()) {
+            compress();
+            _buffered = 0;
+        }
+    }
+}
+
+/**
+ * @brief Pads the message and returns the digest, the object must not be used afterwards.
+ */
+auto md4::final() -> digest {
+    std::uint64_t bits = _length * 8;
+    constexpr std::uint8_t marker = 0x80;
+    update(&marker, 1);
+
+    constexpr std::uint8_t zero = 0;
+    while (_buffered != 56) update(&zero, 1);
+
+    std::uint8_t length[8];
+    for (int i = 0; i < 8; ++i) length[i] = static_cast<std::uint8_t>(bits >> (8 * i));
+    update(length, sizeof(length));
+
+    digest result;
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        result[i] = static_cast<std::uint8_t>(_state[i / 4] >> (8 * (i % 4)));
+    }
+    return result;
+}
+
+/**
+ * @brief Hashes a string in one call.
+ */
+auto md4::hash(std::string_view data) -> digest {
+    md4 hasher;
+    hasher.update(data.data(), data.size());
+    return hasher.final();
+}
+
+/**
+ * @brief Returns the NTLM hash of a password, the MD4 of its UTF-16LE encoding.
+ *
+ * The password is decoded as UTF-8, bytes that are not valid UTF-8 are taken as Latin-1.
+ */
+auto md4::ntlm(std::string_view password) -> digest {
+    std::string encoded;
+    encoded.reserve(password.size() * 2);
+
+    auto put_unit = [&encoded](std::uint32_t unit) {
+        encoded.push_back(static_cast<char>(unit & 0xFF));
+        encoded.push_back(static_cast<char>(unit >> 8));
+    };
+
+    for (std::size_t i = 0; i < password.size();) {
+        auto byte = static_cast<unsigned char>(password[i]);
+        std::size_t length = byte < 0x80 ? 1 : (byte >> 5) == 0x6 ? 2 : (byte >> 4) == 0xE ? 3 : (byte >> 3) == 0x1E ? 4 : 0;
+
+        std::uint32_t code_point = length == 2 ? byte & 0x1FU : length == 3 ? byte & 0x0FU : length == 4 ? byte & 0x07U : byte;
+        bool valid = length != 0 && i + length <= password.size();
+        for (std::size_t j = 1; valid && j < length; ++j) {
+            auto continuation = static_cast<unsigned char>(password[i + j]);
+            valid = (continuation & 0xC0) == 0x80;
+            code_point = (code_point << 6) | (continuation & 0x3FU);
+        }
+        if (!valid) {
+            code_point = byte;
+            length = 1;
+        }
+
+        if (code_point >= 0x10000) {
+            code_point -= 0x10000;
+            put_unit(0xD800 + (code_point >> 10));
+            put_unit(0xDC00 + (code_point & 0x3FF));
+        } else put_unit(code_point);
+        i += length;
+    }
+
+    digest result = hash(encoded);
+    std::memset(encoded.data(), 0, encoded.size());
+    return result;
+}
+
+/**
+ * @brief Mixes the buffered 64-byte block into the state.
+ */
+auto md4::compress() -> void {
+    std::uint32_t x[16];
+    for (std::size_t i = 0; i < 16; ++i) {
+        x[i] = _buffer[i * 4] | static_cast<std::uint32_t>(_buffer[i * 4 + 1]) << 8
+             | static_cast<std::uint32_t>(_buffer[i * 4 + 2]) << 16 | static_cast<std::uint32_t>(_buffer[i * 4 + 3]) << 24;
+    }
+
+    auto [a, b, c, d] = _state;
+    auto f = [](std::uint32_t x, std::uint32_t y, std::uint32_t z) { return (x & y) | (~x & z); };
+    auto g = [](std::uint32_t x, std::uint32_t y, std::uint32_t z) { return (x & y) | (x & z) | (y & z); };
+    auto h = [](std::uint32_t x, std::uint32_t y, std::uint32_t z) { return x ^ y ^ z; };
+
+    constexpr int shifts1[4] { 3, 7, 11, 19 };
+    for (int i = 0; i < 16; ++i) {
+        std::uint32_t next = std::rotl(a + f(b, c, d) + x[i], shifts1[i % 4]);
+        a = d; d = c; c = b; b = next;
+    }
+
+    constexpr int shifts2[4] { 3, 5, 9, 13 };
+    for (int i = 0; i < 16; ++i) {
+        int k = (i % 4) * 4 + i / 4;
+        std::uint32_t next = std::rotl(a + g(b, c, d) + x[k] + 0x5A827999U, shifts2[i % 4]);
+        a = d; d = c; c = b; b = next;
+    }
+
+    constexpr int shifts3[4] { 3, 9, 11, 15 };
+    constexpr int order3[16] { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+    for (int i = 0; i < 16; ++i) {
+        std::uint32_t next = std::rotl(a + h(b, c, d) + x[order3[i]] + 0x6ED9EBA1U, shifts3[i % 4]);
+        a = d; d = c; c = b; b = next;
+    }
+
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+}
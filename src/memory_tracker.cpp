@@ -0,0 +1,236 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <vector>
+#include <algorithm>
+#include <string_view>
+#include <fmt/format.h>
+#include "../include/secure_arena.hpp"
+#include "../include/memory_tracker.hpp"
+
+namespace {
+    /// Color and three links of a red-black tree node, followed by the element
+    template <typename Map>
+    constexpr std::size_t node_size = 4 * sizeof(void*) + sizeof(typename Map::value_type);
+
+    constexpr std::array<std::string_view, static_cast<std::size_t>(memory_tracker::transient::count)> names {
+            "Sort Temporaries", "Encrypt Copies", "Decrypt Copies",
+    };
+
+    /// Categories listed one by one, the rest are summed up
+    constexpr std::size_t listed_categories = 20;
+}
+
+/**
+ * @brief Opens a scope on the calling thread, nested scopes take precedence.
+ * @param operation The operation the allocations are attributed to.
+ */
+memory_tracker::scope::scope(transient operation) : _operation(operation), _outer(_current) {
+    _current = this;
+}
+
+memory_tracker::scope::~scope() {
+    _current = _outer;
+    instance().finish(*this);
+}
+
+/**
+ * @param upstream The resource that actually provides the memory.
+ */
+memory_tracker::memory_tracker(std::pmr::memory_resource *upstream) : _upstream(upstream) { }
+
+/**
+ * @brief Returns the tracker in front of the secure arena.
+ *
+ * Like the arena it is never destroyed, so containers with static
+ * storage duration can still free through it while the program exits.
+ */
+auto memory_tracker::instance() -> memory_tracker& {
+    static auto *tracker = new memory_tracker(&secure_arena::instance());
+    return *tracker;
+}
+
+/**
+ * @brief Prints where the vault memory goes.
+ *
+ * Categories and the password list are measured by walking their containers,
+ * whatever else the tracker sees alive is the undo history and other copies.
+ * Overhead is unused string capacity, and for the arena the memory it holds
+ * beyond the live bytes (pool rounding, free blocks and unused chunk space).
+ *
+ * @param category The categories object to measure.
+ * @param password The passwords object to measure.
+ */
+auto memory_tracker::report(const categories &category, const passwords &password) -> void {
+    using password_map = decltype(categories::category::passwords);
+    using list_map = std::remove_cvref_t<decltype(password.get_passwords())>;
+
+    std::vector<std::pair<const categories::category*, usage>> measured;
+    measured.reserve(category.categories_map.size());
+
+    usage categories_total;
+    for (const auto &[category_ID, element] : category.categories_map) {
+        usage current;
+        for (const auto &[password_ID, value] : element.passwords) {
+            current.add_node(node_size<password_map>);
+            current.add_string(value);
+        }
+        categories_total += current;
+        measured.emplace_back(&element, current);
+    }
+
+    usage list;
+    for (const auto &[password_ID, value] : password.get_passwords()) {
+        list.add_node(node_size<list_map>);
+        list.add_string(value.name);
+    }
+
+    std::stable_sort(measured.begin(), measured.end(), [](const auto &a, const auto &b) -> bool {
+        return a.second.bytes > b.second.bytes;
+    });
+
+    auto print_row = [](std::string_view label, const usage &row) {
+        fmt::print("{:<32} {:>12} {:>12} {:>12}\n", label, format_bytes(row.bytes),
+                   row.allocations, format_bytes(row.overhead));
+    };
+
+    fmt::print("\n{:<32} {:>12} {:>12} {:>12}\n", "Part", "Bytes", "Allocations", "Overhead");
+
+    usage unlisted;
+    for (std::size_t i = 0; i < measured.size(); ++i) {
+        if (i >= listed_categories) {
+            unlisted += measured[i].second;
+            continue;
+        }
+        print_row(fmt::format("Category {} '{}'", measured[i].first->ID, measured[i].first->name),
+                  measured[i].second);
+    }
+    if (measured.size() > listed_categories) {
+        print_row(fmt::format("{} More Categories", measured.size() - listed_categories), unlisted);
+    }
+
+    print_row("All Categories", categories_total);
+    print_row("Password List", list);
+
+    memory_tracker &tracker = instance();
+    std::size_t live = tracker._live_bytes.load(std::memory_order_relaxed);
+    std::size_t live_allocations = tracker._live_allocations.load(std::memory_order_relaxed);
+    std::size_t vault_bytes = categories_total.bytes + list.bytes;
+    std::size_t vault_allocations = categories_total.allocations + list.allocations;
+
+    usage other;
+    other.bytes = live > vault_bytes ? live - vault_bytes : 0;
+    other.allocations = live_allocations > vault_allocations ? live_allocations - vault_allocations : 0;
+    print_row("Undo History and Other", other);
+
+    secure_arena::footprint arena = secure_arena::instance().usage();
+    fmt::print("\nLive: {} in {} Allocations (Peak {}, {} Allocations in Total)\n",
+               format_bytes(live), live_allocations,
+               format_bytes(tracker._peak_bytes.load(std::memory_order_relaxed)),
+               tracker._total_allocations.load(std::memory_order_relaxed));
+    fmt::print("Arena: {} Mapped in {} Chunks, {} Locked, {} Overhead\n",
+               format_bytes(arena.mapped), arena.chunks, format_bytes(arena.locked),
+               format_bytes(arena.mapped > live ? arena.mapped - live : 0));
+
+    fmt::print("\n{:<32} {:>8} {:>12} {:>12} {:>12} {:>12}\n",
+               "Transient Buffers", "Runs", "Allocations", "Bytes", "Peak", "Largest Peak");
+    std::lock_guard guard(tracker._lock);
+    for (std::size_t i = 0; i < tracker._operations.size(); ++i) {
+        const operation_stats &stats = tracker._operations[i];
+        fmt::print("{:<32} {:>8} {:>12} {:>12} {:>12} {:>12}\n", names[i], stats.runs, stats.allocations,
+                   format_bytes(stats.bytes), format_bytes(stats.peak), format_bytes(stats.largest_peak));
+    }
+    fmt::print("(Allocations, Bytes and Peak are of the Last Run)\n");
+}
+
+/**
+ * @brief Counts a container node.
+ */
+auto memory_tracker::usage::add_node(std::size_t node_size) -> void {
+    bytes += node_size;
+    ++allocations;
+}
+
+/**
+ * @brief Counts the buffer of a string, if it does not fit into the string itself.
+ */
+auto memory_tracker::usage::add_string(const std::pmr::string &value) -> void {
+    static const std::size_t inline_capacity = std::pmr::string().capacity();
+    if (value.capacity() <= inline_capacity) return;
+
+    bytes += value.capacity() + 1;
+    overhead += value.capacity() - value.size();
+    ++allocations;
+}
+
+auto memory_tracker::usage::operator+=(const usage &other) -> usage& {
+    bytes += other.bytes;
+    allocations += other.allocations;
+    overhead += other.overhead;
+    return *this;
+}
+
+/**
+ * @brief Allocates from the upstream resource and counts the block.
+ */
+auto memory_tracker::do_allocate(std::size_t bytes, std::size_t alignment) -> void* {
+    void *pointer = _upstream->allocate(bytes, alignment);
+
+    std::size_t live = _live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    _live_allocations.fetch_add(1, std::memory_order_relaxed);
+    _total_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t peak = _peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+
+    if (_current != nullptr) {
+        ++_current->_allocations;
+        _current->_bytes += bytes;
+        _current->_live += static_cast<std::int64_t>(bytes);
+        _current->_peak = std::max(_current->_peak, _current->_live);
+    }
+
+    return pointer;
+}
+
+/**
+ * @brief Returns the block to the upstream resource and uncounts it.
+ */
+auto memory_tracker::do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) -> void {
+    _upstream->deallocate(pointer, bytes, alignment);
+
+    _live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    _live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    if (_current != nullptr) _current->_live -= static_cast<std::int64_t>(bytes);
+}
+
+auto memory_tracker::do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool {
+    return this == &other;
+}
+
+/**
+ * @brief Stores what a finished scope measured.
+ */
+auto memory_tracker::finish(const scope &finished) -> void {
+    std::lock_guard guard(_lock);
+    operation_stats &stats = _operations[static_cast<std::size_t>(finished._operation)];
+
+    ++stats.runs;
+    stats.allocations = finished._allocations;
+    stats.bytes = finished._bytes;
+    stats.peak = static_cast<std::size_t>(finished._peak);
+    stats.largest_peak = std::max(stats.largest_peak, stats.peak);
+}
+
+/**
+ * @brief Formats a byte count with a binary unit.
+ */
+auto memory_tracker::format_bytes(std::size_t bytes) -> std::string {
+    auto value = static_cast<double>(bytes);
+    if (bytes < 1024) return fmt::format("{} B", bytes);
+    if (bytes < 1024 * 1024) return fmt::format("{:.1f} KiB", value / 1024);
+    if (bytes < 1024 * 1024 * 1024) return fmt::format("{:.1f} MiB", value / (1024 * 1024));
+    return fmt::format("{:.2f} GiB", value / (1024.0 * 1024 * 1024));
+}
@@ -3,19 +3,220 @@
  * See LICENSE file for license details
  */
 
+#include <array>
+#include <algorithm>
+#include <functional>
 #include "../include/menu.hpp"
 
+namespace {
+    using item = menu::item;
+
+    /// The ID of the item leaving a menu, the only one without an action
+    constexpr std::size_t exit_ID = 0;
+
+    constexpr std::array<item, 21> main_menu {{
+            {1, "Add Category", [](passwords &, categories &category) {
+                category.add();
+                history::commit("Add Category");
+            }},
+            {2, "Remove Category", [](passwords &, categories &category) {
+                category.remove();
+                history::commit("Remove Category");
+            }},
+            {3, "Print Category", [](passwords &, categories &category) { vault_view::browse(category); }},
+            {4, "Search for Passwords", [](passwords &password, categories &category) { password.search(category); }},
+            {5, "Sort Passwords", [](passwords &password, categories &category) {
+                password.sort(category);
+                history::commit("Sort Passwords");
+            }},
+            {6, "Add Password", [](passwords &password, categories &category) {
+                password.add(category);
+                history::commit("Add Password");
+            }},
+            {7, "Edit Password", [](passwords &password, categories &category) {
+                password.edit(category);
+                history::commit("Edit Password");
+            }},
+            {8, "Remove Password", [](passwords &password, categories &category) {
+                password.remove(category);
+                history::commit("Remove Password");
+            }},
+            {9, "Write Changes To File", [](passwords &password, categories &category) {
+                cryptor::initialize_encrypt(category);
+                history::rebuild(category, password);
+                history::commit("Write Changes To File");
+            }},
+            {10, "Decryption Test", [](passwords &, categories &) { vault_file::initialize_check(); }},
+            {11, "Export Vault", [](passwords &password, categories &category) {
+                exporter::initialize_export(category, password);
+            }},
+            {12, "Undo", [](passwords &password, categories &category) { history::undo(category, password); }},
+            {13, "Redo", [](passwords &password, categories &category) { history::redo(category, password); }},
+            {14, "Save Vault", [](passwords &password, categories &category) {
+                vault_watcher::settle(category, password);
+                vault_file::initialize_save(category, password);
+            }},
+            {15, "Load Vault", [](passwords &password, categories &category) {
+                vault_file::initialize_load(category, password);
+                history::commit("Load Vault");
+            }},
+            {16, "Statistics", [](passwords &, categories &) { metrics::print(); }},
+            {17, "Memory Report", [](passwords &password, categories &category) {
+                memory_tracker::report(category, password);
+            }},
+            {18, "Strength Audit", [](passwords &password, categories &category) {
+                strength::audit(category, password);
+            }},
+            {19, "Breach Scan", [](passwords &password, categories &category) {
+                breach_index::scan(category, password);
+            }},
+            {20, "Search by Prefix", [](passwords &password, categories &category) {
+                password.search_prefix(category);
+            }},
+            {exit_ID, "Exit"},
+    }};
+
+    constexpr auto highest_id(std::span<const item> menu) -> std::size_t {
+        std::size_t highest = 0;
+        for (const item &entry : menu) highest = std::max({ highest, entry.id, highest_id(entry.sub_menu) });
+        return highest;
+    }
+
+    /// How many menus can be open at once
+    constexpr auto depth(std::span<const item> menu) -> std::size_t {
+        std::size_t deepest = 0;
+        for (const item &entry : menu) deepest = std::max(deepest, depth(entry.sub_menu));
+        return menu.empty() ? 0 : deepest + 1;
+    }
+
+    /// Every option of the menu tree by its ID, the exits left out
+    struct dispatch_table {
+        std::array<const item*, highest_id(main_menu) + 1> items {};
+        /// No two options share an ID
+        bool unique = true;
+        /// Every item either runs an action, opens a sub-menu or is an exit
+        bool well_formed = true;
+    };
+
+    constexpr auto fill(std::span<const item> menu, dispatch_table &table) -> void {
+        for (const item &entry : menu) {
+            bool exits = entry.action == nullptr && entry.sub_menu.empty();
+            if (exits != (entry.id == exit_ID) || (entry.action != nullptr && !entry.sub_menu.empty())) {
+                table.well_formed = false;
+            }
+            if (entry.id == exit_ID) continue;
+
+            if (table.items[entry.id] != nullptr) table.unique = false;
+            table.items[entry.id] = &entry;
+            fill(entry.sub_menu, table);
+        }
+    }
+
+    constexpr auto generate() -> dispatch_table {
+        dispatch_table table;
+        fill(main_menu, table);
+        return table;
+    }
+
+    constexpr dispatch_table options = generate();
+
+    static_assert(options.unique, "Menu option IDs must be unique across the whole menu tree");
+    static_assert(options.well_formed, "Menu items need exactly one of an action and a sub-menu, except the exits");
+    static_assert(highest_id(main_menu) < metrics::menu_options, "Every menu option needs a metric of its own");
+
+    /// The longest metric name, "menu." included
+    constexpr std::size_t max_metric_name = 40;
+
+    /// The metric names of the options by ID, empty for unused IDs
+    struct metric_names {
+        std::array<std::array<char, max_metric_name>, metrics::menu_options> text {};
+        std::array<std::size_t, metrics::menu_options> size {};
+        bool fits = true;
+    };
+
+    /// "Add Category" is measured as "menu.add_category"
+    constexpr auto name_metrics(std::span<const item> menu, metric_names &named) -> void {
+        for (const item &entry : menu) {
+            if (named.size[entry.id] == 0) {
+                std::size_t length = 0;
+                auto put = [&](char letter) {
+                    if (length < max_metric_name) named.text[entry.id][length++] = letter;
+                    else named.fits = false;
+                };
+
+                for (char letter : std::string_view("menu.")) put(letter);
+                for (char letter : entry.label) {
+                    put(letter == ' ' ? '_' : letter >= 'A' && letter <= 'Z' ? static_cast<char>(letter - 'A' + 'a')
+                                                                            : letter);
+                }
+                named.size[entry.id] = length;
+            }
+            name_metrics(entry.sub_menu, named);
+        }
+    }
+
+    constexpr auto generate_names() -> metric_names {
+        metric_names named;
+        name_metrics(main_menu, named);
+        return named;
+    }
+
+    constexpr metric_names names = generate_names();
+
+    static_assert(names.fits, "A menu label is too long for its metric name");
+}
+
+/**
+ * @param source The stream buffer the input is read from.
+ */
+menu::splitter::splitter(std::streambuf *source) : _source(source) { }
+
+/**
+ * @brief Tells whether the next line read is a command line.
+ */
+auto menu::splitter::expect_command(bool expected) -> void {
+    _command = expected;
+}
+
+/**
+ * @brief Reads the next line from the source.
+ *
+ * In a command line every ';' ends a command, so "1;work;4" adds the
+ * category "work" and searches. A ';' that belongs to the input is written
+ * as "\;". Lines read by the options pass through unchanged.
+ */
+auto menu::splitter::underflow() -> int_type {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    _line.clear();
+    int_type next = _source->sbumpc();
+    while (!traits_type::eq_int_type(next, traits_type::eof())) {
+        char letter = traits_type::to_char_type(next);
+        if (_command && letter == ';') _line.push_back('\n');
+        else if (_command && letter == '\\' && traits_type::eq_int_type(_source->sgetc(), ';')) {
+            _line.push_back(traits_type::to_char_type(_source->sbumpc()));
+        } else _line.push_back(letter);
+
+        if (letter == '\n') break;
+        next = _source->sbumpc();
+    }
+    if (_line.empty()) return traits_type::eof();
+
+    setg(_line.data(), _line.data(), _line.data() + _line.size());
+    return traits_type::to_int_type(*gptr());
+}
+
 /**
  * @brief Displays the menu for the Password Manager.
- * @param menu The vector of items to display in the menu.
+ * @param menu The items to display in the menu.
  */
-auto menu::display(const std::vector<item> &menu) -> void {
+auto menu::display(std::span<const item> menu) -> void {
     fmt::print("\n==================================================|\n");
     fmt::print("               Password Manager                   |\n");
     fmt::print("==================================================|\n");
     /// Iterate over each item in the menu and print its ID and label
-    for (const item &item : menu) {
-        fmt::print("[{}] {}\n", item.id, item.label);
+    for (const item &entry : menu) {
+        fmt::print("[{}] {}\n", entry.id, entry.label);
     }
     fmt::print("==================================================|\n");
 }
@@ -23,100 +224,112 @@ auto menu::display(const std::vector<item> &menu) -> void {
 /**
  * @brief Processes the menu options for the Password Manager.
  *
- * This function displays the menu recursively, allows the user to make a selection,
- * and performs the corresponding action based on the selected item. It continues
- * processing the menu until the user chooses to exit.
+ * This function displays the current menu, allows the user to make a selection,
+ * and runs the action of the selected item or opens its sub-menu. An exit
+ * leaves the current menu, leaving the main menu ends the function, as does
+ * the end of the input.
  *
  * @param password The passwords object for managing passwords.
  * @param category The categories object for managing categories.
- * @param menu The vector of items representing the menu.
  */
-auto menu::process(passwords &password, categories &category, const std::vector<item> &menu) -> void {
-    /// Termination flag
-    std::atomic<bool> flag = true;
-
-    /// Continue processing the menu until the flag is false
-    while (flag.load()) {
-        /// Used std::function to get rid of CLang recursive call warning
-        std::function<void(const std::vector<item>&)> process_menu_recursive;
-        process_menu_recursive = [&](const std::vector<item> &current_menu) -> void {
-            /// Display the current menu
-            display(current_menu);
+auto menu::process(passwords &password, categories &category) -> void {
+    splitter input(std::cin.rdbuf());
+    std::streambuf *previous = std::cin.rdbuf(&input);
+
+    /// The open menus, the main menu at the bottom
+    std::array<std::span<const item>, depth(main_menu)> open { main_menu };
+    std::size_t opened = 1;
+
+    try {
+        while (opened > 0) {
+            std::span<const item> current = open[opened - 1];
+            display(current);
 
             /// User input
             fmt::print("\n-> ");
             std::size_t choice;
-            if (!(std::cin >> choice)) {
+            input.expect_command(true);
+            bool valid = static_cast<bool>(std::cin >> choice);
+            input.expect_command(false);
+            if (!valid) {
+                /// Leave the menu when the input ends, e.g. at the end of a replayed script
+                if (std::cin.eof()) break;
+
                 std::cin.clear();
                 std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
                 fmt::print("\n[-] Invalid Input, Try Again\n");
-                return;
+                continue;
             }
 
-            /// Find the selected item in the current menu
-            std::optional<item> selected = find_item(current_menu, choice);
-            if (selected) {
-                /// If the selected item has a sub-menu, recursively process it
-                if (!selected->sub_menu.empty()) process_menu_recursive(selected->sub_menu);
+            /// Merge what other processes changed in the vault file while the menu waited
+            vault_watcher::poll(category, password);
 
-                /// If the selected item does not have a sub-menu, handle the option
-                else handle_option(password, category, selected->id, flag);
-            } else fmt::print("\n[-] Invalid Input, Try Again\n");
-        };
+            const item *selected = find_item(current, choice);
+            if (selected == nullptr) {
+                fmt::print("\n[-] Invalid Input, Try Again\n");
+                continue;
+            }
+
+            /// The stack is as deep as the menu tree, it is never full when a sub-menu is chosen
+            if (!selected->sub_menu.empty() && opened < open.size()) {
+                open[opened++] = selected->sub_menu;
+                continue;
+            }
 
-        /// Start processing the menu from the top-level menu
-        process_menu_recursive(menu);
+            metrics::timer timer(metrics::for_option(selected->id));
+            if (selected->action != nullptr) selected->action(password, category);
+            else --opened;
+        }
+    } catch (const passwords::input_closed &error) {
+        fmt::print("\n[-] {}\n", error.what());
     }
+
+    std::cin.rdbuf(previous);
 }
 
 /**
- * @brief Finds an item in the menu by its ID.
- *
- * This function searches for an item in the provided menu vector based on its ID.
- * If a matching item is found, it returns an optional containing the item. Otherwise,
- * it returns an empty optional (std::nullopt).
- *
- * @param menu The vector of items representing the menu.
- * @param id The ID of the item to find.
- * @return An optional containing the found item, or an empty optional if not found.
+ * @brief Returns the ID of the option with the given label, for scripts driving the menu.
+ * @return The ID, or std::nullopt if no option has this label.
  */
-auto menu::find_item(const std::vector<item> &menu, std::size_t id) -> std::optional<menu::item> {
-    /// Iterate over each item in the menu
-    for (const item &item: menu) {
-        /// Check if the item's ID matches the provided ID
-        /// And return the matching item
-        if (item.id == id) return item;
+auto menu::option_ID(std::string_view label) -> std::optional<std::size_t> {
+    for (const item *option : options.items) {
+        if (option != nullptr && option->label == label) return option->id;
+    }
+    for (const item &entry : main_menu) {
+        if (entry.id == exit_ID && entry.label == label) return exit_ID;
     }
-
     return std::nullopt;
 }
 
 /**
- * @brief Handles the selected option in the menu.
+ * @brief Returns the metric name of an option, derived from its label.
+ * @return The name, or an empty string if no option has this ID.
+ */
+auto menu::metric_name(std::size_t id) -> std::string_view {
+    if (id >= names.size.size()) return { };
+    return { names.text[id].data(), names.size[id] };
+}
+
+/**
+ * @brief Finds an item in the menu by its ID.
  *
- * This function takes the selected option ID and performs the corresponding action
- * based on the ID. It invokes the appropriate methods on the passwords and categories
- * objects to handle the selected option.
+ * Options are looked up in the table generated at compile time, and only
+ * found if they belong to the given menu.
  *
- * @param password The passwords object for managing passwords.
- * @param category The categories object for managing categories.
- * @param option_ID The ID of the selected option.
- * @param flag The atomic flag indicating whether to continue processing the menu.
+ * @param menu The items of the menu.
+ * @param id The ID of the item to find.
+ * @return The found item, or nullptr if the menu has none with this ID.
  */
-auto menu::handle_option(passwords &password, categories &category,
-                         std::size_t option_ID, std::atomic<bool> &flag) -> void {
-    /// Perform the action based on the selected option ID
-    switch (option_ID) {
-        case 1: category.add(); break;
-        case 2: category.remove(); break;
-        case 3: category.is_printable(); break;
-        case 4: password.search(category); break;
-        case 5: password.sort(category); break;
-        case 6: password.add(category); break;
-        case 7: password.edit(category); break;
-        case 8: password.remove(category); break;
-        case 9: cryptor::initialize_encrypt(category); break;
-        case 0: flag.store(false); break;
-        default: fmt::print("\n[-] Invalid Input, Try Again\n");
+auto menu::find_item(std::span<const item> menu, std::size_t id) -> const item* {
+    if (id == exit_ID) {
+        auto leaving = std::ranges::find(menu, exit_ID, &item::id);
+        return leaving != menu.end() ? &*leaving : nullptr;
     }
+    if (id >= options.items.size()) return nullptr;
+
+    /// Items of different menus are unrelated objects, std::less orders them anyway
+    const item *found = options.items[id];
+    std::less<const item*> before;
+    if (found == nullptr || before(found, menu.data()) || !before(found, menu.data() + menu.size())) return nullptr;
+    return found;
 }
@@ -0,0 +1,303 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include <condition_variable>
+#include <fmt/format.h>
+#include "../include/menu.hpp"
+#include "../include/metrics.hpp"
+
+namespace {
+    /// Names of the metrics after the menu options
+    constexpr std::array<std::string_view, static_cast<std::size_t>(metrics::metric::count) - metrics::menu_options> names {
+            "menu.invalid", "passwords.search", "passwords.sort", "cryptor.encrypt_map", "cryptor.write",
+            "exporter.write", "vault_file.save", "vault_file.load", "argon2.derive",
+            "vault_file.rekey", "transaction.commit",
+    };
+
+    /// Only the owning thread writes a shard, so a load and a store replace the atomic increment
+    auto add(std::atomic<std::uint64_t> &counter, std::uint64_t value) -> void {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Starts measuring when metrics are enabled.
+ * @param measured The metric the elapsed time is recorded into.
+ */
+metrics::timer::timer(metric measured) : _measured(measured), _active(enabled()) {
+    if (_active) _start = std::chrono::steady_clock::now();
+}
+
+metrics::timer::~timer() {
+    if (_active) record(_measured, std::chrono::steady_clock::now() - _start);
+}
+
+/**
+ * @brief Reads the metrics settings from the environment.
+ *
+ * GUARDCIPHER_METRICS=0 disables the metrics. GUARDCIPHER_METRICS_FILE names a file
+ * that is rewritten every GUARDCIPHER_METRICS_INTERVAL seconds (60 by default) and
+ * once more on exit, as JSON if the name ends in ".json" and as text otherwise.
+ */
+auto metrics::configure() -> void {
+    const char *setting = std::getenv("GUARDCIPHER_METRICS");
+    if (setting != nullptr && (std::string_view(setting) == "0" || std::string_view(setting) == "off")) {
+        _enabled.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    const char *filename = std::getenv("GUARDCIPHER_METRICS_FILE");
+    if (filename == nullptr || *filename == '\0') return;
+
+    const char *interval_setting = std::getenv("GUARDCIPHER_METRICS_INTERVAL");
+    long interval = interval_setting != nullptr ? std::strtol(interval_setting, nullptr, 10) : 60;
+    if (interval < 1) interval = 60;
+
+    _writer = std::jthread(periodic_write, std::string(filename), std::chrono::seconds(interval));
+}
+
+/**
+ * @brief Checks whether operations are being measured.
+ */
+auto metrics::enabled() -> bool {
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds one measurement to the shard of the calling thread.
+ * @param measured The metric to record into.
+ * @param elapsed  The measured duration.
+ */
+auto metrics::record(metric measured, std::chrono::nanoseconds elapsed) -> void {
+    auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(elapsed.count(), 0));
+    series &target = local().all[static_cast<std::size_t>(measured)];
+
+    add(target.count, 1);
+    add(target.total, nanoseconds);
+    add(target.histogram[bucket(nanoseconds)], 1);
+    if (nanoseconds > target.maximum.load(std::memory_order_relaxed)) {
+        target.maximum.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Maps a menu option ID to its metric.
+ */
+auto metrics::for_option(std::size_t option_ID) -> metric {
+    if (option_ID >= static_cast<std::size_t>(metric::menu_invalid)) return metric::menu_invalid;
+    return static_cast<metric>(option_ID);
+}
+
+/**
+ * @brief Prints every recorded metric as a table.
+ */
+auto metrics::print() -> void {
+    if (!enabled()) {
+        fmt::print("\n[-] Metrics are Disabled\n");
+        return;
+    }
+
+    fmt::print("\n{}", render_text(collect()));
+}
+
+/**
+ * @brief Writes every recorded metric to a file.
+ *
+ * The file is replaced atomically, so readers never see a partial dump.
+ *
+ * @param filename The file to write, JSON if its name ends in ".json".
+ * @return True if the file was written.
+ */
+auto metrics::write(const std::string &filename) -> bool {
+    std::vector<summary> summaries = collect();
+    std::string content = filename.ends_with(".json") ? render_json(summaries) : render_text(summaries);
+
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) return false;
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    return !error;
+}
+
+/**
+ * @brief Returns the shard of the calling thread, registering it on first use.
+ *
+ * Shards outlive their threads, so nothing recorded is lost when a thread exits.
+ */
+auto metrics::local() -> shard& {
+    thread_local shard *mine = [] {
+        std::lock_guard guard(_lock);
+        _shards.push_back(std::make_unique<shard>());
+        return _shards.back().get();
+    }();
+    return *mine;
+}
+
+/**
+ * @brief Sums the shards of all threads.
+ * @return One summary per metric, in the order of the metric enumeration.
+ */
+auto metrics::collect() -> std::vector<summary> {
+    std::vector<summary> summaries(_metric_count);
+    for (std::size_t i = 0; i < _metric_count; ++i) {
+        summaries[i].name = i < menu_options ? menu::metric_name(i) : names[i - menu_options];
+    }
+
+    std::lock_guard guard(_lock);
+    for (const auto &thread_shard : _shards) {
+        for (std::size_t i = 0; i < _metric_count; ++i) {
+            const series &source = thread_shard->all[i];
+            summary &target = summaries[i];
+
+            target.count += source.count.load(std::memory_order_relaxed);
+            target.total += source.total.load(std::memory_order_relaxed);
+            target.maximum = std::max(target.maximum, source.maximum.load(std::memory_order_relaxed));
+            for (std::size_t j = 0; j < _buckets; ++j) {
+                target.histogram[j] += source.histogram[j].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    return summaries;
+}
+
+/**
+ * @brief Returns the histogram bucket of a duration.
+ *
+ * Small values are stored exactly, larger ones keep their top _sub_bits + 1
+ * bits, which bounds the relative error of every bucket to 1 / 2^_sub_bits.
+ */
+auto metrics::bucket(std::uint64_t nanoseconds) -> std::size_t {
+    constexpr std::uint64_t linear = 1U << _sub_bits;
+    if (nanoseconds < linear) return nanoseconds;
+
+    int exponent = std::bit_width(nanoseconds) - 1;
+    std::uint64_t mantissa = (nanoseconds >> (exponent - _sub_bits)) & (linear - 1);
+    return (static_cast<std::size_t>(exponent - _sub_bits + 1) << _sub_bits) + mantissa;
+}
+
+/**
+ * @brief Returns the largest duration that falls into a bucket.
+ */
+auto metrics::bucket_limit(std::size_t index) -> std::uint64_t {
+    constexpr std::size_t linear = 1U << _sub_bits;
+    if (index < linear) return index;
+
+    int exponent = static_cast<int>(index >> _sub_bits) + _sub_bits - 1;
+    std::uint64_t mantissa = index & (linear - 1);
+    std::uint64_t next = (linear + mantissa + 1) << (exponent - _sub_bits);
+    return next == 0 ? UINT64_MAX : next - 1;
+}
+
+/**
+ * @brief Returns the duration below which the given fraction of measurements fall.
+ * @param fraction The fraction, for example 0.99 for the 99th percentile.
+ */
+auto metrics::summary::percentile(double fraction) const -> std::uint64_t {
+    if (count == 0) return 0;
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < _buckets; ++i) {
+        seen += histogram[i];
+        if (seen >= rank) return std::min(bucket_limit(i), maximum);
+    }
+
+    return maximum;
+}
+
+/**
+ * @brief Formats a duration with a unit that keeps it short.
+ */
+auto metrics::format_duration(std::uint64_t nanoseconds) -> std::string {
+    auto value = static_cast<double>(nanoseconds);
+    if (nanoseconds < 1'000) return fmt::format("{}ns", nanoseconds);
+    if (nanoseconds < 1'000'000) return fmt::format("{:.1f}us", value / 1e3);
+    if (nanoseconds < 1'000'000'000) return fmt::format("{:.2f}ms", value / 1e6);
+    return fmt::format("{:.2f}s", value / 1e9);
+}
+
+/**
+ * @brief Renders the metrics that were recorded at least once as a table.
+ */
+auto metrics::render_text(const std::vector<summary> &summaries) -> std::string {
+    fmt::memory_buffer buffer;
+    fmt::format_to(std::back_inserter(buffer), "{:<28} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+                   "Operation", "Count", "Ops/s", "Mean", "p50", "p90", "p99", "Max");
+
+    bool recorded = false;
+    for (const summary &current : summaries) {
+        if (current.count == 0) continue;
+        recorded = true;
+
+        /// Throughput while the operation was running, the inverse of the mean latency
+        double throughput = current.total > 0 ? static_cast<double>(current.count) * 1e9
+                                                / static_cast<double>(current.total) : 0.0;
+        fmt::format_to(std::back_inserter(buffer), "{:<28} {:>8} {:>10.0f} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+                       current.name, current.count, throughput, format_duration(current.total / current.count),
+                       format_duration(current.percentile(0.50)), format_duration(current.percentile(0.90)),
+                       format_duration(current.percentile(0.99)), format_duration(current.maximum));
+    }
+
+    if (!recorded) fmt::format_to(std::back_inserter(buffer), "[-] Nothing Recorded Yet\n");
+    return fmt::to_string(buffer);
+}
+
+/**
+ * @brief Renders the metrics that were recorded at least once as a JSON object.
+ *
+ * Durations are in nanoseconds.
+ */
+auto metrics::render_json(const std::vector<summary> &summaries) -> std::string {
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    fmt::memory_buffer buffer;
+    fmt::format_to(std::back_inserter(buffer), "{{\"timestamp\":{},\"metrics\":[", now);
+
+    bool first = true;
+    for (const summary &current : summaries) {
+        if (current.count == 0) continue;
+        if (!first) buffer.push_back(',');
+        first = false;
+
+        fmt::format_to(std::back_inserter(buffer),
+                       "{{\"name\":\"{}\",\"count\":{},\"total_ns\":{},\"mean_ns\":{},"
+                       "\"p50_ns\":{},\"p90_ns\":{},\"p99_ns\":{},\"max_ns\":{}}}",
+                       current.name, current.count, current.total, current.total / current.count,
+                       current.percentile(0.50), current.percentile(0.90),
+                       current.percentile(0.99), current.maximum);
+    }
+
+    fmt::format_to(std::back_inserter(buffer), "]}}\n");
+    return fmt::to_string(buffer);
+}
+
+/**
+ * @brief Body of the writer thread, rewrites the file every interval and once more when stopped.
+ */
+auto metrics::periodic_write(const std::stop_token &stop, const std::string &filename,
+                             std::chrono::seconds interval) -> void {
+    std::mutex sleep_lock;
+    std::condition_variable_any wake;
+    std::unique_lock guard(sleep_lock);
+
+    while (!stop.stop_requested()) {
+        wake.wait_for(guard, stop, interval, [] { return false; });
+        if (!write(filename)) fmt::print(stderr, "[-] Failed to Write the Metrics to '{}'\n", filename);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include "../include/trace.hpp"
+#include "../include/keyring.hpp"
+#include "../include/name_index.hpp"
+
+/**
+ * @brief Indexes a category and its passwords, in place of the version it replaces.
+ * @param category The category as it is now.
+ * @param replaced The recorded version of the category, nullptr if it is new.
+ */
+auto name_index::put_category(const categories::category &category,
+                              const vault_state::category_version *replaced) -> void {
+    erase_category(category.ID, replaced);
+
+    tries &indexed = instance();
+    indexed.categories.insert(category.name, { category.ID, 0 });
+    for (const auto &[password_ID, value] : category.passwords) {
+        indexed.passwords.insert(value, { category.ID, password_ID });
+    }
+}
+
+/**
+ * @brief Drops a category and its passwords from the index.
+ * @param category_ID The ID of the category.
+ * @param removed     The recorded version of the category, nullptr if there is none.
+ */
+auto name_index::erase_category(std::size_t category_ID, const vault_state::category_version *removed) -> void {
+    if (removed == nullptr) return;
+
+    tries &indexed = instance();
+    indexed.categories.erase(removed->name, { category_ID, 0 });
+    removed->passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+        indexed.passwords.erase(value, { category_ID, password_ID });
+    });
+}
+
+/**
+ * @brief Indexes an added or edited password.
+ * @param category_ID The ID of the category, keyring::list_ID for the password list.
+ * @param password_ID The ID of the password.
+ * @param password    The new value.
+ * @param replaced    The value it had before, nullptr if it is new.
+ */
+auto name_index::put_password(std::size_t category_ID, std::size_t password_ID,
+                              std::string_view password, const std::pmr::string *replaced) -> void {
+    erase_password(category_ID, password_ID, replaced);
+    instance().passwords.insert(password, { category_ID, password_ID });
+}
+
+/**
+ * @brief Drops a password from the index.
+ * @param removed The value of the password, nullptr if there is none.
+ */
+auto name_index::erase_password(std::size_t category_ID, std::size_t password_ID,
+                                const std::pmr::string *removed) -> void {
+    if (removed != nullptr) instance().passwords.erase(*removed, { category_ID, password_ID });
+}
+
+/**
+ * @brief Indexes the whole vault from scratch, after operations that replace all of it.
+ */
+auto name_index::rebuild(const categories &category, const passwords &password) -> void {
+    TRACE_SPAN("name_index::rebuild");
+    tries &indexed = instance();
+    indexed.categories.clear();
+    indexed.passwords.clear();
+
+    for (const auto &[category_ID, element] : category.categories_map) {
+        indexed.categories.insert(element.name, { category_ID, 0 });
+        for (const auto &[password_ID, value] : element.passwords) {
+            indexed.passwords.insert(value, { category_ID, password_ID });
+        }
+    }
+    for (const auto &[password_ID, element] : password.get_passwords()) {
+        indexed.passwords.insert(element.name, { keyring::list_ID, password_ID });
+    }
+}
+
+/**
+ * @brief Destroys both tries, so that no node outlives the arena at shutdown.
+ */
+auto name_index::clear() -> void {
+    _indexed.reset();
+}
+
+auto name_index::category_names() -> const radix_trie& {
+    return instance().categories;
+}
+
+auto name_index::password_names() -> const radix_trie& {
+    return instance().passwords;
+}
+
+auto name_index::instance() -> tries& {
+    if (!_indexed) _indexed.emplace();
+    return *_indexed;
+}
@@ -3,7 +3,15 @@
  * See LICENSE file for license details
  */
 
+#include "../include/history.hpp"
+#include "../include/trace.hpp"
+#include "../include/metrics.hpp"
+#include "../include/memory_tracker.hpp"
 #include "../include/passwords.hpp"
+#include "../include/strength.hpp"
+#include "../include/breach_index.hpp"
+#include "../include/vault_view.hpp"
+#include "../include/name_index.hpp"
 
 /**
  * @brief Reads input from the user.
@@ -26,6 +34,8 @@ auto passwords::read_input(const std::string &prompt, const std::string &error_m
             if (std::find(valid_values.begin(),
                           valid_values.end(), value) != valid_values.end()) { return value; }
         } else {
+            if (std::cin.eof()) throw input_closed("Unexpected End of Input");
+
             /// Clear any error flags and ignore remaining input
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -94,10 +104,11 @@ auto passwords::add(categories &category) -> void {
         std::function<void(std::string&)> add_recursive =
                 [&](std::string &password) -> void {
             fmt::print("\nEnter the Password: ");
-            std::cin >> password;
+            if (!(std::cin >> password)) throw input_closed("Unexpected End of Input");
             /// Check if the manually entered password is secure, and prompt again if it's not
             if (!is_secure(password)) {
                 fmt::print("\n[-] Password is not Secure, Try Again\n");
+                print_weakness(password);
                 add_recursive(password);
             }
         };
@@ -116,18 +127,16 @@ auto passwords::add(categories &category) -> void {
     std::cin >> confirmation_adding;
 
     /// Check if the password should be added to categories
-    if (!category.is_printable() || (confirmation_adding.size() == 1
-                                     && std::toupper(confirmation_adding[0]) == 'N')) {
+    if (category.empty() || (confirmation_adding.size() == 1
+                             && std::toupper(confirmation_adding[0]) == 'N')) {
         /// Add the password to the list without categories
         fmt::print("\n[+] Adding to Password List");
-        struct password new_password;
-        new_password.name = password_input;
-        new_password.ID = _current_ID++;
-        _pass_without_categories[new_password.ID] = new_password;
+        insert(password_input);
         fmt::print("\n[+] Password Added to List Successfully\n");
         return;
     }
 
+    vault_view::preview(category);
     fmt::print("\nChoose Category to Add Password: ");
 
     std::string input;
@@ -154,53 +163,82 @@ auto passwords::add(categories &category) -> void {
         std::cin >> confirmation;
         if (confirmation.size() == 1 && std::toupper(confirmation[0]) == 'Y') {
             /// Add the password to the selected category
-            auto category_it = category.categories_map.find(selected_category->ID);
-            category_it->second.passwords[category_it->second._pass_id++] = password_input;
+            category.insert_password(selected_category->ID, password_input);
             fmt::print("\n[+] Password Added Successfully\n");
         } else fmt::print("\n[-] Canceled\n");
 
     } else fmt::print("\n[-] Category Not Found\n");
 }
 
+/**
+ * @brief Adds a password to the password list without prompting.
+ * @param value The password to add.
+ * @return The ID assigned to the password.
+ */
+auto passwords::insert(const std::string &value) -> std::size_t {
+    TRACE_SPAN("passwords::insert");
+    struct password new_password;
+    new_password.name = value;
+    new_password.ID = _current_ID++;
+    _pass_without_categories[new_password.ID] = new_password;
+    history::put_uncategorized(new_password);
+    return new_password.ID;
+}
+
 /**
  * @brief Checks if a password is secure based on certain criteria.
+ *
+ * Besides the character classes the password must take an attacker at
+ * least strength::minimum_score, so "Password1!" is rejected, and it must
+ * not appear in the breach corpus, if one is configured.
+ *
  * @param password The password to check.
  * @return True if the password is secure, false otherwise.
  */
-auto passwords::is_secure(const std::string &password) -> bool {
+auto passwords::is_secure(std::string_view password) -> bool {
     /// Check if the password length is less than 8 characters
     if (password.length() < 8) return false;
 
     /// Initialize variables to track if the password contains numeric,
-    /// uppercase, and lowercase characters
+    /// uppercase, lowercase and special characters
     bool has_numeric = false;
     bool has_upper_case = false;
     bool has_lower_case = false;
+    bool has_special = false;
 
     /// Iterate over each character in the password
     for (char c : password) {
         has_numeric    |= isdigit(c);
         has_upper_case |= isupper(c);
         has_lower_case |= islower(c);
+        has_special    |= std::string_view(R"(!@#$%^&*()[]{}|;:'",.<>/?)").find(c) != std::string_view::npos;
     }
 
-    /// Check if the password contains at least one uppercase,
-    /// one lowercase, and one numeric character
-    if (!has_upper_case || !has_lower_case || !has_numeric) return false;
+    /// Check if the password contains at least one uppercase, one lowercase,
+    /// one numeric and one special character
+    if (!has_upper_case || !has_lower_case || !has_numeric || !has_special) return false;
 
-    // Define a regex pattern for special characters
-    const std::regex SPECIAL_CHARS(R"([!@#$%^&*()\[\]{}|;:'",.<>/?])");
-    /// Check if the password contains at least one special character
-    if (!std::regex_search(password, SPECIAL_CHARS)) return false;
+    /// Check that it is not built from common words, keyboard walks, sequences or repeats
+    if (strength::measure(password).score < strength::minimum_score) return false;
 
-    /// Define a regex pattern for common repeating patterns
-    const std::regex COMMON_PATTERNS("(\\w)\\1{2,}");
-    /// Check if the password contains common repeating patterns
-    if (std::regex_search(password, COMMON_PATTERNS)) return false;
+    /// Check that it has not been leaked before
+    const breach_index *index = breach_index::configured();
+    return index == nullptr || index->occurrences(password) == 0;
+}
 
-    /// If none of the previous conditions matched,
-    /// then the password is considered secure
-    return true;
+/**
+ * @brief Explains why is_secure rejected a password.
+ */
+auto passwords::print_weakness(std::string_view password) -> void {
+    if (const breach_index *index = breach_index::configured(); index != nullptr) {
+        if (std::uint32_t seen = index->occurrences(password); seen > 0) {
+            fmt::print("[-] Password Appears {} Times in the Breach Corpus\n", seen);
+        }
+    }
+
+    strength::estimate rating = strength::measure(password);
+    fmt::print("[-] Score {} of 4, About {:.2g} Guesses, Weakest Part: {}\n",
+               rating.score, rating.guesses, strength::describe(rating.weakest));
 }
 
 /**
@@ -213,6 +251,24 @@ auto passwords::is_secure(const std::string &password) -> bool {
  */
 auto passwords::generator(int password_length, bool has_upper_case,
                           bool has_lower_case, bool has_special_chars) -> std::string {
+    /// Create a random device and a random number generator
+    std::random_device rd;
+    std::mt19937_64 engine(rd());
+
+    return generator(engine, password_length, has_upper_case, has_lower_case, has_special_chars);
+}
+
+/**
+ * @brief Generates a password from the given engine, so a seeded engine gives reproducible passwords.
+ * @param engine The random number generator to draw from.
+ * @param password_length The length of the password.
+ * @param has_upper_case Flag indicating whether the password should contain uppercase letters.
+ * @param has_lower_case Flag indicating whether the password should contain lowercase letters.
+ * @param has_special_chars Flag indicating whether the password should contain special characters.
+ * @return The generated password.
+ */
+auto passwords::generator(std::mt19937_64 &engine, int password_length, bool has_upper_case,
+                          bool has_lower_case, bool has_special_chars) -> std::string {
     /// Create an empty string to store
     /// the possible characters for the password
     std::string characters;
@@ -230,10 +286,6 @@ auto passwords::generator(int password_length, bool has_upper_case,
         return "error occured";
     }
 
-    /// Create a random device and a random number generator
-    std::random_device rd;
-    std::mt19937 generator(rd());
-
     /// Define a uniform distribution for selecting characters from the character set
     std::uniform_int_distribution<std::size_t>
             char_distribution(0, characters.length() - 1);
@@ -244,7 +296,7 @@ auto passwords::generator(int password_length, bool has_upper_case,
     /// Generate the password by randomly selecting characters from the character set
     std::generate_n(std::back_inserter(password),
                     password_length, [&]() -> char {
-        return characters[char_distribution(generator)];
+        return characters[char_distribution(engine)];
     });
 
     return password;
@@ -262,6 +314,9 @@ auto passwords::search(const categories &category) -> void {
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::getline(std::cin, search_param);
 
+    metrics::timer timer(metrics::metric::search);
+    TRACE_SPAN("passwords::search");
+
     /// Initialize a boolean variable
     /// to track if any passwords are found
     bool found = false;
@@ -291,6 +346,67 @@ auto passwords::search(const categories &category) -> void {
     if (!found) fmt::print("\n[-] No Passwords Found\n");
 }
 
+/**
+ * @brief Lists the categories and passwords starting with the given text.
+ *
+ * Answered from the name index, so finding the matches costs the length of
+ * the prefix plus the page shown, however large the vault is. Only the first
+ * page of matches is shown, together with the number of all of them.
+ *
+ * @param category The category object.
+ */
+auto passwords::search_prefix(const categories &category) -> void {
+    std::string prefix;
+    fmt::print("Enter the Prefix: ");
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, prefix);
+
+    TRACE_SPAN("passwords::search_prefix");
+    std::size_t limit = vault_view::configured_page_size();
+    radix_trie::completion category_matches = name_index::category_names().starts_with(prefix, limit);
+    radix_trie::completion password_matches = name_index::password_names().starts_with(prefix, limit);
+
+    if (category_matches.total == 0 && password_matches.total == 0) {
+        fmt::print("\n[-] Nothing Starts With '{}'\n", prefix);
+        return;
+    }
+
+    auto print_rest = [](const radix_trie::completion &found) -> void {
+        if (found.total > found.matches.size()) fmt::print("... and {} More\n", found.total - found.matches.size());
+    };
+
+    if (category_matches.total > 0) {
+        fmt::print("\nCategories ({}):\n", category_matches.total);
+        for (const radix_trie::match &found : category_matches.matches) {
+            fmt::print("[ID: {}] {}\n", found.owner.category_ID, found.name);
+        }
+        print_rest(category_matches);
+    }
+
+    if (password_matches.total > 0) {
+        fmt::print("\nPasswords ({}):\n", password_matches.total);
+        for (const radix_trie::match &found : password_matches.matches) {
+            /// Passwords of the password list have no category
+            auto category_it = category.categories_map.find(found.owner.category_ID);
+            if (category_it == category.categories_map.end()) {
+                fmt::print("[ID: {}] {}\n", found.owner.password_ID, found.name);
+            } else {
+                fmt::print("[Category: '{}', ID: {}] {}\n",
+                           category_it->second.name, found.owner.password_ID, found.name);
+            }
+        }
+        print_rest(password_matches);
+    }
+
+    /// Autocomplete the prefix as far as every match agrees, if they are all of one kind
+    if (category_matches.total == 0 || password_matches.total == 0) {
+        const radix_trie &matched = category_matches.total > 0 ? name_index::category_names()
+                                                               : name_index::password_names();
+        std::pmr::string common = matched.extend(prefix);
+        if (common.size() > prefix.size()) fmt::print("\n[+] Every Match Starts With '{}'\n", common);
+    }
+}
+
 /**
  * @brief Sorts the passwords either in the password list or within each category.
  * @param category The category object.
@@ -301,10 +417,14 @@ auto passwords::sort(categories &category) -> void {
                                       "Invalid input. Please enter a valid option.",
                                       {1, 2});
 
+    metrics::timer timer(metrics::metric::sort);
+    TRACE_SPAN("passwords::sort");
+    memory_tracker::scope scope(memory_tracker::transient::sort);
+
     /// Sort passwords in the password list (_pass_without_categories) by name
     if (sort_option == 1) {
         /// Create temp vector for being able to use std::sort
-        std::vector<std::pair<std::size_t, password>> temp_passwords(
+        std::pmr::vector<std::pair<std::size_t, password>> temp_passwords(
                 std::make_move_iterator(_pass_without_categories.begin()),
                 std::make_move_iterator(_pass_without_categories.end()));
 
@@ -317,7 +437,7 @@ auto passwords::sort(categories &category) -> void {
                   });
 
         /// Update the password list with the sorted passwords
-        _pass_without_categories = std::map<std::size_t, password>(
+        _pass_without_categories = std::pmr::map<std::size_t, password>(
                 std::make_move_iterator(temp_passwords.begin()),
                 std::make_move_iterator(temp_passwords.end()));
 
@@ -356,9 +476,9 @@ auto passwords::sort(categories &category) -> void {
         /// Sort passwords within each category
         for (auto &element : category.categories_map) {
             /// Create temp vector with pairs in order to use std::sort
-            std::vector<std::pair<std::size_t, std::string>> temp_passwords(
-                    element.second.passwords.begin(),
-                    element.second.passwords.end());
+            std::pmr::vector<std::pair<std::size_t, std::pmr::string>> temp_passwords(
+                    std::make_move_iterator(element.second.passwords.begin()),
+                    std::make_move_iterator(element.second.passwords.end()));
 
             /// Sort the passwords by name
             std::sort(temp_passwords.begin(),
@@ -370,10 +490,13 @@ auto passwords::sort(categories &category) -> void {
 
 
             /// Restore the values
-            element.second.passwords = std::map<std::size_t, std::string>(
-                    temp_passwords.begin(),
-                    temp_passwords.end());
+            element.second.passwords = std::pmr::map<std::size_t, std::pmr::string>(
+                    std::make_move_iterator(temp_passwords.begin()),
+                    std::make_move_iterator(temp_passwords.end()));
         }
+
+        /// Categories were renumbered, so mirror the whole vault again
+        history::rebuild(category, *this);
     }
 
     fmt::print("\n[+] Passwords sorted successfully\n");
@@ -391,10 +514,11 @@ auto passwords::remove(categories &category) -> void {
 
     if (delete_option == 1) {
         /// Check if the password list is empty
-        if (!is_printable()) {
-            fmt::print("\n[-] No Passwords Found Inside of Password List");
+        if (empty()) {
+            fmt::print("\n[-] No Passwords Found Inside of Password List\n");
             return;
         }
+        vault_view::preview(*this);
 
         /// Prompt the user to enter the ID of the password to delete
         auto password_id =
@@ -408,15 +532,17 @@ auto passwords::remove(categories &category) -> void {
         if (password_it != _pass_without_categories.end()) {
             /// Delete the password from the password list
             _pass_without_categories.erase(password_it);
+            history::erase_uncategorized(password_id);
             fmt::print("\n[+] Password deleted successfully\n");
         } else fmt::print("\n[-] Password with ID {} not found\n", password_id);
 
     } else if (delete_option == 2) {
         /// Check if there are any categories available
-        if (!category.is_printable()) {
-            fmt::print("\n[-] No Categories Found");
+        if (category.empty()) {
+            fmt::print("\n[-] No Categories Found\n");
             return;
         }
+        vault_view::preview(category);
 
         std::variant<std::size_t, std::string> identifier;
 
@@ -447,8 +573,8 @@ auto passwords::remove(categories &category) -> void {
             if (password_id >= 1 && password_id <= selected_category->passwords.size()) {
                 /// Find the category and delete the password within it
                 auto category_it = category.categories_map.find(selected_category->ID);
-                category_it->second.passwords.erase(
-                        selected_category->passwords.find(password_id));
+                category_it->second.passwords.erase(password_id);
+                history::erase_password(selected_category->ID, password_id);
                 fmt::print("\n[+] Password Deleted Successfully\n");
 
             } else fmt::print("\n[-] Invalid Password ID\n");
@@ -475,22 +601,19 @@ auto passwords::get_password_ids() const -> std::vector<std::size_t> {
 }
 
 /**
- * @brief Checks if the password list is printable.
- * @return True if the password list is not empty, false otherwise.
+ * @brief Retrieves the password list.
+ * @return A read-only reference to the passwords that do not belong to a category.
  */
-auto passwords::is_printable() -> bool {
-    /// Check if the password list is empty
-    bool has_passwords = !_pass_without_categories.empty();
-
-    /// If the password list is not empty, print the passwords
-    if (has_passwords) {
-        for (auto const &pass : _pass_without_categories) {
-            fmt::print("\n[+] ID: {} Name: {}",
-                       pass.second.ID, pass.second.name);
-        }
-    } else fmt::print("\n[-] No Passwords Found\n");
+auto passwords::get_passwords() const -> const std::pmr::map<std::size_t, password>& {
+    return _pass_without_categories;
+}
 
-    return has_passwords;
+/**
+ * @brief Checks if the password list is empty, without printing it.
+ * @return True if the password list is empty, false otherwise.
+ */
+auto passwords::empty() const -> bool {
+    return _pass_without_categories.empty();
 }
 
 /**
@@ -505,11 +628,12 @@ auto passwords::edit(categories &category) -> void {
 
     /// Edit password from the password list
     if (edit_option == 1) {
-        /// Check if the password list is printable
-        if (!is_printable()) {
-            fmt::print("\n[-] No Passwords Found Inside the Password List");
+        /// Check if the password list is empty
+        if (empty()) {
+            fmt::print("\n[-] No Passwords Found Inside the Password List\n");
             return;
         }
+        vault_view::preview(*this);
 
         /// Prompt the user to enter the ID of the password to edit
         auto password_id =
@@ -537,15 +661,23 @@ auto passwords::edit(categories &category) -> void {
             if (is_secure(new_password)) {
                 /// Update the password with the new value
                 password.name = new_password;
+                history::put_uncategorized(password);
                 fmt::print("\n[+] Password Edited Successfully\n");
 
-            } else fmt::print("\n[-] New Password is Not Secure. Please Try Again.\n");
+            } else {
+                fmt::print("\n[-] New Password is Not Secure. Please Try Again.\n");
+                print_weakness(new_password);
+            }
 
         } else fmt::print("\n[-] Password with ID {} Not Found\n", password_id);
 
     } else if (edit_option == 2) {
-        /// Check if any categories are printable (exist)
-        if (!category.is_printable()) return;
+        /// Check if any categories exist
+        if (category.empty()) {
+            fmt::print("\n[-] No Category Found\n");
+            return;
+        }
+        vault_view::preview(category);
 
         std::variant<std::size_t, std::string> identifier;
 
@@ -573,9 +705,9 @@ auto passwords::edit(categories &category) -> void {
             /// Check if the entered password ID is valid
             if (password_id >= 1 && password_id <= selected_category->passwords.size()) {
                 auto category_it = category.categories_map.find(selected_category->ID);
-                std::map<std::size_t, std::string> &passwords =
+                std::pmr::map<std::size_t, std::pmr::string> &passwords =
                         category_it->second.passwords;
-                std::string &password = passwords[password_id];
+                std::pmr::string &password = passwords[password_id];
 
                 fmt::print("\n[+] Editing Password\nID: {} Password: {}\n",
                            password_id, category_it->second.passwords.find(password_id)->second);
@@ -587,9 +719,13 @@ auto passwords::edit(categories &category) -> void {
                 if (is_secure(new_password)) {
                     /// Update the password with the new value
                     password = new_password;
+                    history::put_password(category_it->first, password_id, new_password);
                     fmt::print("\n[+] Password Edited Successfully\n");
 
-                } else fmt::print("\n[-] New Password is Not Secure. Please Try Again.\n");
+                } else {
+                    fmt::print("\n[-] New Password is Not Secure. Please Try Again.\n");
+                    print_weakness(new_password);
+                }
 
             } else fmt::print("\n[-] Invalid Password ID\n");
 
@@ -0,0 +1,142 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include "../include/secure_arena.hpp"
+#include "../include/plaintext_cache.hpp"
+
+/**
+ * @brief Creates an empty cache.
+ * @param capacity The most entries held at once, split evenly over the shards.
+ * @param ttl      How long a decrypted entry may stay, counted from when it was added.
+ */
+plaintext_cache::plaintext_cache(std::size_t capacity, std::chrono::milliseconds ttl)
+        : _shard_capacity(std::max<std::size_t>((capacity + _shard_count - 1) / _shard_count, 1)), _ttl(ttl) { }
+
+plaintext_cache::~plaintext_cache() {
+    clear();
+}
+
+/**
+ * @brief Looks up a decrypted password.
+ * @return A copy of the password, or nullopt if it is not cached or has expired.
+ */
+auto plaintext_cache::get(const key &wanted) -> std::optional<std::pmr::string> {
+    shard &owner = shard_of(wanted);
+    std::lock_guard guard(owner.lock);
+
+    auto found = owner.index.find(wanted);
+    if (found == owner.index.end()) {
+        ++owner.counted.misses;
+        return std::nullopt;
+    }
+
+    auto it = found->second;
+    if (it->expires <= clock::now()) {
+        drop(owner, it);
+        ++owner.counted.expirations;
+        ++owner.counted.misses;
+        return std::nullopt;
+    }
+
+    owner.order.splice(owner.order.begin(), owner.order, it);
+    ++owner.counted.hits;
+    return it->value;
+}
+
+/**
+ * @brief Adds or replaces a decrypted password, evicting the least recently used one if the shard is full.
+ */
+auto plaintext_cache::put(const key &stored, std::string_view value) -> void {
+    shard &owner = shard_of(stored);
+    std::lock_guard guard(owner.lock);
+
+    if (auto found = owner.index.find(stored); found != owner.index.end()) drop(owner, found->second);
+    if (owner.order.size() >= _shard_capacity) {
+        drop(owner, std::prev(owner.order.end()));
+        ++owner.counted.evictions;
+    }
+
+    owner.order.push_front(entry { stored, std::pmr::string(value), clock::now() + _ttl });
+    owner.index.emplace(stored, owner.order.begin());
+}
+
+/**
+ * @brief Removes a password whose stored value changed.
+ */
+auto plaintext_cache::erase(const key &removed) -> void {
+    shard &owner = shard_of(removed);
+    std::lock_guard guard(owner.lock);
+    if (auto found = owner.index.find(removed); found != owner.index.end()) drop(owner, found->second);
+}
+
+/**
+ * @brief Removes every expired entry, so plaintext does not outlive its TTL in an idle cache.
+ * @return The number of removed entries.
+ */
+auto plaintext_cache::sweep() -> std::size_t {
+    std::size_t removed = 0;
+    clock::time_point now = clock::now();
+
+    for (shard &owner : _shards) {
+        std::lock_guard guard(owner.lock);
+        for (auto it = owner.order.begin(); it != owner.order.end();) {
+            auto current = it++;
+            if (current->expires > now) continue;
+            drop(owner, current);
+            ++owner.counted.expirations;
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Removes every entry.
+ */
+auto plaintext_cache::clear() -> void {
+    for (shard &owner : _shards) {
+        std::lock_guard guard(owner.lock);
+        while (!owner.order.empty()) drop(owner, owner.order.begin());
+    }
+}
+
+/**
+ * @brief Sums the counters of every shard.
+ */
+auto plaintext_cache::stats() -> statistics {
+    statistics total;
+    for (shard &owner : _shards) {
+        std::lock_guard guard(owner.lock);
+        total.hits += owner.counted.hits;
+        total.misses += owner.counted.misses;
+        total.evictions += owner.counted.evictions;
+        total.expirations += owner.counted.expirations;
+        total.size += owner.order.size();
+    }
+    return total;
+}
+
+auto plaintext_cache::key_hash::operator()(const key &hashed) const -> std::size_t {
+    std::uint64_t mixed = hashed.category_ID * 0x9E3779B97F4A7C15ULL ^ hashed.password_ID;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    return mixed ^ (mixed >> 31);
+}
+
+auto plaintext_cache::shard_of(const key &wanted) -> shard& {
+    return _shards[key_hash()(wanted) % _shard_count];
+}
+
+/**
+ * @brief Zeroizes an entry and removes it.
+ *
+ * Short passwords live inside the string itself rather than on the heap,
+ * so the whole capacity is wiped here instead of relying on the arena.
+ */
+auto plaintext_cache::drop(shard &owner, std::pmr::list<entry>::iterator it) -> void {
+    secure_arena::zeroize(it->value.data(), it->value.capacity());
+    owner.index.erase(it->stored);
+    owner.order.erase(it);
+}
@@ -0,0 +1,314 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <algorithm>
+#include "../include/radix_trie.hpp"
+#include "../include/secure_arena.hpp"
+
+/**
+ * @brief Creates a trie holding only the root.
+ */
+radix_trie::radix_trie() {
+    _nodes.emplace_back();
+}
+
+radix_trie::~radix_trie() {
+    for (node &destroyed : _nodes) {
+        secure_arena::zeroize(destroyed.label.data(), destroyed.label.capacity());
+    }
+}
+
+/**
+ * @brief Adds an entry under a name.
+ *
+ * Walks down as long as whole labels match, splits the edge where the name
+ * leaves it and hangs the rest of the name below as one new node, so an
+ * insert creates at most two nodes.
+ *
+ * @param name  The name of the entry, may be shared with other entries.
+ * @param owner The entry.
+ */
+auto radix_trie::insert(std::string_view name, reference owner) -> void {
+    index current = _root;
+    ++_nodes[_root].count;
+
+    while (!name.empty()) {
+        auto place = slot(current, name[0]);
+        auto offset = place - _nodes[current].children.cbegin();
+
+        if (place == _nodes[current].children.end() || _nodes[*place].label[0] != name[0]) {
+            index leaf = allocate(name);
+            _nodes[leaf].owners.push_back(owner);
+            _nodes[leaf].count = 1;
+            auto &children = _nodes[current].children;
+            children.insert(children.begin() + offset, leaf);
+            return;
+        }
+
+        index next = *place;
+        std::string_view label = _nodes[next].label;
+        std::size_t common = static_cast<std::size_t>(
+                std::mismatch(label.begin(), label.end(), name.begin(), name.end()).first - label.begin());
+
+        /// The name leaves the edge halfway, so the edge is split there
+        if (common < label.size()) {
+            index middle = allocate(name.substr(0, common));
+            node &lower = _nodes[next];
+            std::size_t length = lower.label.size();
+            lower.label.erase(0, common);
+            secure_arena::zeroize(lower.label.data() + lower.label.size(), length - lower.label.size());
+
+            _nodes[middle].children.push_back(next);
+            _nodes[middle].count = lower.count;
+            _nodes[current].children[static_cast<std::size_t>(offset)] = middle;
+            next = middle;
+        }
+
+        name.remove_prefix(common);
+        current = next;
+        ++_nodes[current].count;
+    }
+
+    _nodes[current].owners.push_back(owner);
+}
+
+/**
+ * @brief Removes an entry from under a name.
+ *
+ * Frees the node if nothing else ends below it and merges what is left
+ * with its only child, so the trie stays compressed.
+ *
+ * @param name  The name the entry was added under.
+ * @param owner The entry.
+ * @return False if the entry is not under that name.
+ */
+auto radix_trie::erase(std::string_view name, reference owner) -> bool {
+    std::pmr::vector<index> path { _root };
+    index current = _root;
+
+    while (!name.empty()) {
+        auto next = child(current, name[0]);
+        if (next == _nodes[current].children.end() || !name.starts_with(_nodes[*next].label)) return false;
+        name.remove_prefix(_nodes[*next].label.size());
+        current = *next;
+        path.push_back(current);
+    }
+
+    auto &owners = _nodes[current].owners;
+    auto found = std::find(owners.begin(), owners.end(), owner);
+    if (found == owners.end()) return false;
+    owners.erase(found);
+    for (index passed : path) --_nodes[passed].count;
+
+    if (current != _root && _nodes[current].count == 0) {
+        path.pop_back();
+        auto &siblings = _nodes[path.back()].children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), current));
+        release(current);
+        current = path.back();
+    }
+    merge(current);
+    return true;
+}
+
+/**
+ * @brief Removes every entry and zeroizes every label.
+ */
+auto radix_trie::clear() -> void {
+    for (node &cleared : _nodes) {
+        secure_arena::zeroize(cleared.label.data(), cleared.label.capacity());
+    }
+    _nodes.clear();
+    _free.clear();
+    _nodes.emplace_back();
+}
+
+/**
+ * @brief Looks up the entries with exactly this name.
+ * @return The entries, in the order they were added, empty if there is none.
+ */
+auto radix_trie::find(std::string_view name) const -> std::span<const reference> {
+    position at = locate(name);
+    if (!at.exists || at.covered != _nodes[at.found].label.size()) return { };
+    return _nodes[at.found].owners;
+}
+
+/**
+ * @brief Returns the first entries whose name starts with a prefix, in name order.
+ *
+ * Finding the prefix costs its length. From there the subtree is walked
+ * depth first and the walk stops after the limit, so the cost does not
+ * depend on how many names match in total.
+ *
+ * @param prefix The start of the names, empty for all of them.
+ * @param limit  The most matches to return.
+ * @return The matches and the number of all entries starting with the prefix.
+ */
+auto radix_trie::starts_with(std::string_view prefix, std::size_t limit) const -> completion {
+    completion result;
+    position at = locate(prefix);
+    if (!at.exists) return result;
+
+    result.total = _nodes[at.found].count;
+    result.matches.reserve(std::min(limit, result.total));
+
+    /// The name of a node is the name of its parent plus its label
+    struct frame {
+        index visited;
+        std::size_t parent_length;
+    };
+
+    std::pmr::string name(prefix);
+    std::pmr::vector<frame> pending { frame { at.found, prefix.size() - at.covered } };
+
+    while (!pending.empty() && result.matches.size() < limit) {
+        frame current = pending.back();
+        pending.pop_back();
+
+        const node &visited = _nodes[current.visited];
+        name.resize(current.parent_length);
+        name.append(visited.label);
+
+        for (const reference &owner : visited.owners) {
+            if (result.matches.size() == limit) break;
+            result.matches.push_back(match { name, owner });
+        }
+        for (auto it = visited.children.rbegin(); it != visited.children.rend(); ++it) {
+            pending.push_back(frame { *it, name.size() });
+        }
+    }
+
+    secure_arena::zeroize(name.data(), name.capacity());
+    return result;
+}
+
+/**
+ * @brief Counts the entries whose name starts with a prefix, in time proportional to the prefix.
+ */
+auto radix_trie::count(std::string_view prefix) const -> std::size_t {
+    position at = locate(prefix);
+    return at.exists ? _nodes[at.found].count : 0;
+}
+
+/**
+ * @brief Autocompletes a prefix as far as it is unambiguous.
+ *
+ * @param prefix The typed text.
+ * @return The longest text every name starting with the prefix starts with,
+ *         the prefix itself if no name starts with it.
+ */
+auto radix_trie::extend(std::string_view prefix) const -> std::pmr::string {
+    std::pmr::string extended(prefix);
+    position at = locate(prefix);
+    if (!at.exists) return extended;
+
+    extended.append(std::string_view(_nodes[at.found].label).substr(at.covered));
+    for (index current = at.found;
+         _nodes[current].owners.empty() && _nodes[current].children.size() == 1;) {
+        current = _nodes[current].children.front();
+        extended.append(_nodes[current].label);
+    }
+    return extended;
+}
+
+/**
+ * @brief Returns the number of entries.
+ */
+auto radix_trie::size() const -> std::size_t {
+    return _nodes[_root].count;
+}
+
+/**
+ * @brief Follows a prefix down from the root.
+ * @return The node the prefix ends in, or ends halfway into the label of.
+ */
+auto radix_trie::locate(std::string_view prefix) const -> position {
+    index current = _root;
+
+    while (!prefix.empty()) {
+        auto found = child(current, prefix[0]);
+        if (found == _nodes[current].children.end()) return { };
+
+        std::string_view label = _nodes[*found].label;
+        std::size_t compared = std::min(label.size(), prefix.size());
+        if (label.substr(0, compared) != prefix.substr(0, compared)) return { };
+        if (prefix.size() <= label.size()) return position { *found, prefix.size(), true };
+
+        prefix.remove_prefix(label.size());
+        current = *found;
+    }
+    return position { current, _nodes[current].label.size(), true };
+}
+
+/**
+ * @brief Finds where the child whose label starts with a letter is, or would be inserted.
+ */
+auto radix_trie::slot(index parent, char letter) const -> std::pmr::vector<index>::const_iterator {
+    const auto &children = _nodes[parent].children;
+    return std::lower_bound(children.begin(), children.end(), letter, [this](index candidate, char wanted) {
+        return before(_nodes[candidate].label[0], wanted);
+    });
+}
+
+/**
+ * @brief Finds the child whose label starts with a letter.
+ * @return The child, or the end of the children if there is none.
+ */
+auto radix_trie::child(index parent, char letter) const -> std::pmr::vector<index>::const_iterator {
+    auto found = slot(parent, letter);
+    if (found != _nodes[parent].children.end() && _nodes[*found].label[0] != letter) return _nodes[parent].children.end();
+    return found;
+}
+
+/**
+ * @brief Takes a node from the free list, or adds one.
+ * @param label The label of the new node, must not point into the trie.
+ */
+auto radix_trie::allocate(std::string_view label) -> index {
+    index allocated;
+    if (!_free.empty()) {
+        allocated = _free.back();
+        _free.pop_back();
+    } else {
+        allocated = static_cast<index>(_nodes.size());
+        _nodes.emplace_back();
+    }
+    _nodes[allocated].label.assign(label);
+    return allocated;
+}
+
+/**
+ * @brief Zeroizes a node and puts it on the free list.
+ */
+auto radix_trie::release(index freed) -> void {
+    node &released = _nodes[freed];
+    secure_arena::zeroize(released.label.data(), released.label.capacity());
+    released.label.clear();
+    released.children.clear();
+    released.owners.clear();
+    released.count = 0;
+    _free.push_back(freed);
+}
+
+/**
+ * @brief Merges a node that no entry ends in with its only child.
+ */
+auto radix_trie::merge(index parent) -> void {
+    node &upper = _nodes[parent];
+    if (parent == _root || !upper.owners.empty() || upper.children.size() != 1) return;
+
+    index lower = upper.children.front();
+    upper.label.append(_nodes[lower].label);
+    upper.children = std::move(_nodes[lower].children);
+    upper.owners = std::move(_nodes[lower].owners);
+    release(lower);
+}
+
+/**
+ * @brief Orders letters the way std::string compares them.
+ */
+auto radix_trie::before(char left, char right) -> bool {
+    return static_cast<unsigned char>(left) < static_cast<unsigned char>(right);
+}
@@ -0,0 +1,200 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <charconv>
+#include "../include/trace.hpp"
+#include "../include/cryptor.hpp"
+#include "../include/keyring.hpp"
+#include "../include/sealed_vault.hpp"
+#include "../include/secure_arena.hpp"
+
+/**
+ * @brief Creates an empty vault.
+ * @param limits The size and TTL of the plaintext cache.
+ */
+sealed_vault::sealed_vault(const settings &limits) : _cache(limits.capacity, limits.ttl) { }
+
+/**
+ * @brief Encrypts the whole vault into this one and empties the plaintext maps.
+ *
+ * Every category is encrypted and then cleared before the next one, so the
+ * plaintext and its ciphertext only exist side by side for one category.
+ *
+ * @param category The categories to take over, left empty.
+ * @param password The password list to take over, left empty.
+ */
+auto sealed_vault::seal(categories &category, passwords &password) -> void {
+    TRACE_SPAN("sealed_vault::seal");
+    std::unique_lock guard(_lock);
+    _sections.clear();
+    _cache.clear();
+
+    auto seal_section = [](std::size_t ID, section &sealed, auto &plaintext, auto value_of) {
+        sealed.key = keyring::data_key(ID);
+        for (const auto &[password_ID, value] : plaintext) {
+            sealed.sealed.emplace_hint(sealed.sealed.end(), password_ID, cryptor::encrypt(value_of(value), sealed.key));
+        }
+        plaintext.clear();
+    };
+
+    for (auto &[category_ID, element] : category.categories_map) {
+        TRACE_SPAN_ARG("sealed_vault::seal_category", category_ID);
+        section &sealed = _sections[category_ID];
+        sealed.name = element.name;
+        sealed.next_password_ID = element._pass_id;
+        seal_section(category_ID, sealed, element.passwords,
+                     [](const std::pmr::string &value) -> std::string_view { return value; });
+    }
+    category.categories_map.clear();
+    _next_category_ID = category._current_ID;
+
+    section &list = _sections[keyring::list_ID];
+    list.next_password_ID = password._current_ID;
+    seal_section(keyring::list_ID, list, password._pass_without_categories,
+                 [](const passwords::password &value) -> std::string_view { return value.name; });
+}
+
+/**
+ * @brief Decrypts the whole vault back into the plaintext maps, for saving it.
+ * @param category The categories object to fill.
+ * @param password The passwords object to fill.
+ */
+auto sealed_vault::unseal(categories &category, passwords &password) -> void {
+    TRACE_SPAN("sealed_vault::unseal");
+    std::unique_lock guard(_lock);
+    category.categories_map.clear();
+    password._pass_without_categories.clear();
+
+    for (const auto &[ID, sealed] : _sections) {
+        if (ID == keyring::list_ID) {
+            auto &list = password._pass_without_categories;
+            for (const auto &[password_ID, value] : sealed.sealed) {
+                list.emplace_hint(list.end(), password_ID,
+                                  passwords::password { password_ID, cryptor::decrypt(value, sealed.key) });
+            }
+            password._current_ID = sealed.next_password_ID;
+            continue;
+        }
+
+        categories::category &element = category.categories_map[ID];
+        element.ID = ID;
+        element.name = sealed.name;
+        element._pass_id = sealed.next_password_ID;
+        for (const auto &[password_ID, value] : sealed.sealed) {
+            element.passwords.emplace_hint(element.passwords.end(), password_ID, cryptor::decrypt(value, sealed.key));
+        }
+    }
+    category._current_ID = _next_category_ID;
+}
+
+/**
+ * @brief Looks up one password, decrypting it only if it is not cached.
+ * @param category_ID The category of the password, 0 for the password list.
+ * @param password_ID The ID of the password.
+ * @return The password, or nullopt if it does not exist.
+ */
+auto sealed_vault::get(std::size_t category_ID, std::size_t password_ID) -> std::optional<std::pmr::string> {
+    plaintext_cache::key wanted { category_ID, password_ID };
+    if (std::optional<std::pmr::string> cached = _cache.get(wanted)) return cached;
+
+    std::shared_lock guard(_lock);
+    auto section_it = _sections.find(category_ID);
+    if (section_it == _sections.end()) return std::nullopt;
+    auto sealed_it = section_it->second.sealed.find(password_ID);
+    if (sealed_it == section_it->second.sealed.end()) return std::nullopt;
+
+    std::pmr::string value = cryptor::decrypt(sealed_it->second, section_it->second.key);
+    _cache.put(wanted, value);
+    return value;
+}
+
+/**
+ * @brief Encrypts and adds a password.
+ * @param category_ID The category to add the password to, 0 for the password list.
+ * @param value       The password to add.
+ * @return The ID assigned to the password, or nullopt if the category does not exist.
+ */
+auto sealed_vault::add(std::size_t category_ID, std::string_view value) -> std::optional<std::size_t> {
+    std::unique_lock guard(_lock);
+    auto section_it = _sections.find(category_ID);
+    if (section_it == _sections.end()) return std::nullopt;
+
+    section &sealed = section_it->second;
+    std::size_t password_ID = sealed.next_password_ID++;
+    sealed.sealed.emplace_hint(sealed.sealed.end(), password_ID, cryptor::encrypt(value, sealed.key));
+    _cache.erase({ category_ID, password_ID });
+    return password_ID;
+}
+
+/**
+ * @brief Finds every password containing the search parameter.
+ *
+ * Every password has to be decrypted for this, each into a temporary that
+ * is zeroized right after. The matches are not cached, so a search does not
+ * push the passwords that are actually in use out of the cache.
+ *
+ * @param search_param The text to look for.
+ * @param found        Called with the category ID, password ID and password of every match.
+ */
+auto sealed_vault::search(std::string_view search_param,
+                          const std::function<void(std::size_t, std::size_t, std::string_view)> &found) const -> void {
+    TRACE_SPAN("sealed_vault::search");
+    std::shared_lock guard(_lock);
+
+    for (const auto &[ID, sealed] : _sections) {
+        for (const auto &[password_ID, value] : sealed.sealed) {
+            std::pmr::string plaintext = cryptor::decrypt(value, sealed.key);
+            if (plaintext.find(search_param) != std::pmr::string::npos) found(ID, password_ID, plaintext);
+            secure_arena::zeroize(plaintext.data(), plaintext.capacity());
+        }
+    }
+}
+
+/**
+ * @brief Drops the cached passwords that outlived their TTL.
+ */
+auto sealed_vault::sweep() -> void {
+    _cache.sweep();
+}
+
+auto sealed_vault::print_statistics() -> void {
+    plaintext_cache::statistics counted = _cache.stats();
+    std::uint64_t lookups = counted.hits + counted.misses;
+    fmt::print("[+] Plaintext Cache: {} Hits, {} Misses ({:.1f}% Hit Rate), {} Evictions, {} Expired, {} Held Now\n",
+               counted.hits, counted.misses, lookups > 0 ? 100.0 * static_cast<double>(counted.hits) / static_cast<double>(lookups) : 0.0,
+               counted.evictions, counted.expirations, counted.size);
+}
+
+/**
+ * @brief Returns the cache limits, GUARDCIPHER_CACHE overrides them with "size=<entries>,ttl=<seconds>".
+ */
+auto sealed_vault::configured() -> settings {
+    settings limits;
+    const char *environment = std::getenv("GUARDCIPHER_CACHE");
+    if (environment == nullptr) return limits;
+
+    std::string_view text = environment;
+    while (!text.empty()) {
+        std::size_t comma = text.find(',');
+        std::string_view field = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+
+        std::size_t equals = field.find('=');
+        std::string_view name = field.substr(0, equals);
+        std::size_t value = 0;
+        const char *end = field.data() + field.size();
+        bool parsed = equals != std::string_view::npos
+                      && std::from_chars(field.data() + equals + 1, end, value).ptr == end;
+
+        if (parsed && name == "size" && value > 0) limits.capacity = value;
+        else if (parsed && name == "ttl" && value > 0) limits.ttl = std::chrono::seconds(value);
+        else {
+            fmt::print("[-] Invalid GUARDCIPHER_CACHE '{}', Using size={},ttl={}\n", environment,
+                       settings().capacity, std::chrono::duration_cast<std::chrono::seconds>(settings().ttl).count());
+            return { };
+        }
+    }
+    return limits;
+}
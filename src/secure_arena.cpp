@@ -0,0 +1,284 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <new>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fmt/core.h>
+#include <sys/mman.h>
+#include "../include/secure_arena.hpp"
+
+secure_arena::secure_arena() = default;
+
+secure_arena::~secure_arena() {
+    release();
+    for (std::atomic<shard*> &created : _shards) delete created.load();
+}
+
+secure_arena::shard::shard(std::size_t index)
+    : pages(index), pool(std::pmr::pool_options { 0, _largest_pooled }, &pages) { }
+
+/**
+ * @brief Returns the arena that holds the plaintext of the vault.
+ *
+ * The arena object itself is never destroyed, so containers with static storage
+ * duration (such as the undo history) can still free into it while the program
+ * exits. Its memory is released earlier, when main returns.
+ */
+auto secure_arena::instance() -> secure_arena& {
+    static auto *arena = new secure_arena;
+    return *arena;
+}
+
+/**
+ * @brief Overwrites memory with zeros in a way the compiler cannot elide.
+ * @param pointer The memory to clear.
+ * @param bytes   The number of bytes to clear.
+ */
+auto secure_arena::zeroize(void *pointer, std::size_t bytes) -> void {
+    if (pointer == nullptr || bytes == 0) return;
+
+    std::memset(pointer, 0, bytes);
+    /// Tells the optimizer the cleared memory is still observed
+    asm volatile("" : : "r"(pointer) : "memory");
+}
+
+/**
+ * @brief Returns all memory to the system after zeroizing it.
+ *
+ * Every block allocated from the arena becomes invalid, so main empties the
+ * static containers first. Blocks freed afterwards are ignored, and the few
+ * allocations made while the program exits come from the heap.
+ */
+auto secure_arena::release() -> void {
+    _released.store(true, std::memory_order_release);
+    for (std::atomic<shard*> &created : _shards) {
+        shard *current = created.load(std::memory_order_acquire);
+        if (current == nullptr) continue;
+
+        std::lock_guard guard(current->lock);
+        current->pool.release();
+        current->pages.release();
+    }
+}
+
+/**
+ * @brief Returns how much memory the arena holds, used or not.
+ */
+auto secure_arena::usage() -> footprint {
+    footprint total;
+    for (std::atomic<shard*> &created : _shards) {
+        shard *current = created.load(std::memory_order_acquire);
+        if (current == nullptr) continue;
+
+        std::lock_guard guard(current->lock);
+        footprint part = current->pages.usage();
+        total.mapped += part.mapped;
+        total.locked += part.locked;
+        total.chunks += part.chunks;
+    }
+    return total;
+}
+
+/**
+ * @brief Allocates a block from the pool of the calling thread's shard.
+ */
+auto secure_arena::do_allocate(std::size_t bytes, std::size_t alignment) -> void* {
+    if (_released.load(std::memory_order_acquire)) {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    shard &current = current_shard();
+    std::lock_guard guard(current.lock);
+    return current.pool.allocate(bytes, alignment);
+}
+
+/**
+ * @brief Zeroizes a block and hands it back to the pool of the shard that owns it.
+ */
+auto secure_arena::do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) -> void {
+    if (_released.load(std::memory_order_acquire)) return;
+
+    zeroize(pointer, bytes);
+
+    /// The shard exists, it mapped the chunk of the block
+    shard &owner = *_shards[secure_arena::owner(pointer)].load(std::memory_order_acquire);
+    std::lock_guard guard(owner.lock);
+    owner.pool.deallocate(pointer, bytes, alignment);
+}
+
+auto secure_arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool {
+    return this == &other;
+}
+
+/**
+ * @brief Returns the shard of the calling thread, threads are spread over the shards in turn.
+ */
+auto secure_arena::current_shard() -> shard& {
+    thread_local std::size_t index = _next_shard.fetch_add(1, std::memory_order_relaxed) % _shard_count;
+
+    shard *current = _shards[index].load(std::memory_order_acquire);
+    if (current != nullptr) return *current;
+
+    std::lock_guard guard(_creating);
+    current = _shards[index].load(std::memory_order_relaxed);
+    if (current == nullptr) {
+        current = new shard(index);
+        _shards[index].store(current, std::memory_order_release);
+    }
+    return *current;
+}
+
+/**
+ * @brief Records the shard that owns every granule of a new chunk.
+ */
+auto secure_arena::record(const std::byte *base, std::size_t size, std::size_t shard) -> void {
+    auto address = reinterpret_cast<std::uintptr_t>(base);
+    for (std::uintptr_t granule = address; granule < address + size; granule += _chunk_size) {
+        std::atomic<std::uint8_t*> &root = _owners[(granule >> (_granule_bits + _leaf_bits)) & (_owners.size() - 1)];
+
+        std::uint8_t *leaf = root.load(std::memory_order_acquire);
+        if (leaf == nullptr) {
+            auto *created = new std::uint8_t[std::size_t { 1 } << _leaf_bits]();
+            /// Another shard may have added the leaf in the meantime
+            if (root.compare_exchange_strong(leaf, created, std::memory_order_acq_rel)) {
+                leaf = created;
+            } else {
+                delete[] created;
+            }
+        }
+        leaf[(granule >> _granule_bits) & ((std::size_t { 1 } << _leaf_bits) - 1)] = static_cast<std::uint8_t>(shard);
+    }
+}
+
+/**
+ * @brief Returns the shard that owns the chunk of a block.
+ */
+auto secure_arena::owner(const void *pointer) -> std::size_t {
+    auto address = reinterpret_cast<std::uintptr_t>(pointer);
+    const std::atomic<std::uint8_t*> &root = _owners[(address >> (_granule_bits + _leaf_bits)) & (_owners.size() - 1)];
+    const std::uint8_t *leaf = root.load(std::memory_order_acquire);
+    return leaf[(address >> _granule_bits) & ((std::size_t { 1 } << _leaf_bits) - 1)];
+}
+
+secure_arena::locked_pages::locked_pages(std::size_t shard) : _shard(shard) { }
+
+secure_arena::locked_pages::~locked_pages() {
+    release();
+}
+
+/**
+ * @brief Zeroizes, unlocks and unmaps every chunk.
+ */
+auto secure_arena::locked_pages::release() -> void {
+    for (chunk &mapped : _chunks) {
+        zeroize(mapped.base, mapped.size);
+        if (mapped.locked) munlock(mapped.base, mapped.size);
+        munmap(mapped.base, mapped.size);
+    }
+
+    _chunks.clear();
+    _spare.clear();
+    _offset = 0;
+}
+
+auto secure_arena::locked_pages::usage() const -> footprint {
+    footprint total;
+    for (const chunk &mapped : _chunks) {
+        total.mapped += mapped.size;
+        if (mapped.locked) total.locked += mapped.size;
+    }
+    total.chunks = _chunks.size();
+    return total;
+}
+
+/**
+ * @brief Bumps the pointer of the newest chunk, mapping a new one when it is full.
+ *
+ * A returned block of the same rounded size is reused first.
+ * Requests larger than a chunk get a chunk of their own.
+ */
+auto secure_arena::locked_pages::do_allocate(std::size_t bytes, std::size_t alignment) -> void* {
+    bytes = round_up(bytes);
+
+    auto spare = _spare.find(bytes);
+    if (spare != _spare.end() && alignment <= alignof(std::max_align_t)) {
+        std::byte *block = spare->second;
+        _spare.erase(spare);
+        return block;
+    }
+
+    if (!_chunks.empty()) {
+        chunk &newest = _chunks.back();
+        std::size_t aligned = (_offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= newest.size) {
+            _offset = aligned + bytes;
+            return newest.base + aligned;
+        }
+    }
+
+    chunk *mapped = map_chunk(bytes);
+    _offset = bytes;
+    return mapped->base;
+}
+
+/**
+ * @brief Keeps a returned block for reuse, chunks are only unmapped by release().
+ *
+ * The block has already been zeroized by the arena.
+ */
+auto secure_arena::locked_pages::do_deallocate(void *pointer, std::size_t bytes, std::size_t) -> void {
+    _spare.emplace(round_up(bytes), static_cast<std::byte*>(pointer));
+}
+
+auto secure_arena::locked_pages::do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool {
+    return this == &other;
+}
+
+/**
+ * @brief Maps and locks a new chunk of at least the given size.
+ *
+ * When the memory lock limit is reached the chunk is used unlocked and
+ * a warning is printed once, rather than refusing to store the vault.
+ */
+auto secure_arena::locked_pages::map_chunk(std::size_t minimum) -> chunk* {
+    std::size_t size = std::max(minimum, _chunk_size);
+    size = (size + _chunk_size - 1) / _chunk_size * _chunk_size;
+
+    /// Maps one chunk more than needed and trims it, so the chunk starts on a granule
+    void *reserved = mmap(nullptr, size + _chunk_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) throw std::bad_alloc();
+
+    auto start = reinterpret_cast<std::uintptr_t>(reserved);
+    std::uintptr_t aligned = (start + _chunk_size - 1) & ~(std::uintptr_t { _chunk_size } - 1);
+    if (aligned > start) munmap(reserved, aligned - start);
+    munmap(reinterpret_cast<void*>(aligned + size), _chunk_size - (aligned - start));
+    void *base = reinterpret_cast<void*>(aligned);
+
+#ifdef MADV_DONTDUMP
+    /// Keeps the secrets out of core dumps
+    madvise(base, size, MADV_DONTDUMP);
+#endif
+
+    bool locked = mlock(base, size) == 0;
+    if (!locked && !_warned) {
+        fmt::print(stderr, "[-] Could Not Lock the Vault Memory, Secrets May Be Swapped to Disk\n");
+        _warned = true;
+    }
+
+    record(static_cast<std::byte*>(base), size, _shard);
+    _chunks.push_back({ static_cast<std::byte*>(base), size, locked });
+    return &_chunks.back();
+}
+
+/**
+ * @brief Rounds a request up to whole pages, so that returned blocks fit similar requests.
+ */
+auto secure_arena::locked_pages::round_up(std::size_t bytes) -> std::size_t {
+    constexpr std::size_t page = 4096;
+    return (bytes + page - 1) / page * page;
+}
@@ -0,0 +1,102 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <bit>
+#include <cstring>
+#include "../include/sha1.hpp"
+
+sha1::sha1() : _state { 0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U, 0xC3D2E1F0U } { }
+
+auto sha1::update(const void *data, std::size_t size) -> void {
+    const auto *bytes = static_cast<const std::uint8_t*>(data);
+    _length += size;
+
+    while (size > 0) {
+        std::size_t taken = std::min(size, _buffer.size() - _buffered);
+        std::memcpy(_buffer.data() + _buffered, bytes, taken);
+        _buffered += taken;
+        bytes += taken;
+        size -= taken;
+
+        if (_buffered == _buffer.size()) {
+            compress();
+            _buffered = 0;
+        }
+    }
+}
+
+/**
+ * @brief Pads the message and returns the digest, the object must not be used afterwards.
+ */
+auto sha1::final() -> digest {
+    std::uint64_t bits = _length * 8;
+    constexpr std::uint8_t marker = 0x80;
+    update(&marker, 1);
+
+    constexpr std::uint8_t zero = 0;
+    while (_buffered != 56) update(&zero, 1);
+
+    std::uint8_t length[8];
+    for (int i = 0; i < 8; ++i) length[i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+    update(length, sizeof(length));
+
+    digest result;
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        result[i] = static_cast<std::uint8_t>(_state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+    return result;
+}
+
+/**
+ * @brief Hashes a string in one call.
+ */
+auto sha1::hash(std::string_view data) -> digest {
+    sha1 hasher;
+    hasher.update(data.data(), data.size());
+    return hasher.final();
+}
+
+/**
+ * @brief Mixes the buffered 64-byte block into the state.
+ */
+auto sha1::compress() -> void {
+    std::uint32_t w[80];
+    for (std::size_t i = 0; i < 16; ++i) {
+        w[i] = static_cast<std::uint32_t>(_buffer[i * 4]) << 24 | static_cast<std::uint32_t>(_buffer[i * 4 + 1]) << 16
+             | static_cast<std::uint32_t>(_buffer[i * 4 + 2]) << 8 | _buffer[i * 4 + 3];
+    }
+    for (std::size_t i = 16; i < 80; ++i) w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    auto [a, b, c, d, e] = _state;
+    for (std::size_t i = 0; i < 80; ++i) {
+        std::uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999U;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1U;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDCU;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6U;
+        }
+
+        std::uint32_t next = std::rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = std::rotl(b, 30);
+        b = a;
+        a = next;
+    }
+
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+    _state[4] += e;
+}
@@ -0,0 +1,472 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <cctype>
+#include <algorithm>
+#include <fmt/format.h>
+#include "../include/strength.hpp"
+#include "../include/static_trie.hpp"
+#include "../include/dictionaries.hpp"
+
+namespace {
+    constexpr auto password_trie = make_static_trie<dictionaries::passwords>();
+    constexpr auto word_trie = make_static_trie<dictionaries::words>();
+    constexpr auto name_trie = make_static_trie<dictionaries::names>();
+
+    /// Shorter dictionary matches are left to brute force
+    constexpr std::size_t min_word_length = 3;
+
+    /// Letters a character commonly stands in for
+    constexpr auto substitutes(char c) -> std::string_view {
+        switch (c) {
+            case '4': case '@': return "a";
+            case '8': return "b";
+            case '(': case '{': case '[': case '<': return "c";
+            case '3': return "e";
+            case '6': case '9': return "g";
+            case '1': return "il";
+            case '!': case '|': return "i";
+            case '0': return "o";
+            case '$': case '5': return "s";
+            case '7': case '+': return "t";
+            case '%': return "x";
+            case '2': return "z";
+            default: return { };
+        }
+    }
+
+    constexpr auto lower(char c) -> char {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    /**
+     * @brief Reports every word of the trie that starts at begin, trying the
+     *        substitutes of a character as well as the character itself.
+     */
+    template <typename Trie, typename Report>
+    auto walk(const Trie &trie, std::string_view text, std::size_t begin, std::size_t position,
+              typename Trie::index node, int substitutions, Report &report) -> void {
+        if (position == text.size()) return;
+
+        auto visit = [&](char letter, int used) {
+            typename Trie::index next = trie.child(node, letter);
+            if (next == 0) return;
+            if (trie.rank(next) != 0 && position + 1 - begin >= min_word_length) {
+                report(begin, position + 1, trie.rank(next), used);
+            }
+            walk(trie, text, begin, position + 1, next, used, report);
+        };
+
+        visit(lower(text[position]), substitutions);
+        for (char letter : substitutes(text[position])) visit(letter, substitutions + 1);
+    }
+
+    /// Where a key sits on a QWERTY keyboard, rows are shifted half a key to the right each
+    struct key_position {
+        std::int8_t row = -1;
+        std::int8_t column = 0;
+        bool shifted = false;
+    };
+
+    constexpr auto keyboard_layout() {
+        constexpr std::array<std::string_view, 4> rows { "`1234567890-=", "qwertyuiop[]\\", "asdfghjkl;'", "zxcvbnm,./" };
+        constexpr std::array<std::string_view, 4> shifted { "~!@#$%^&*()_+", "QWERTYUIOP{}|", "ASDFGHJKL:\"", "ZXCVBNM<>?" };
+
+        std::array<key_position, 128> layout { };
+        for (std::size_t row = 0; row < rows.size(); ++row) {
+            for (std::size_t column = 0; column < rows[row].size(); ++column) {
+                auto r = static_cast<std::int8_t>(row);
+                auto c = static_cast<std::int8_t>(column);
+                layout[static_cast<unsigned char>(rows[row][column])] = { r, c, false };
+                layout[static_cast<unsigned char>(shifted[row][column])] = { r, c, true };
+            }
+        }
+        return layout;
+    }
+
+    constexpr auto keyboard = keyboard_layout();
+    /// Keys and average number of neighbours of the QWERTY graph
+    constexpr double keyboard_starts = 94;
+    constexpr double keyboard_degree = 4.595;
+
+    /// Which of the six neighbours b is of a, -1 if they are not adjacent
+    auto direction(char a, char b) -> int {
+        auto ua = static_cast<unsigned char>(a), ub = static_cast<unsigned char>(b);
+        if (ua >= keyboard.size() || ub >= keyboard.size()) return -1;
+
+        const key_position &from = keyboard[ua], &to = keyboard[ub];
+        if (from.row < 0 || to.row < 0) return -1;
+
+        int rows = to.row - from.row, columns = to.column - from.column;
+        if (rows == 0 && columns == -1) return 0;
+        if (rows == 0 && columns == 1) return 1;
+        if (rows == -1 && columns == 0) return 2;
+        if (rows == -1 && columns == 1) return 3;
+        if (rows == 1 && columns == -1) return 4;
+        if (rows == 1 && columns == 0) return 5;
+        return -1;
+    }
+
+    auto binomial(unsigned n, unsigned k) -> double {
+        if (k > n) return 0;
+        double result = 1;
+        for (unsigned i = 1; i <= k; ++i) result = result * (n - k + i) / i;
+        return result;
+    }
+
+    auto cardinality(char c) -> double {
+        if (std::isdigit(static_cast<unsigned char>(c))) return 10;
+        if (std::isalpha(static_cast<unsigned char>(c))) return 26;
+        return 33;
+    }
+
+    auto reference_year() -> int {
+        static const int year = static_cast<int>(std::chrono::year_month_day(
+                std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now())).year());
+        return year;
+    }
+
+    /// Brute force guesses by length, ten per character as in zxcvbn
+    constexpr auto powers_of_ten = [] {
+        std::array<double, 65> powers { 1 };
+        for (std::size_t i = 1; i < powers.size(); ++i) powers[i] = powers[i - 1] * 10;
+        return powers;
+    }();
+
+    constexpr std::array<std::string_view, 8> pattern_names {
+            "Random Characters", "Common Password", "Common Word", "Common Name",
+            "Keyboard Pattern", "Sequence", "Repeated Characters", "Year",
+    };
+}
+
+/**
+ * @brief Estimates the guesses needed for a password.
+ *
+ * Runs in a few microseconds for typical passwords and never allocates,
+ * so it can be called on every add and edit and over the whole vault.
+ *
+ * @param password The password to rate.
+ * @return The guesses, the score from 0 (trivial) to 4 (strong) and the weakest pattern.
+ */
+auto strength::measure(std::string_view password) -> estimate {
+    if (password.empty()) return { };
+
+    estimate result = cover(password.substr(0, _analyzed_length), true);
+    if (password.size() > _analyzed_length) {
+        result.guesses *= std::pow(10.0, static_cast<double>(password.size() - _analyzed_length));
+    }
+    result.guesses = std::min(result.guesses, 1e100);
+    result.score = score(result.guesses);
+    return result;
+}
+
+/**
+ * @brief Returns a readable name for a pattern.
+ */
+auto strength::describe(pattern weakness) -> std::string_view {
+    return pattern_names[static_cast<std::size_t>(weakness)];
+}
+
+/**
+ * @brief Rates every stored password and lists the ones below the minimum score.
+ *
+ * Only the location of a weak password is printed, never the password.
+ *
+ * @param category The categories object to audit.
+ * @param password The passwords object to audit.
+ */
+auto strength::audit(const categories &category, const passwords &password) -> void {
+    std::array<std::size_t, 5> scores { };
+    std::size_t weak = 0;
+    std::chrono::steady_clock::duration elapsed { };
+
+    auto rate = [&](std::string_view value, std::string_view location) {
+        auto start = std::chrono::steady_clock::now();
+        estimate rating = measure(value);
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        ++scores[static_cast<std::size_t>(rating.score)];
+        if (rating.score >= minimum_score) return;
+        if (weak++ == 0) fmt::print("\n{:<40} {:>6} {:>12}  {}\n", "Location", "Score", "Guesses", "Weakness");
+        fmt::print("{:<40} {:>6} {:>12.2g}  {}\n", location, rating.score, rating.guesses, describe(rating.weakest));
+    };
+
+    for (const auto &[category_ID, element] : category.categories_map) {
+        for (const auto &[password_ID, value] : element.passwords) {
+            rate(value, fmt::format("Category '{}' ID {}", element.name, password_ID));
+        }
+    }
+    for (const auto &[password_ID, value] : password.get_passwords()) {
+        rate(value.name, fmt::format("Password List ID {}", password_ID));
+    }
+
+    std::size_t total = 0;
+    for (std::size_t count : scores) total += count;
+    if (total == 0) {
+        fmt::print("\n[-] No Passwords to Audit\n");
+        return;
+    }
+
+    double microseconds = std::chrono::duration<double, std::micro>(elapsed).count();
+    fmt::print("\n[+] Audited {} Passwords in {:.0f} us ({:.2f} us Each), {} Below Score {}\n",
+               total, microseconds, microseconds / static_cast<double>(total), weak, minimum_score);
+    fmt::print("Scores: 0: {}, 1: {}, 2: {}, 3: {}, 4: {}\n", scores[0], scores[1], scores[2], scores[3], scores[4]);
+}
+
+auto strength::match_list::add(const match &found) -> void {
+    if (size < items.size()) items[size++] = found;
+}
+
+/**
+ * @brief Finds the cheapest cover of the password by matches and brute force.
+ *
+ * As in zxcvbn a cover of l parts costs l! times the product of its guesses,
+ * plus 10000^(l-1), which keeps many small matches from beating brute force.
+ *
+ * @param allow_repeats Whether repeated blocks are matched, off when rating the block itself.
+ */
+auto strength::cover(std::string_view password, bool allow_repeats) -> estimate {
+    match_list found;
+    match_dictionaries(password, found);
+    match_keyboard(password, found);
+    match_sequences(password, found);
+    match_years(password, found);
+    if (allow_repeats) match_repeats(password, found);
+
+    std::sort(found.items.begin(), found.items.begin() + static_cast<std::ptrdiff_t>(found.size),
+              [](const match &a, const match &b) -> bool { return a.end < b.end; });
+
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    struct step {
+        double product = infinity;
+        std::uint8_t begin = 0;
+        pattern kind = pattern::brute_force;
+    };
+
+    std::size_t n = password.size();
+    std::array<std::array<step, _max_cover + 1>, _analyzed_length + 1> best;
+    best[0][0].product = 1;
+
+    std::size_t next = 0;
+    for (std::size_t k = 1; k <= n; ++k) {
+        auto extend = [&best, k](std::size_t begin, double guesses, pattern kind) {
+            for (std::size_t l = 1; l <= _max_cover; ++l) {
+                double candidate = best[begin][l - 1].product * guesses;
+                if (candidate < best[k][l].product) best[k][l] = { candidate, static_cast<std::uint8_t>(begin), kind };
+            }
+        };
+
+        for (; next < found.size && found.items[next].end == k; ++next) {
+            extend(found.items[next].begin, found.items[next].guesses, found.items[next].kind);
+        }
+        for (std::size_t begin = 0; begin < k; ++begin) {
+            std::size_t length = k - begin;
+            extend(begin, std::max(powers_of_ten[length], length == 1 ? 11.0 : 51.0), pattern::brute_force);
+        }
+    }
+
+    estimate result;
+    result.guesses = infinity;
+    std::size_t parts = 0;
+    double factorial = 1;
+    for (std::size_t l = 1; l <= _max_cover; ++l) {
+        factorial *= static_cast<double>(l);
+        double guesses = factorial * best[n][l].product + std::pow(10000.0, static_cast<double>(l - 1));
+        if (guesses < result.guesses) {
+            result.guesses = guesses;
+            parts = l;
+        }
+    }
+
+    std::size_t longest = 0;
+    for (std::size_t k = n; parts > 0; --parts) {
+        const step &part = best[k][parts];
+        if (part.kind != pattern::brute_force && k - part.begin > longest) {
+            longest = k - part.begin;
+            result.weakest = part.kind;
+        }
+        k = part.begin;
+    }
+    return result;
+}
+
+/**
+ * @brief Matches the dictionaries forwards and backwards.
+ *
+ * A match costs the rank of the word, times the ways its letters could be
+ * capitalized, times two per substituted letter and times two if reversed.
+ */
+auto strength::match_dictionaries(std::string_view password, match_list &found) -> void {
+    std::array<char, _analyzed_length> reversed_buffer { };
+    std::reverse_copy(password.begin(), password.end(), reversed_buffer.begin());
+    std::string_view reversed(reversed_buffer.data(), password.size());
+
+    auto search = [&](const auto &trie, pattern kind) {
+        for (bool backwards : { false, true }) {
+            std::string_view text = backwards ? reversed : password;
+            auto report = [&](std::size_t begin, std::size_t end, std::uint16_t rank, int substitutions) {
+                std::size_t first = backwards ? password.size() - end : begin;
+                std::size_t last = backwards ? password.size() - begin : end;
+                double guesses = rank * case_variations(password.substr(first, last - first))
+                                 * std::pow(2.0, substitutions) * (backwards ? 2 : 1);
+                found.add({ static_cast<std::uint8_t>(first), static_cast<std::uint8_t>(last), kind, guesses });
+            };
+            for (std::size_t begin = 0; begin < text.size(); ++begin) walk(trie, text, begin, begin, 0, 0, report);
+        }
+    };
+
+    search(password_trie, pattern::common_password);
+    search(word_trie, pattern::common_word);
+    search(name_trie, pattern::common_name);
+}
+
+/**
+ * @brief Matches walks of three or more adjacent keys.
+ *
+ * Costs what zxcvbn charges: every walk of up to this length with up to
+ * this many turns from any start key, times the ways of using shift.
+ */
+auto strength::match_keyboard(std::string_view password, match_list &found) -> void {
+    std::size_t begin = 0;
+    while (begin + 2 < password.size()) {
+        std::size_t end = begin + 1;
+        int last_direction = -1;
+        unsigned turns = 0;
+        while (end < password.size()) {
+            int current = direction(password[end - 1], password[end]);
+            if (current < 0) break;
+            if (current != last_direction) ++turns;
+            last_direction = current;
+            ++end;
+        }
+
+        std::size_t length = end - begin;
+        if (length >= 3) {
+            double guesses = 0;
+            for (unsigned i = 2; i <= length; ++i) {
+                for (unsigned j = 1; j <= std::min(turns, i - 1); ++j) {
+                    guesses += binomial(i - 1, j - 1) * keyboard_starts * std::pow(keyboard_degree, j);
+                }
+            }
+
+            unsigned shifted = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                shifted += keyboard[static_cast<unsigned char>(password[i]) & 0x7F].shifted ? 1 : 0;
+            }
+            auto unshifted = static_cast<unsigned>(length) - shifted;
+            if (shifted == 0 || unshifted == 0) guesses *= shifted == 0 ? 1 : 2;
+            else {
+                double variations = 0;
+                for (unsigned i = 1; i <= std::min(shifted, unshifted); ++i) variations += binomial(length, i);
+                guesses *= variations;
+            }
+
+            found.add({ static_cast<std::uint8_t>(begin), static_cast<std::uint8_t>(end), pattern::keyboard, guesses });
+        }
+        begin = end - 1 > begin ? end - 1 : begin + 1;
+    }
+}
+
+/**
+ * @brief Matches runs like "abc", "9753" or "ZYX" with a constant step of at most five.
+ */
+auto strength::match_sequences(std::string_view password, match_list &found) -> void {
+    std::size_t begin = 0;
+    while (begin + 2 < password.size()) {
+        int step = password[begin + 1] - password[begin];
+        std::size_t end = begin + 1;
+        while (end < password.size() && password[end] - password[end - 1] == step
+               && std::isalnum(static_cast<unsigned char>(password[end]))) ++end;
+
+        bool alphanumeric = std::isalnum(static_cast<unsigned char>(password[begin])) != 0;
+        if (end - begin >= 3 && step != 0 && std::abs(step) <= 5 && alphanumeric) {
+            double base = std::string_view("aAzZ019").find(password[begin]) != std::string_view::npos ? 4
+                        : cardinality(password[begin]);
+            double guesses = base * static_cast<double>(end - begin) * (step < 0 ? 2 : 1);
+            found.add({ static_cast<std::uint8_t>(begin), static_cast<std::uint8_t>(end), pattern::sequence, guesses });
+        }
+        begin = end - 1 > begin ? end - 1 : begin + 1;
+    }
+}
+
+/**
+ * @brief Matches a character repeated three or more times and a block repeated twice or more.
+ *
+ * A repeat costs the guesses of its block times the number of repetitions.
+ */
+auto strength::match_repeats(std::string_view password, match_list &found) -> void {
+    for (std::size_t begin = 0; begin < password.size(); ++begin) {
+        for (std::size_t period = 1; begin + 2 * period <= password.size(); ++period) {
+            std::string_view block = password.substr(begin, period);
+            /// Only the longest run of a block is matched, from where it starts
+            if (begin >= period && password.substr(begin - period, period) == block) continue;
+
+            std::size_t count = 1;
+            while (begin + (count + 1) * period <= password.size()
+                   && password.substr(begin + count * period, period) == block) ++count;
+            if (count < 2 || (period == 1 && count < 3)) continue;
+
+            double base = period == 1 ? cardinality(block[0]) : cover(block, false).guesses;
+            found.add({ static_cast<std::uint8_t>(begin), static_cast<std::uint8_t>(begin + count * period),
+                        pattern::repeat, base * static_cast<double>(count) });
+        }
+    }
+}
+
+/**
+ * @brief Matches the years 1900 to 2099, a year costs its distance from today but at least 20.
+ */
+auto strength::match_years(std::string_view password, match_list &found) -> void {
+    for (std::size_t begin = 0; begin + 4 <= password.size(); ++begin) {
+        int year = 0;
+        bool digits = true;
+        for (std::size_t i = begin; i < begin + 4 && digits; ++i) {
+            digits = std::isdigit(static_cast<unsigned char>(password[i])) != 0;
+            year = year * 10 + (password[i] - '0');
+        }
+        if (!digits || year < 1900 || year > 2099) continue;
+
+        double guesses = std::max(std::abs(year - reference_year()), 20);
+        found.add({ static_cast<std::uint8_t>(begin), static_cast<std::uint8_t>(begin + 4), pattern::year, guesses });
+    }
+}
+
+/**
+ * @brief Counts the ways a word could have been capitalized, as zxcvbn does.
+ *
+ * All lowercase costs nothing extra, a capital first or last letter or all
+ * capitals doubles the guesses, anything else counts every arrangement.
+ */
+auto strength::case_variations(std::string_view word) -> double {
+    unsigned upper = 0, lower = 0;
+    for (char c : word) {
+        upper += std::isupper(static_cast<unsigned char>(c)) ? 1 : 0;
+        lower += std::islower(static_cast<unsigned char>(c)) ? 1 : 0;
+    }
+    if (upper == 0) return 1;
+    if (lower == 0) return 2;
+
+    bool first_only = upper == 1 && std::isupper(static_cast<unsigned char>(word.front()));
+    bool last_only = upper == 1 && std::isupper(static_cast<unsigned char>(word.back()));
+    if (first_only || last_only) return 2;
+
+    double variations = 0;
+    for (unsigned i = 1; i <= std::min(upper, lower); ++i) variations += binomial(upper + lower, i);
+    return variations;
+}
+
+/**
+ * @brief Maps guesses to the zxcvbn scores 0 to 4.
+ */
+auto strength::score(double guesses) -> int {
+    if (guesses < 1e3) return 0;
+    if (guesses < 1e6) return 1;
+    if (guesses < 1e8) return 2;
+    if (guesses < 1e10) return 3;
+    return 4;
+}
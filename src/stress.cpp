@@ -0,0 +1,185 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <map>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <charconv>
+#include <string_view>
+#include <fmt/core.h>
+
+#include "../include/secure_arena.hpp"
+#include "../include/concurrent_vault.hpp"
+
+/**
+ * @brief Mixed read/write stress test of concurrent_vault.
+ *
+ * Every writer owns a category and adds, edits and removes passwords in it,
+ * keeping its own copy of what the category should hold. A value names its
+ * writer, its ID and its revision, so readers can check every password they
+ * see without knowing the timing. Readers check that a snapshot never changes
+ * while they hold it and that lookups only return values a writer wrote.
+ * Once the writers are done, the final version has to match their copies.
+ *
+ * The vault allocates from the secure arena as in the program, so blocks
+ * freed by another thread than the one that allocated them are covered too.
+ * Meant to be run under -fsanitize=thread as well.
+ */
+
+namespace {
+    std::atomic<std::size_t> failures { 0 };
+
+    auto fail(std::string_view what) -> void {
+        if (failures.fetch_add(1) < 10) fmt::print(stderr, "[-] {}\n", what);
+    }
+
+    /// The value written as revision of a password
+    auto value_of(std::size_t writer, std::size_t password_ID, std::size_t revision) -> std::string {
+        return fmt::format("w{}-{}-v{}", writer, password_ID, revision);
+    }
+
+    /// Checks that a value was written by the owner of the category for this password
+    auto well_formed(std::string_view category_name, std::size_t password_ID, std::string_view value) -> bool {
+        std::string_view writer = category_name.substr(category_name.find('-') + 1);
+        std::string prefix = fmt::format("w{}-{}-v", writer, password_ID);
+        return value.starts_with(prefix);
+    }
+
+    /// Rolls every name and password of a version into one hash
+    auto content_hash(const vault_state &state) -> std::uint64_t {
+        std::uint64_t hash = 0;
+        state.categories_map.for_each([&](std::size_t category_ID, const vault_state::category_version &category) {
+            hash = vault_state::hash(category.name, hash + category_ID);
+            category.passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+                hash = vault_state::hash(value, hash + password_ID);
+            });
+        });
+        return hash;
+    }
+
+    auto write(concurrent_vault &vault, std::size_t writer, std::size_t operations,
+               std::map<std::size_t, std::string> &expected) -> std::size_t {
+        std::size_t category_ID = vault.add_category(fmt::format("writer-{}", writer));
+        std::mt19937_64 engine(writer);
+        std::map<std::size_t, std::size_t> revisions;
+
+        for (std::size_t i = 0; i < operations; ++i) {
+            std::size_t roll = engine() % 10;
+            if (expected.empty() || roll < 5) {
+                /// Only this writer adds to the category, so the next ID follows the highest one ever added
+                std::size_t password_ID = revisions.empty() ? 1 : revisions.rbegin()->first + 1;
+                std::optional<std::size_t> added = vault.add_password(category_ID, value_of(writer, password_ID, 0));
+                if (!added || *added != password_ID) fail(fmt::format("Writer {} Got an Unexpected Password ID", writer));
+                expected[password_ID] = value_of(writer, password_ID, 0);
+                revisions[password_ID] = 0;
+                continue;
+            }
+
+            auto picked = std::next(expected.begin(), static_cast<std::ptrdiff_t>(engine() % expected.size()));
+            if (roll < 8) {
+                std::size_t revision = ++revisions[picked->first];
+                picked->second = value_of(writer, picked->first, revision);
+                if (!vault.edit_password(category_ID, picked->first, picked->second)) {
+                    fail(fmt::format("Writer {} Failed to Edit Password {}", writer, picked->first));
+                }
+            } else {
+                if (!vault.remove_password(category_ID, picked->first)) {
+                    fail(fmt::format("Writer {} Failed to Remove Password {}", writer, picked->first));
+                }
+                expected.erase(picked);
+            }
+        }
+        return category_ID;
+    }
+
+    auto read(const concurrent_vault &vault, const std::atomic<bool> &done, std::size_t reader) -> std::size_t {
+        std::mt19937_64 engine(reader + 1000);
+        std::size_t rounds = 0;
+
+        while (!done.load()) {
+            std::shared_ptr<const vault_state> state = vault.snapshot();
+            std::uint64_t before = content_hash(*state);
+
+            state->categories_map.for_each([&](std::size_t, const vault_state::category_version &category) {
+                category.passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+                    if (!well_formed(category.name, password_ID, value)) {
+                        fail(fmt::format("Snapshot Holds a Foreign Value '{}'", value));
+                    }
+                });
+
+                /// A lookup sees the current version, the password may be gone or newer by now
+                if (category._pass_id > 1) {
+                    std::size_t password_ID = 1 + engine() % (category._pass_id - 1);
+                    std::optional<std::pmr::string> found = vault.get(category.ID, password_ID);
+                    if (found && !well_formed(category.name, password_ID, *found)) {
+                        fail(fmt::format("Lookup Returned a Foreign Value '{}'", *found));
+                    }
+                }
+            });
+
+            for (const concurrent_vault::match &found : vault.search("-v1")) {
+                if (found.password.find("-v1") == std::string::npos) fail("Search Returned a Non-Match");
+            }
+
+            if (content_hash(*state) != before) fail("Snapshot Changed While It Was Held");
+            ++rounds;
+        }
+        return rounds;
+    }
+
+    auto parse_number(std::string_view text, std::size_t &value) -> bool {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+}
+
+auto main(int argc, char *argv[]) -> int {
+    std::size_t readers = 4, writers = 2, operations = 20000;
+    if (argc > 4 || (argc > 1 && !parse_number(argv[1], readers)) || (argc > 2 && !parse_number(argv[2], writers))
+        || (argc > 3 && !parse_number(argv[3], operations))) {
+        fmt::print(stderr, "Usage: {} [readers] [writers] [operations per writer]\n", argv[0]);
+        return 2;
+    }
+
+    std::pmr::set_default_resource(&secure_arena::instance());
+
+    concurrent_vault vault;
+    std::atomic<bool> done = false;
+    std::vector<std::map<std::size_t, std::string>> expected(writers);
+    std::vector<std::size_t> owned(writers), rounds(readers);
+    {
+        std::vector<std::jthread> reading;
+        for (std::size_t i = 0; i < readers; ++i) {
+            reading.emplace_back([&, i] { rounds[i] = read(vault, done, i); });
+        }
+        {
+            std::vector<std::jthread> writing;
+            for (std::size_t i = 0; i < writers; ++i) {
+                writing.emplace_back([&, i] { owned[i] = write(vault, i, operations, expected[i]); });
+            }
+        }
+        done.store(true);
+    }
+
+    std::shared_ptr<const vault_state> state = vault.snapshot();
+    for (std::size_t i = 0; i < writers; ++i) {
+        const vault_state::category_version *category = state->categories_map.find(owned[i]);
+        std::map<std::size_t, std::string> found;
+        if (category != nullptr) {
+            category->passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+                found.emplace(password_ID, value);
+            });
+        }
+        if (found != expected[i]) fail(fmt::format("Category of Writer {} Does Not Match Its Writes", i));
+    }
+
+    std::size_t total_rounds = 0;
+    for (std::size_t count : rounds) total_rounds += count;
+    fmt::print("[{}] {} Readers Walked {} Snapshots While {} Writers Applied {} Operations, {} Failures\n",
+               failures.load() == 0 ? '+' : '-', readers, total_rounds, writers, writers * operations, failures.load());
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include "../include/trace.hpp"
+
+#ifdef GUARDCIPHER_TRACE
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include <fmt/format.h>
+
+/**
+ * @brief Starts a span, it ends when the object is destroyed.
+ * @param name The span name, must be a string literal.
+ */
+trace::span::span(const char *name) : _name(name), _argument(0), _has_argument(false), _start(now()) { }
+
+/**
+ * @brief Starts a span that carries a numeric argument, such as a category ID.
+ * @param name     The span name, must be a string literal.
+ * @param argument Shown as "id" in the span details.
+ */
+trace::span::span(const char *name, std::uint64_t argument)
+        : _name(name), _argument(argument), _has_argument(true), _start(now()) { }
+
+trace::span::~span() {
+    push({ _name, 0, _start, now() - _start, _argument, _has_argument });
+}
+
+/**
+ * @brief Writes every recorded span as Chrome trace-event JSON.
+ *
+ * Meant to run once the worker threads are done, as the rings are read without locking them.
+ *
+ * @param filename The file to write.
+ * @return True if the file was written.
+ */
+auto trace::write(const std::string &filename) -> bool {
+    fmt::memory_buffer buffer;
+    fmt::format_to(std::back_inserter(buffer), "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    std::lock_guard guard(_lock);
+    bool first = true;
+    for (const auto &thread_ring : _rings) {
+        std::uint64_t written = thread_ring->written.load(std::memory_order_acquire);
+        std::uint64_t capacity = thread_ring->events.size();
+        std::uint64_t oldest = written > capacity ? written - capacity : 0;
+
+        for (std::uint64_t i = oldest; i < written; ++i) {
+            const event &recorded = thread_ring->events[i % capacity];
+            if (!first) buffer.push_back(',');
+            first = false;
+
+            fmt::format_to(std::back_inserter(buffer),
+                           "\n{{\"name\":\"{}\",\"cat\":\"guardcipher\",\"ph\":\"X\",\"pid\":{},\"tid\":{},"
+                           "\"ts\":{:.3f},\"dur\":{:.3f}",
+                           recorded.name, getpid(), recorded.thread_ID,
+                           static_cast<double>(recorded.start) / 1e3, static_cast<double>(recorded.duration) / 1e3);
+            if (recorded.has_argument) {
+                fmt::format_to(std::back_inserter(buffer), ",\"args\":{{\"id\":{}}}", recorded.argument);
+            }
+            buffer.push_back('}');
+        }
+    }
+    fmt::format_to(std::back_inserter(buffer), "\n]}}\n");
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Writes the trace to GUARDCIPHER_TRACE_FILE, if it is set.
+ */
+trace::exit_writer::~exit_writer() {
+    const char *filename = std::getenv("GUARDCIPHER_TRACE_FILE");
+    if (filename == nullptr || *filename == '\0') return;
+
+    if (!write(filename)) fmt::print(stderr, "[-] Failed to Write the Trace to '{}'\n", filename);
+}
+
+/**
+ * @brief Releases the ring of an exiting thread, keeping its events.
+ */
+trace::owner::~owner() {
+    std::lock_guard guard(_lock);
+    current->in_use = false;
+}
+
+/**
+ * @brief Returns nanoseconds since the first call, the time base of all spans.
+ */
+auto trace::now() -> std::uint64_t {
+    static const auto origin = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - origin).count());
+}
+
+/**
+ * @brief Returns the ring of the calling thread, reusing one left by an exited thread.
+ */
+auto trace::local() -> owner& {
+    thread_local owner mine = [] {
+        std::lock_guard guard(_lock);
+        for (const auto &thread_ring : _rings) {
+            if (!thread_ring->in_use) {
+                thread_ring->in_use = true;
+                return owner { thread_ring.get(), _next_thread_ID++ };
+            }
+        }
+
+        _rings.push_back(std::make_unique<ring>());
+        return owner { _rings.back().get(), _next_thread_ID++ };
+    }();
+    return mine;
+}
+
+/**
+ * @brief Appends an event to the ring of the calling thread.
+ */
+auto trace::push(const event &recorded) -> void {
+    owner &mine = local();
+    ring &target = *mine.current;
+
+    std::uint64_t written = target.written.load(std::memory_order_relaxed);
+    event &slot = target.events[written % target.events.size()];
+    slot = recorded;
+    slot.thread_ID = mine.thread_ID;
+    target.written.store(written + 1, std::memory_order_release);
+}
+
+#endif
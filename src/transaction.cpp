@@ -0,0 +1,463 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <charconv>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include "../include/trace.hpp"
+#include "../include/history.hpp"
+#include "../include/metrics.hpp"
+#include "../include/vault_file.hpp"
+#include "../include/transaction.hpp"
+
+/**
+ * @brief Starts an empty transaction on the vault.
+ * @param category The categories the transaction will be committed to.
+ */
+transaction::transaction(const categories &category) : _first_category_ID(category._current_ID) { }
+
+/**
+ * @brief Stages a new category.
+ * @param name The name of the category.
+ * @return The ID the category will get, to stage its passwords with.
+ */
+auto transaction::add_category(std::string_view name) -> std::size_t {
+    std::size_t category_ID = _first_category_ID + _added_categories++;
+    _operations.push_back({ kind::add_category, category_ID, 0, std::pmr::string(name) });
+    return category_ID;
+}
+
+/**
+ * @brief Stages the removal of a category and all of its passwords.
+ */
+auto transaction::remove_category(std::size_t category_ID) -> void {
+    _operations.push_back({ kind::remove_category, category_ID, 0, { } });
+}
+
+/**
+ * @brief Stages a new password.
+ * @param category_ID The category to add the password to, 0 for the password list.
+ * @param password    The password to add.
+ */
+auto transaction::add_password(std::size_t category_ID, std::string_view password) -> void {
+    _operations.push_back({ kind::add_password, category_ID, 0, std::pmr::string(password) });
+}
+
+/**
+ * @brief Stages a new value for an existing password.
+ * @param category_ID The category holding the password, 0 for the password list.
+ * @param password_ID The ID of the password.
+ * @param password    The new password.
+ */
+auto transaction::edit_password(std::size_t category_ID, std::size_t password_ID,
+                                std::string_view password) -> void {
+    _operations.push_back({ kind::edit_password, category_ID, password_ID, std::pmr::string(password) });
+}
+
+/**
+ * @brief Stages the removal of a password.
+ * @param category_ID The category holding the password, 0 for the password list.
+ * @param password_ID The ID of the password.
+ */
+auto transaction::remove_password(std::size_t category_ID, std::size_t password_ID) -> void {
+    _operations.push_back({ kind::remove_password, category_ID, password_ID, { } });
+}
+
+auto transaction::size() const -> std::size_t {
+    return _operations.size();
+}
+
+auto transaction::operations() const -> const std::vector<operation>& {
+    return _operations;
+}
+
+/**
+ * @brief Checks every staged change without applying any of them.
+ *
+ * Each change is checked against the vault as the changes staged before it
+ * would leave it, which is tracked in an overlay of the touched categories
+ * and passwords instead of a copy of the vault.
+ *
+ * @param category The categories the transaction would be committed to.
+ * @param password The password list the transaction would be committed to.
+ * @return Every change that cannot be applied, empty if the transaction can be committed.
+ */
+auto transaction::validate(const categories &category, const passwords &password) const -> std::vector<failure> {
+    TRACE_SPAN("transaction::validate");
+    std::vector<failure> failures;
+    if (_added_categories > 0 && category._current_ID != _first_category_ID) {
+        failures.push_back({ 0, "Categories Were Added to the Vault After the Transaction Began" });
+        return failures;
+    }
+
+    struct overlay {
+        bool exists = false;
+        /// Added by this transaction, so nothing of it is in the vault yet
+        bool added = false;
+        std::size_t next_password_ID = 1;
+        /// Passwords added (true) or removed (false) by this transaction
+        std::unordered_map<std::size_t, bool> present;
+    };
+    std::unordered_map<std::size_t, overlay> overlays;
+
+    auto state = [&](std::size_t category_ID) -> overlay& {
+        auto [it, inserted] = overlays.try_emplace(category_ID);
+        if (!inserted) return it->second;
+
+        if (category_ID == 0) {
+            it->second.exists = true;
+            it->second.next_password_ID = password._current_ID;
+        } else if (auto existing = category.categories_map.find(category_ID); existing != category.categories_map.end()) {
+            it->second.exists = true;
+            it->second.next_password_ID = existing->second._pass_id;
+        }
+        return it->second;
+    };
+    auto has_password = [&](std::size_t category_ID, const overlay &current, std::size_t password_ID) -> bool {
+        if (auto it = current.present.find(password_ID); it != current.present.end()) return it->second;
+        if (current.added) return false;
+        if (category_ID == 0) return password._pass_without_categories.contains(password_ID);
+        return category.categories_map.find(category_ID)->second.passwords.contains(password_ID);
+    };
+    auto not_found = [](std::size_t category_ID) -> std::string {
+        return category_ID == 0 ? "the Password List" : fmt::format("Category {}", category_ID);
+    };
+
+    /// The security check is the expensive part, so it is left for one parallel pass at the end
+    std::vector<std::size_t> rated;
+    std::vector<const std::pmr::string*> values;
+
+    for (std::size_t i = 0; i < _operations.size(); ++i) {
+        const operation &staged = _operations[i];
+        overlay &current = state(staged.category_ID);
+
+        switch (staged.type) {
+            case kind::add_category:
+                if (staged.value.empty()) {
+                    failures.push_back({ i, "The Category Name Cannot Be Empty" });
+                    break;
+                }
+                current = overlay { true, true, 1, { } };
+                break;
+
+            case kind::remove_category:
+                if (staged.category_ID == 0) failures.push_back({ i, "The Password List Cannot Be Removed" });
+                else if (!current.exists) failures.push_back({ i, fmt::format("Category {} Not Found", staged.category_ID) });
+                else current.exists = false;
+                break;
+
+            case kind::add_password:
+                if (!current.exists) {
+                    failures.push_back({ i, fmt::format("Category {} Not Found", staged.category_ID) });
+                    break;
+                }
+                current.present[current.next_password_ID++] = true;
+                rated.push_back(i);
+                values.push_back(&staged.value);
+                break;
+
+            case kind::edit_password:
+            case kind::remove_password:
+                if (!current.exists) {
+                    failures.push_back({ i, fmt::format("Category {} Not Found", staged.category_ID) });
+                } else if (!has_password(staged.category_ID, current, staged.password_ID)) {
+                    failures.push_back({ i, fmt::format("Password {} Not Found in {}",
+                                                        staged.password_ID, not_found(staged.category_ID)) });
+                } else if (staged.type == kind::remove_password) {
+                    current.present[staged.password_ID] = false;
+                } else {
+                    rated.push_back(i);
+                    values.push_back(&staged.value);
+                }
+                break;
+        }
+    }
+
+    std::vector<bool> secure = secure_all(values);
+    for (std::size_t i = 0; i < rated.size(); ++i) {
+        if (!secure[i]) failures.push_back({ rated[i], "The Password is Not Secure" });
+    }
+    std::sort(failures.begin(), failures.end(),
+              [](const failure &a, const failure &b) -> bool { return a.index < b.index; });
+    return failures;
+}
+
+/**
+ * @brief Applies every staged change, or none of them if any fails validation.
+ *
+ * On success the changes are recorded as one undo step and the transaction is emptied.
+ *
+ * @param category The categories object to change.
+ * @param password The passwords object to change.
+ * @param label    Description of the changes, shown on undo and redo.
+ * @return The changes that failed validation, empty if the transaction was committed.
+ */
+auto transaction::commit(categories &category, passwords &password, const std::string &label) -> std::vector<failure> {
+    std::vector<failure> failures = validate(category, password);
+    if (!failures.empty()) return failures;
+
+    apply(category, password, true);
+    history::commit(label);
+
+    _operations.clear();
+    _first_category_ID = category._current_ID;
+    _added_categories = 0;
+    return failures;
+}
+
+/**
+ * @brief Rates all passwords with passwords::is_secure on every core.
+ * @return Whether each password is secure, in the order of the given values.
+ */
+auto transaction::secure_all(const std::vector<const std::pmr::string*> &values) -> std::vector<bool> {
+    TRACE_SPAN("transaction::secure_all");
+    std::vector<char> secure(values.size());
+
+    /// Workers take small chunks so one slow breach lookup does not hold up the rest
+    constexpr std::size_t chunk = 64;
+    std::atomic<std::size_t> next_chunk = 0;
+    auto work = [&]() {
+        for (std::size_t begin = next_chunk++ * chunk; begin < values.size(); begin = next_chunk++ * chunk) {
+            std::size_t end = std::min(begin + chunk, values.size());
+            for (std::size_t i = begin; i < end; ++i) secure[i] = passwords::is_secure(*values[i]);
+        }
+    };
+
+    std::size_t chunk_count = (values.size() + chunk - 1) / chunk;
+    std::size_t thread_count = std::min<std::size_t>(chunk_count, std::max(1U, std::thread::hardware_concurrency()));
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < thread_count; ++i) workers.emplace_back(work);
+        work();
+    }
+    return { secure.begin(), secure.end() };
+}
+
+/**
+ * @brief Applies the validated changes, grouped by category.
+ *
+ * A stable sort by category keeps the order of the changes within each
+ * category, which is the only order that matters between them. Each category
+ * is then looked up once, and new passwords and categories always get the
+ * highest IDs, so they are appended with a hint instead of searched for.
+ *
+ * @param category The categories object to change.
+ * @param password The passwords object to change.
+ * @param record   Mirror the changes in the undo history.
+ */
+auto transaction::apply(categories &category, passwords &password, bool record) const -> void {
+    metrics::timer timer(metrics::metric::transaction_commit);
+    TRACE_SPAN("transaction::apply");
+
+    std::vector<std::size_t> order(_operations.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) -> bool {
+        return _operations[a].category_ID < _operations[b].category_ID;
+    });
+
+    /// A change to a large share of the vault is cheaper to mirror by rebuilding the history once
+    std::size_t vault_size = category.categories_map.size() + password._pass_without_categories.size();
+    for (const auto &element : category.categories_map) vault_size += element.second.passwords.size();
+    bool patch = record && _operations.size() * _rebuild_ratio <= vault_size;
+
+    for (std::size_t begin = 0, end; begin < order.size(); begin = end) {
+        std::size_t category_ID = _operations[order[begin]].category_ID;
+        for (end = begin + 1; end < order.size() && _operations[order[end]].category_ID == category_ID; ++end) { }
+
+        if (category_ID == 0) {
+            TRACE_SPAN("transaction::apply_list");
+            auto &list = password._pass_without_categories;
+            for (std::size_t i = begin; i < end; ++i) {
+                const operation &staged = _operations[order[i]];
+                if (staged.type == kind::add_password) {
+                    std::size_t password_ID = password._current_ID++;
+                    auto it = list.emplace_hint(list.end(), password_ID, passwords::password { password_ID, staged.value });
+                    if (patch) history::put_uncategorized(it->second);
+                } else if (staged.type == kind::edit_password) {
+                    auto it = list.find(staged.password_ID);
+                    it->second.name = staged.value;
+                    if (patch) history::put_uncategorized(it->second);
+                } else {
+                    list.erase(staged.password_ID);
+                    if (patch) history::erase_uncategorized(staged.password_ID);
+                }
+            }
+            continue;
+        }
+
+        TRACE_SPAN_ARG("transaction::apply_category", category_ID);
+        auto category_it = category.categories_map.find(category_ID);
+        bool added = false;
+        for (std::size_t i = begin; i < end; ++i) {
+            const operation &staged = _operations[order[i]];
+            switch (staged.type) {
+                case kind::add_category: {
+                    categories::category created;
+                    created.ID = category_ID;
+                    created.name = staged.value;
+                    category_it = category.categories_map.emplace_hint(category.categories_map.end(),
+                                                                       category_ID, std::move(created));
+                    added = true;
+                    break;
+                }
+                case kind::remove_category:
+                    category.categories_map.erase(category_it);
+                    category_it = category.categories_map.end();
+                    if (patch) history::erase_category(category_ID);
+                    break;
+                case kind::add_password: {
+                    auto &passwords = category_it->second.passwords;
+                    std::size_t password_ID = category_it->second._pass_id++;
+                    passwords.emplace_hint(passwords.end(), password_ID, staged.value);
+                    if (patch && !added) history::put_password(category_ID, password_ID, staged.value);
+                    break;
+                }
+                case kind::edit_password:
+                    category_it->second.passwords.find(staged.password_ID)->second = staged.value;
+                    if (patch && !added) history::put_password(category_ID, staged.password_ID, staged.value);
+                    break;
+                case kind::remove_password:
+                    category_it->second.passwords.erase(staged.password_ID);
+                    if (patch && !added) history::erase_password(category_ID, staged.password_ID);
+                    break;
+            }
+        }
+
+        /// A new category is recorded once with all of its passwords
+        if (patch && added && category_it != category.categories_map.end()) history::put_category(category_it->second);
+    }
+
+    category._current_ID = std::max(category._current_ID, _first_category_ID + _added_categories);
+    if (record && !patch) history::rebuild(category, password);
+}
+
+/**
+ * @brief Applies a migration script to a vault file and saves it once.
+ *
+ * Every line of the script stages one change, empty lines and lines
+ * starting with '#' are skipped:
+ *
+ *     category <name>
+ *     remove-category <category>
+ *     add <category> <password>
+ *     edit <category> <password ID> <password>
+ *     remove <category> <password ID>
+ *
+ * A category is its ID, 0 for the password list or +N for the Nth
+ * category added by the script. If any line fails, nothing is changed.
+ *
+ * @param vault_filename  The vault file to change.
+ * @param script_filename The script to apply.
+ * @param check_only      Only validate the script, leave the vault file alone.
+ * @return True if the script was valid and, unless only checked, the vault was saved.
+ */
+auto transaction::run(const std::string &vault_filename, const std::string &script_filename, bool check_only) -> bool {
+    std::ifstream script(script_filename);
+    if (!script) {
+        fmt::print("[-] Cannot Open '{}'\n", script_filename);
+        return false;
+    }
+
+    std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+    if (key.empty()) {
+        fmt::print("[-] The Secret Key Cannot Be Empty\n");
+        return false;
+    }
+
+    categories category;
+    passwords password;
+    if (!vault_file::load(category, password, vault_filename, key)) return false;
+
+    transaction batch(category);
+    std::vector<std::size_t> added;
+    std::vector<std::size_t> lines;
+
+    auto next_token = [](std::string_view &rest) -> std::string_view {
+        std::size_t begin = rest.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) begin = rest.size();
+        std::size_t end = std::min(rest.find_first_of(" \t", begin), rest.size());
+        std::string_view token = rest.substr(begin, end - begin);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        return token;
+    };
+    auto parse_number = [](std::string_view token, std::size_t &value) -> bool {
+        auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+        return !token.empty() && error == std::errc() && end == token.data() + token.size();
+    };
+    auto parse_category = [&](std::string_view token, std::size_t &category_ID) -> bool {
+        std::size_t index = 0;
+        if (!token.starts_with('+')) return parse_number(token, category_ID);
+        if (!parse_number(token.substr(1), index) || index == 0 || index > added.size()) return false;
+        category_ID = added[index - 1];
+        return true;
+    };
+
+    std::string line;
+    for (std::size_t number = 1; std::getline(script, line); ++number) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::string_view rest = line;
+        std::string_view command = next_token(rest);
+        if (command.empty() || command.starts_with('#')) continue;
+
+        std::size_t category_ID = 0, password_ID = 0;
+        bool parsed = true;
+        if (command == "category") {
+            added.push_back(batch.add_category(rest));
+        } else if (command == "remove-category") {
+            parsed = parse_category(next_token(rest), category_ID) && rest.empty();
+            if (parsed) batch.remove_category(category_ID);
+        } else if (command == "add") {
+            parsed = parse_category(next_token(rest), category_ID) && !rest.empty();
+            if (parsed) batch.add_password(category_ID, rest);
+        } else if (command == "edit") {
+            parsed = parse_category(next_token(rest), category_ID) && parse_number(next_token(rest), password_ID)
+                     && !rest.empty();
+            if (parsed) batch.edit_password(category_ID, password_ID, rest);
+        } else if (command == "remove") {
+            parsed = parse_category(next_token(rest), category_ID) && parse_number(next_token(rest), password_ID)
+                     && rest.empty();
+            if (parsed) batch.remove_password(category_ID, password_ID);
+        } else parsed = false;
+
+        if (!parsed) {
+            fmt::print("[-] Line {} of '{}' Cannot Be Parsed, Nothing Was Changed\n", number, script_filename);
+            return false;
+        }
+        lines.push_back(number);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<failure> failures = batch.validate(category, password);
+    std::chrono::duration<double, std::milli> validated = std::chrono::steady_clock::now() - start;
+
+    if (!failures.empty()) {
+        constexpr std::size_t listed = 100;
+        for (std::size_t i = 0; i < std::min(failures.size(), listed); ++i) {
+            fmt::print("[-] Line {}: {}\n", lines[failures[i].index], failures[i].reason);
+        }
+        if (failures.size() > listed) fmt::print("[-] And {} More\n", failures.size() - listed);
+        fmt::print("[-] {} of {} Changes Failed, Nothing Was Changed\n", failures.size(), batch.size());
+        return false;
+    }
+    if (check_only) {
+        fmt::print("[+] All {} Changes Are Valid, Checked in {:.2f} ms\n", batch.size(), validated.count());
+        return true;
+    }
+
+    /// This vault is never undone, so the history is not kept up to date
+    start = std::chrono::steady_clock::now();
+    batch.apply(category, password, false);
+    std::chrono::duration<double, std::milli> applied = std::chrono::steady_clock::now() - start;
+
+    if (!vault_file::save(category, password, vault_filename, key)) return false;
+    fmt::print("[+] Applied {} Changes to '{}', Checked in {:.2f} ms and Applied in {:.2f} ms\n",
+               batch.size(), vault_filename, validated.count(), applied.count());
+    return true;
+}
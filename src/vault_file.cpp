@@ -0,0 +1,1026 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <map>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <condition_variable>
+#include "../include/argon2.hpp"
+#include "../include/crc32c.hpp"
+#include "../include/cryptor.hpp"
+#include "../include/history.hpp"
+#include "../include/trace.hpp"
+#include "../include/metrics.hpp"
+#include "../include/memory_tracker.hpp"
+#include "../include/vault_file.hpp"
+#include "../include/vault_watcher.hpp"
+
+/**
+ * @brief Prompts the user for a file name and a secret key and saves the vault.
+ * @param category The categories object to save.
+ * @param password The passwords object to save.
+ */
+auto vault_file::initialize_save(const categories &category, const passwords &password) -> void {
+    fmt::print("Enter the File Name: ");
+    std::string filename;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, filename);
+
+    std::pmr::string key = read_key("Enter the secret key: ");
+    if (key.empty()) {
+        fmt::print("\n[-] The Secret Key Cannot Be Empty\n");
+        return;
+    }
+
+    if (save(category, password, filename, key)) {
+        vault_watcher::watch(filename, key, history::snapshot());
+        fmt::print("\n[+] Vault Saved to '{}'\n", filename);
+    }
+}
+
+/**
+ * @brief Prompts the user for a file name and a secret key and checks that the key decrypts the file.
+ *
+ * The file is decrypted into objects of its own, so the open vault and the keyring stay untouched.
+ */
+auto vault_file::initialize_check() -> void {
+    fmt::print("Enter the File Name: ");
+    std::string filename;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, filename);
+
+    std::pmr::string key = read_key("Enter the secret key: ");
+    if (key.empty()) {
+        fmt::print("\n[-] The Secret Key Cannot Be Empty\n");
+        return;
+    }
+
+    categories category;
+    passwords password;
+    std::pmr::map<std::size_t, std::pmr::string> loaded_keys;
+    if (!load(category, password, filename, key, loaded_keys)) return;
+
+    std::size_t password_count = password.get_passwords().size();
+    for (const auto &[category_ID, element] : category.categories_map) password_count += element.passwords.size();
+    fmt::print("\n[+] The Key Decrypts '{}': {} Data Keys Unwrapped, {} Passwords in {} Categories\n",
+               filename, loaded_keys.size(), password_count, category.categories_map.size());
+}
+
+/**
+ * @brief Prompts the user for a file name and a secret key and loads the vault.
+ * @param category The categories object to load into.
+ * @param password The passwords object to load into.
+ */
+auto vault_file::initialize_load(categories &category, passwords &password) -> void {
+    fmt::print("Enter the File Name: ");
+    std::string filename;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, filename);
+
+    std::pmr::string key = read_key("Enter the secret key: ");
+    if (key.empty()) {
+        fmt::print("\n[-] The Secret Key Cannot Be Empty\n");
+        return;
+    }
+
+    if (load(category, password, filename, key)) {
+        history::rebuild(category, password);
+        vault_watcher::watch(filename, key, history::snapshot());
+        fmt::print("\n[+] Vault Loaded from '{}'\n", filename);
+    }
+}
+
+/**
+ * @brief Reads a secret key from the standard input.
+ *
+ * The key is kept in the arena, like the master key derived from it, so it is
+ * zeroized wherever the caller drops it, and so are the buffers getline outgrows.
+ *
+ * @param prompt            The prompt message displayed to the user.
+ * @param allow_environment Use GUARDCIPHER_KEY instead of prompting when it is set,
+ *                          so that command line modes can be driven by scripts.
+ * @return The key, or an empty string if none was entered.
+ */
+auto vault_file::read_key(const std::string &prompt, bool allow_environment) -> std::pmr::string {
+    const char *environment_key = allow_environment ? std::getenv("GUARDCIPHER_KEY") : nullptr;
+    if (environment_key != nullptr) return std::pmr::string(environment_key);
+
+    fmt::print("{}", prompt);
+    std::pmr::string key;
+    std::getline(std::cin, key);
+    return key;
+}
+
+/**
+ * @brief Saves the vault to a binary file.
+ *
+ * The file starts with a magic tag and the Argon2id memory cost, passes,
+ * lanes and salt, followed by every category with its wrapped data key and
+ * encrypted passwords and then the password list the same way. Integers are
+ * stored as 64-bit little endian, strings are length prefixed. Every save
+ * draws a new salt, the costs come from argon2::configured(). The data keys
+ * come from the keyring, so they only change on rekey(). The file header,
+ * every block header and every record end with their CRC-32C, so verify()
+ * can find damaged records without the secret. The vault is written to a
+ * temporary file that replaces it in one rename, so a crash or a full disk
+ * never leaves a half-written vault, and readers see one version or the other.
+ *
+ * @param category The categories object to save.
+ * @param password The passwords object to save.
+ * @param filename The name of the file to write to.
+ * @param secret   The secret the master key is derived from.
+ * @return True if the vault was saved, false otherwise.
+ */
+auto vault_file::save(const categories &category, const passwords &password,
+                      const std::string &filename, std::string_view secret) -> bool {
+    metrics::timer timer(metrics::metric::vault_save);
+    TRACE_SPAN("vault_file::save");
+    argon2::parameters cost = argon2::configured();
+    std::string salt = argon2::generate_salt();
+    std::pmr::string key = argon2::derive(secret, salt, cost);
+
+    memory_tracker::scope scope(memory_tracker::transient::encrypt);
+    std::string buffer(_magic);
+    put_u64(buffer, cost.memory_kib);
+    put_u64(buffer, cost.passes);
+    put_u64(buffer, cost.lanes);
+    put_string(buffer, salt);
+    put_u64(buffer, category.categories_map.size());
+    put_checksum(buffer, 0);
+
+    for (const auto &[category_ID, element] : category.categories_map) {
+        TRACE_SPAN_ARG("vault_file::encrypt_category", category_ID);
+        std::pmr::string data_key = keyring::data_key(element.ID);
+        put_block(buffer, { element.ID, element._pass_id, element.name, keyring::wrap(element.ID, data_key, key), { } },
+                  element.passwords.size(), false);
+        for (const auto &[password_ID, value] : element.passwords) {
+            put_record(buffer, password_ID, cryptor::encrypt(value, data_key));
+        }
+    }
+
+    {
+        TRACE_SPAN("vault_file::encrypt_list");
+        std::pmr::string data_key = keyring::data_key(keyring::list_ID);
+        put_block(buffer, { keyring::list_ID, 0, { }, keyring::wrap(keyring::list_ID, data_key, key), { } },
+                  password.get_passwords().size(), true);
+        for (const auto &[password_ID, value] : password.get_passwords()) {
+            put_record(buffer, password_ID, cryptor::encrypt(value.name, data_key));
+        }
+    }
+
+    /// The old version stays whole until the new one is complete on disk
+    std::string temporary = filename + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        fmt::print("[-] Failed to Open the File '{}'\n", temporary);
+        return false;
+    }
+
+    {
+        TRACE_SPAN("vault_file::write");
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    file.close();
+    if (!file) {
+        std::error_code error;
+        std::filesystem::remove(temporary, error);
+        fmt::print("[-] Failed to Write the File '{}'\n", temporary);
+        return false;
+    }
+
+    TRACE_SPAN("vault_file::flush");
+    return replace(temporary, filename);
+}
+
+/**
+ * @brief Loads the vault from a binary file written by save().
+ *
+ * The categories, the password list and the keyring are only
+ * replaced once the whole file has been read successfully. A damaged
+ * record fails the load, verify() lists all of them. Vaults without
+ * checksums, per-category keys or a key derivation header are still read.
+ *
+ * @param category The categories object to load into.
+ * @param password The passwords object to load into.
+ * @param filename The name of the file to read from.
+ * @param secret   The secret the master key is derived from.
+ * @return True if the vault was loaded, false otherwise.
+ */
+auto vault_file::load(categories &category, passwords &password,
+                      const std::string &filename, std::string_view secret) -> bool {
+    std::pmr::map<std::size_t, std::pmr::string> loaded_keys;
+    if (!load(category, password, filename, secret, loaded_keys)) return false;
+
+    keyring::replace(std::move(loaded_keys));
+    return true;
+}
+
+/**
+ * @brief Loads the vault from a binary file without touching the keyring.
+ *
+ * For reading a vault while the keyring is in use, e.g. on another thread.
+ *
+ * @param loaded_keys Receives the data keys of the file.
+ * @return True if the vault was loaded, false otherwise.
+ */
+auto vault_file::load(categories &category, passwords &password, const std::string &filename,
+                      std::string_view secret, std::pmr::map<std::size_t, std::pmr::string> &loaded_keys) -> bool {
+    metrics::timer timer(metrics::metric::vault_load);
+    TRACE_SPAN("vault_file::load");
+    memory_tracker::scope scope(memory_tracker::transient::decrypt);
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    std::string content;
+    {
+        TRACE_SPAN("vault_file::read");
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::string_view cursor = content;
+
+    int file_version = version(cursor);
+    if (file_version == 0) {
+        fmt::print("[-] '{}' is Not a Vault File\n", filename);
+        return false;
+    }
+    cursor.remove_prefix(_magic.size());
+
+    auto corrupted = [&filename]() -> bool {
+        fmt::print("[-] Vault File '{}' is Corrupted\n", filename);
+        return false;
+    };
+
+    std::pmr::string key(secret);
+    if (file_version > 1) {
+        std::uint64_t memory_kib = 0, passes = 0, lanes = 0;
+        std::string salt;
+        if (!get_u64(cursor, memory_kib) || !get_u64(cursor, passes) || !get_u64(cursor, lanes)
+            || !get_string(cursor, salt)) return corrupted();
+
+        argon2::parameters cost { static_cast<std::uint32_t>(memory_kib), static_cast<std::uint32_t>(passes),
+                                  static_cast<std::uint32_t>(lanes) };
+        if (cost.memory_kib != memory_kib || cost.passes != passes || cost.lanes != lanes
+            || !argon2::valid(cost)) return corrupted();
+        key = argon2::derive(secret, salt, cost);
+    }
+
+    /// Older vaults have no checksums and encrypt every password with the master key
+    loaded_keys.clear();
+    bool checked = file_version >= 4;
+    auto read_wrapped_key = [&](keyring::wrapped &wrapped_key) -> bool {
+        return file_version < 3 || ((file_version < 5 || get_string(cursor, wrapped_key.nonce))
+                                    && get_string(cursor, wrapped_key.key) && get_string(cursor, wrapped_key.check));
+    };
+    auto unwrap = [&](std::size_t ID, const keyring::wrapped &wrapped_key) -> std::optional<std::pmr::string> {
+        if (file_version < 3) return key;
+
+        std::optional<std::pmr::string> data_key = file_version < 5 ? keyring::unwrap_legacy(wrapped_key, key)
+                                                                    : keyring::unwrap(ID, wrapped_key, key);
+        if (data_key) loaded_keys.insert_or_assign(ID, *data_key);
+        return data_key;
+    };
+    auto wrong_key = [&filename]() -> bool {
+        fmt::print("[-] Wrong Secret Key for '{}' or the File is Corrupted\n", filename);
+        return false;
+    };
+    auto damaged = [&filename](std::string_view what) -> bool {
+        fmt::print("[-] {} in '{}' is Damaged, Run --verify to List Every Damaged Record\n", what, filename);
+        return false;
+    };
+
+    std::map<std::size_t, categories::category> loaded_categories;
+    std::size_t max_category_ID = 0;
+    std::uint64_t category_count = 0;
+    if (!get_u64(cursor, category_count)) return corrupted();
+    if (checked && !check_checksum(cursor, content.data())) return damaged("The File Header");
+
+    for (std::uint64_t i = 0; i < category_count; ++i) {
+        TRACE_SPAN("vault_file::decrypt_category");
+        categories::category loaded;
+        keyring::wrapped wrapped_key;
+        std::uint64_t ID = 0, pass_id = 0, password_count = 0;
+        const char *block = cursor.data();
+        if (!get_u64(cursor, ID) || !get_u64(cursor, pass_id) || !get_string(cursor, loaded.name)
+            || !read_wrapped_key(wrapped_key) || !get_u64(cursor, password_count)) return corrupted();
+        if (checked && !check_checksum(cursor, block)) return damaged(fmt::format("The Header of Category {}", i + 1));
+
+        std::optional<std::pmr::string> data_key = unwrap(ID, wrapped_key);
+        if (!data_key) return wrong_key();
+
+        loaded.ID = ID;
+        loaded._pass_id = pass_id;
+        for (std::uint64_t j = 0; j < password_count; ++j) {
+            std::uint64_t password_ID = 0;
+            std::string value;
+            const char *record = cursor.data();
+            if (!get_u64(cursor, password_ID) || !get_string(cursor, value)) return corrupted();
+            if (checked && !check_checksum(cursor, record)) {
+                return damaged(fmt::format("Record {} of Category {}", password_ID, ID));
+            }
+            loaded.passwords.emplace_hint(loaded.passwords.end(),
+                                          password_ID, cryptor::decrypt(value, *data_key));
+        }
+
+        max_category_ID = std::max(max_category_ID, loaded.ID);
+        loaded_categories.emplace_hint(loaded_categories.end(), loaded.ID, std::move(loaded));
+    }
+
+    std::pmr::map<std::size_t, passwords::password> loaded_passwords;
+    std::size_t max_password_ID = 0;
+    std::uint64_t password_count = 0;
+    keyring::wrapped list_wrapped_key;
+    const char *list_block = cursor.data();
+    if (!read_wrapped_key(list_wrapped_key) || !get_u64(cursor, password_count)) return corrupted();
+    if (checked && !check_checksum(cursor, list_block)) return damaged("The Header of the Password List");
+
+    std::optional<std::pmr::string> list_key = unwrap(keyring::list_ID, list_wrapped_key);
+    if (!list_key) return wrong_key();
+
+    TRACE_SPAN("vault_file::decrypt_list");
+    for (std::uint64_t i = 0; i < password_count; ++i) {
+        std::uint64_t password_ID = 0;
+        std::string value;
+        const char *record = cursor.data();
+        if (!get_u64(cursor, password_ID) || !get_string(cursor, value)) return corrupted();
+        if (checked && !check_checksum(cursor, record)) {
+            return damaged(fmt::format("Record {} of the Password List", password_ID));
+        }
+        loaded_passwords.emplace_hint(loaded_passwords.end(), password_ID,
+                                      passwords::password { password_ID, cryptor::decrypt(value, *list_key) });
+        max_password_ID = std::max(max_password_ID, static_cast<std::size_t>(password_ID));
+    }
+
+    if (!cursor.empty()) return corrupted();
+
+    category.categories_map = std::move(loaded_categories);
+    category._current_ID = max_category_ID + 1;
+    password._pass_without_categories = std::move(loaded_passwords);
+    password._current_ID = max_password_ID + 1;
+    return true;
+}
+
+/**
+ * @brief Changes the secret of a vault file, optionally with fresh data keys.
+ *
+ * Categories are streamed through a pool of workers. Each worker unwraps
+ * the data key of a category with the old master key and wraps it with
+ * the new one. With data set it also re-encrypts the passwords under a new
+ * data key. The reader stops while too many categories are in flight, so
+ * memory stays bounded for any vault size. The result goes to a temporary
+ * file that replaces the vault in one rename. Until then the old file
+ * stays complete and readable. Older vaults have no data keys, so they are
+ * always re-encrypted.
+ *
+ * @param filename   The vault file.
+ * @param secret     The current secret.
+ * @param new_secret The secret to protect the vault with.
+ * @param data       Whether to replace the data keys as well.
+ * @return True if the vault was re-keyed, false otherwise.
+ */
+auto vault_file::rekey(const std::string &filename, std::string_view secret,
+                       std::string_view new_secret, bool data) -> bool {
+    metrics::timer timer(metrics::metric::vault_rekey);
+    TRACE_SPAN("vault_file::rekey");
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream input(filename, std::ios::binary);
+    if (!input) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+    std::error_code error;
+    std::uint64_t limit = std::filesystem::file_size(filename, error);
+
+    auto corrupted = [&filename]() -> bool {
+        fmt::print("[-] Vault File '{}' is Corrupted\n", filename);
+        return false;
+    };
+
+    std::string magic(_magic.size(), '\0');
+    input.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    int file_version = input ? version(magic) : 0;
+    if (file_version == 0) {
+        fmt::print("[-] '{}' is Not a Vault File\n", filename);
+        return false;
+    }
+
+    std::pmr::string old_master(secret);
+    std::string old_header(magic);
+    if (file_version > 1) {
+        std::uint64_t memory_kib = 0, passes = 0, lanes = 0;
+        std::string salt;
+        if (!read_u64(input, memory_kib) || !read_u64(input, passes) || !read_u64(input, lanes)
+            || !read_string(input, limit, salt)) return corrupted();
+        put_u64(old_header, memory_kib);
+        put_u64(old_header, passes);
+        put_u64(old_header, lanes);
+        put_string(old_header, salt);
+
+        argon2::parameters cost { static_cast<std::uint32_t>(memory_kib), static_cast<std::uint32_t>(passes),
+                                  static_cast<std::uint32_t>(lanes) };
+        if (cost.memory_kib != memory_kib || cost.passes != passes || cost.lanes != lanes
+            || !argon2::valid(cost)) return corrupted();
+        old_master = argon2::derive(secret, salt, cost);
+    }
+    data = data || file_version < 3;
+
+    argon2::parameters cost = argon2::configured();
+    std::string salt = argon2::generate_salt();
+    std::pmr::string new_master = argon2::derive(new_secret, salt, cost);
+
+    std::uint64_t category_count = 0;
+    if (!read_u64(input, category_count)) return corrupted();
+    if (file_version >= 4) {
+        std::uint32_t checksum = 0;
+        put_u64(old_header, category_count);
+        if (!read_u32(input, checksum) || checksum != crc32c::compute(old_header)) return corrupted();
+    }
+
+    std::string temporary = filename + ".rekey";
+    std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        fmt::print("[-] Failed to Open the File '{}'\n", temporary);
+        return false;
+    }
+
+    std::string header(_magic);
+    put_u64(header, cost.memory_kib);
+    put_u64(header, cost.passes);
+    put_u64(header, cost.lanes);
+    put_string(header, salt);
+    put_u64(header, category_count);
+    put_checksum(header, 0);
+    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    /// The password list follows the categories as one more unit
+    std::uint64_t unit_count = category_count + 1;
+    std::size_t worker_count = std::max(1U, std::thread::hardware_concurrency());
+    std::size_t max_in_flight = worker_count * _units_per_worker;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<std::uint64_t, sealed_unit>> queued;
+    std::map<std::uint64_t, std::string> finished;
+    std::size_t in_flight = 0;
+    std::uint64_t read_count = 0, written_count = 0, password_count = 0;
+    bool failed = false, wrong_key = false;
+
+    auto process = [&](sealed_unit &unit) -> bool {
+        std::optional<std::pmr::string> old_key = file_version < 3 ? std::optional(old_master)
+                                                  : file_version < 5 ? keyring::unwrap_legacy(unit.key, old_master)
+                                                                     : keyring::unwrap(unit.ID, unit.key, old_master);
+        if (!old_key) return false;
+
+        std::pmr::string new_key = data ? keyring::generate() : *old_key;
+        if (data) {
+            memory_tracker::scope scope(memory_tracker::transient::decrypt);
+            for (auto &[password_ID, value] : unit.entries) {
+                value.assign(cryptor::encrypt(cryptor::decrypt(value, *old_key), new_key));
+            }
+        }
+        unit.key = keyring::wrap(unit.ID, new_key, new_master);
+        return true;
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back([&]() {
+                std::unique_lock lock(mutex);
+                while (true) {
+                    changed.wait(lock, [&]() { return failed || !queued.empty() || read_count == unit_count; });
+                    if (failed || queued.empty()) return;
+
+                    auto [sequence, unit] = std::move(queued.front());
+                    queued.pop_front();
+                    lock.unlock();
+
+                    TRACE_SPAN_ARG("vault_file::rekey_category", unit.ID);
+                    std::string bytes;
+                    bool processed = process(unit);
+                    if (processed) put_unit(bytes, unit, sequence == category_count);
+
+                    lock.lock();
+                    if (!processed) failed = wrong_key = true;
+                    else finished.emplace(sequence, std::move(bytes));
+                    changed.notify_all();
+                }
+            });
+        }
+
+        /// Units are written in file order, so a finished unit waits for the ones before it
+        std::jthread writer([&]() {
+            std::unique_lock lock(mutex);
+            while (written_count < unit_count) {
+                changed.wait(lock, [&]() { return failed || finished.contains(written_count); });
+                if (failed) return;
+
+                std::string bytes = std::move(finished.extract(written_count).mapped());
+                lock.unlock();
+                output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+                lock.lock();
+
+                ++written_count;
+                --in_flight;
+                changed.notify_all();
+            }
+        });
+
+        for (std::uint64_t sequence = 0; sequence < unit_count; ++sequence) {
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&]() { return failed || in_flight < max_in_flight; });
+                if (failed) break;
+            }
+
+            sealed_unit unit;
+            bool complete = read_unit(input, limit, file_version, sequence == category_count, unit);
+            password_count += unit.entries.size();
+
+            std::scoped_lock lock(mutex);
+            if (!complete) failed = true;
+            else {
+                queued.emplace_back(sequence, std::move(unit));
+                ++in_flight;
+            }
+            read_count = failed ? unit_count : sequence + 1;
+            changed.notify_all();
+        }
+    }
+
+    bool trailing = input.peek() != std::ifstream::traits_type::eof();
+    output.close();
+    if (failed || trailing || !output) {
+        std::filesystem::remove(temporary, error);
+        if (wrong_key) fmt::print("[-] Wrong Secret Key for '{}' or the File is Corrupted\n", filename);
+        else if (!output) fmt::print("[-] Failed to Write the File '{}'\n", temporary);
+        else corrupted();
+        return false;
+    }
+
+    if (!replace(temporary, filename)) return false;
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (data) {
+        fmt::print("[+] Re-Encrypted {} Passwords in {} Categories on {} Threads in {:.2f} ms\n",
+                   password_count, category_count, worker_count, elapsed.count());
+    } else {
+        fmt::print("[+] Rewrapped {} Data Keys in {:.2f} ms\n", unit_count, elapsed.count());
+    }
+    return true;
+}
+
+/**
+ * @brief Checks every checksum of a vault file and lists the damaged parts.
+ *
+ * The checksums cover the encrypted bytes, so no secret is needed. A first
+ * pass follows the length prefixes and splits the records into runs. The
+ * runs are then checked on all cores straight from the mapped file. If a
+ * damaged length throws the first pass off, the records after it cannot be
+ * located, which is reported as well.
+ *
+ * @param filename The vault file.
+ * @return True if nothing is damaged.
+ */
+auto vault_file::verify(const std::string &filename) -> bool {
+    TRACE_SPAN("vault_file::verify");
+    int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status { };
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        if (descriptor >= 0) close(descriptor);
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    std::size_t size = static_cast<std::size_t>(status.st_size);
+    void *mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED | MAP_POPULATE, descriptor, 0) : MAP_FAILED;
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        fmt::print("[-] '{}' is Not a Vault File\n", filename);
+        return false;
+    }
+    madvise(mapping, size, MADV_WILLNEED);
+
+    bool intact = [&]() -> bool {
+        std::string_view content(static_cast<const char*>(mapping), size);
+        int file_version = version(content);
+        if (file_version == 0) {
+            fmt::print("[-] '{}' is Not a Vault File\n", filename);
+            return false;
+        }
+        if (file_version < 4) {
+            fmt::print("[-] '{}' Predates Record Checksums, Save It or Run --rekey to Add Them\n", filename);
+            return false;
+        }
+
+        struct finding {
+            std::size_t offset;
+            std::string description;
+        };
+        struct block {
+            std::uint64_t ID;
+            bool list;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        std::string_view cursor = content.substr(_magic.size());
+        auto offset = [&content](const char *position) -> std::size_t {
+            return static_cast<std::size_t>(position - content.data());
+        };
+
+        std::vector<finding> findings;
+        std::vector<block> blocks;
+        std::vector<record_run> runs;
+        std::uint64_t record_count = 0;
+
+        /// Reads a block header and skips its records, false if the layout does not add up
+        auto walk_block = [&](bool list) -> bool {
+            const char *begin = cursor.data();
+            std::uint64_t ID = keyring::list_ID, pass_id = 0, count = 0;
+            std::string name, nonce, wrapped_key, check;
+            if (!list && (!get_u64(cursor, ID) || !get_u64(cursor, pass_id) || !get_string(cursor, name))) return false;
+            if ((file_version >= 5 && !get_string(cursor, nonce)) || !get_string(cursor, wrapped_key)
+                || !get_string(cursor, check) || !get_u64(cursor, count) || cursor.size() < 4) return false;
+            if (!check_checksum(cursor, begin)) {
+                findings.push_back({ offset(begin), list ? std::string("Header of the Password List")
+                                                         : fmt::format("Header of Category {}", ID) });
+            }
+            if (count > cursor.size() / 16) return false;
+
+            blocks.push_back({ ID, list });
+            std::size_t run_begin = offset(cursor.data()), in_run = 0;
+            for (std::uint64_t i = 0; i < count; ++i) {
+                std::uint64_t password_ID = 0, length = 0;
+                if (!get_u64(cursor, password_ID) || !get_u64(cursor, length)
+                    || length > cursor.size() || cursor.size() - length < 4) return false;
+                cursor.remove_prefix(length + 4);
+
+                if (++in_run == _records_per_run || i + 1 == count) {
+                    runs.push_back({ blocks.size() - 1, run_begin, offset(cursor.data()) });
+                    run_begin = offset(cursor.data());
+                    in_run = 0;
+                }
+            }
+            record_count += count;
+            return true;
+        };
+
+        bool located = true;
+        std::uint64_t memory_kib = 0, passes = 0, lanes = 0, category_count = 0;
+        std::string salt;
+        if (!get_u64(cursor, memory_kib) || !get_u64(cursor, passes) || !get_u64(cursor, lanes)
+            || !get_string(cursor, salt) || !get_u64(cursor, category_count) || cursor.size() < 4) located = false;
+        else if (!check_checksum(cursor, content.data())) findings.push_back({ 0, "File Header" });
+
+        for (std::uint64_t i = 0; located && i < category_count; ++i) located = walk_block(false);
+        if (located) located = walk_block(true);
+        std::size_t lost_at = offset(cursor.data());
+        if (located && !cursor.empty()) findings.push_back({ lost_at, "Unexpected Bytes After the Password List" });
+
+        std::size_t thread_count = std::clamp<std::size_t>(runs.size(), 1, std::max(1U, std::thread::hardware_concurrency()));
+        std::vector<std::vector<finding>> run_findings(runs.size());
+        std::atomic<std::size_t> next_run = 0;
+        auto work = [&]() {
+            for (std::size_t index = next_run++; index < runs.size(); index = next_run++) {
+                const record_run &run = runs[index];
+                std::string_view records = content.substr(run.begin, run.end - run.begin);
+                while (!records.empty()) {
+                    const char *record = records.data();
+                    std::uint64_t password_ID = 0, length = 0;
+                    get_u64(records, password_ID);
+                    get_u64(records, length);
+                    records.remove_prefix(length);
+                    if (check_checksum(records, record)) continue;
+
+                    const block &owner = blocks[run.block];
+                    run_findings[index].push_back({ offset(record), owner.list
+                            ? fmt::format("Record {} of the Password List", password_ID)
+                            : fmt::format("Record {} of Category {}", password_ID, owner.ID) });
+                }
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t i = 1; i < thread_count; ++i) workers.emplace_back(work);
+            work();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto &found : run_findings) std::move(found.begin(), found.end(), std::back_inserter(findings));
+        std::sort(findings.begin(), findings.end(),
+                  [](const finding &left, const finding &right) { return left.offset < right.offset; });
+
+        constexpr std::size_t max_listed = 100;
+        for (std::size_t i = 0; i < std::min(findings.size(), max_listed); ++i) {
+            fmt::print("[-] {} at Offset {} is Damaged\n", findings[i].description, findings[i].offset);
+        }
+        if (findings.size() > max_listed) fmt::print("[-] ... and {} More\n", findings.size() - max_listed);
+        if (!located) {
+            fmt::print("[-] The Layout is Damaged at Offset {}, the Records After It Could Not Be Located\n", lost_at);
+        }
+
+        double mebibytes = static_cast<double>(size) / (1024 * 1024);
+        fmt::print("[+] Checked {} Records in {} Blocks, {:.1f} MiB in {:.2f} ms ({:.2f} GiB/s) on {} Threads, {} CRC-32C\n",
+                   record_count, blocks.size(), mebibytes, elapsed.count(),
+                   mebibytes / 1024 / std::max(elapsed.count() / 1000, 1e-9), thread_count,
+                   crc32c::hardware() ? "SSE4.2" : "Table");
+
+        if (findings.empty() && located) {
+            fmt::print("[+] No Damage Found in '{}'\n", filename);
+            return true;
+        }
+        fmt::print("[-] '{}' is Damaged\n", filename);
+        return false;
+    }();
+
+    munmap(mapping, size);
+    return intact;
+}
+
+/**
+ * @brief Returns the format version of a vault file from its first bytes, 0 if it is not one.
+ */
+auto vault_file::version(std::string_view header) -> int {
+    if (header.starts_with(_magic)) return _version;
+    if (header.starts_with(_legacy_wrap_magic)) return 4;
+    if (header.starts_with(_unchecked_magic)) return 3;
+    if (header.starts_with(_shared_key_magic)) return 2;
+    if (header.starts_with(_legacy_magic)) return 1;
+    return 0;
+}
+
+/**
+ * @brief Moves a completely written temporary file over the vault.
+ *
+ * The temporary file is forced to disk before the rename and the directory
+ * after it, so after a crash the vault is either the old or the new version.
+ * The vault keeps its permissions. On failure the temporary file is removed.
+ *
+ * @param temporary The new version, next to the vault.
+ * @param filename  The vault file.
+ * @return True if the vault was replaced.
+ */
+auto vault_file::replace(const std::string &temporary, const std::string &filename) -> bool {
+    std::error_code error;
+    std::filesystem::file_status existing = std::filesystem::status(filename, error);
+    if (std::filesystem::exists(existing)) std::filesystem::permissions(temporary, existing.permissions(), error);
+
+    if (!sync(temporary)) {
+        fmt::print("[-] Failed to Write the File '{}': {}\n", temporary, std::strerror(errno));
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        fmt::print("[-] Failed to Replace '{}': {}\n", filename, error.message());
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    sync(directory.empty() ? "." : directory.string());
+    return true;
+}
+
+/**
+ * @brief Forces a file or directory to disk.
+ */
+auto vault_file::sync(const std::string &path) -> bool {
+    int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) return false;
+
+    bool synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+}
+
+/**
+ * @brief Appends a category, or the password list, in the layout of save().
+ */
+auto vault_file::put_unit(std::string &buffer, const sealed_unit &unit, bool list) -> void {
+    put_block(buffer, unit, unit.entries.size(), list);
+    for (const auto &[password_ID, value] : unit.entries) put_record(buffer, password_ID, value);
+}
+
+/**
+ * @brief Appends the header of a category, or of the password list, with its checksum.
+ *
+ * @param buffer The buffer to append to.
+ * @param unit   The category, its entries are not written.
+ * @param count  The number of records that follow the header.
+ * @param list   Whether the unit is the password list, which has no ID and name.
+ * @param file_version The layout to write, older ones only to recompute their checksums.
+ */
+auto vault_file::put_block(std::string &buffer, const sealed_unit &unit, std::uint64_t count, bool list,
+                           int file_version) -> void {
+    std::size_t begin = buffer.size();
+    if (!list) {
+        put_u64(buffer, unit.ID);
+        put_u64(buffer, unit.pass_id);
+        put_string(buffer, unit.name);
+    }
+    if (file_version >= 5) put_string(buffer, unit.key.nonce);
+    put_string(buffer, unit.key.key);
+    put_string(buffer, unit.key.check);
+    put_u64(buffer, count);
+    put_checksum(buffer, begin);
+}
+
+/**
+ * @brief Appends an encrypted password with its checksum.
+ */
+auto vault_file::put_record(std::string &buffer, std::uint64_t ID, std::string_view value) -> void {
+    std::size_t begin = buffer.size();
+    put_u64(buffer, ID);
+    put_string(buffer, value);
+    put_checksum(buffer, begin);
+}
+
+/**
+ * @brief Appends the CRC-32C of the buffer from begin on.
+ */
+auto vault_file::put_checksum(std::string &buffer, std::size_t begin) -> void {
+    put_u32(buffer, crc32c::compute(std::string_view(buffer).substr(begin)));
+}
+
+/**
+ * @brief Reads a checksum and compares it with the bytes from begin up to the cursor.
+ * @return False if the cursor holds no checksum or it does not match.
+ */
+auto vault_file::check_checksum(std::string_view &cursor, const char *begin) -> bool {
+    std::uint32_t computed = crc32c::compute(begin, static_cast<std::size_t>(cursor.data() - begin));
+    std::uint32_t stored = 0;
+    return get_u32(cursor, stored) && stored == computed;
+}
+
+/**
+ * @brief Reads a category, or the password list, of a vault file of any version.
+ *
+ * @param input        The vault file, positioned at the unit.
+ * @param limit        The file size, no string can be longer.
+ * @param file_version The version returned by version().
+ * @param list         Whether the unit is the password list.
+ * @param unit         Receives the unit.
+ * @return False if the file ends early or a checksum does not match.
+ */
+auto vault_file::read_unit(std::istream &input, std::uint64_t limit, int file_version,
+                           bool list, sealed_unit &unit) -> bool {
+    if (!list && (!read_u64(input, unit.ID) || !read_u64(input, unit.pass_id)
+                  || !read_string(input, limit, unit.name))) return false;
+    if (file_version >= 5 && !read_string(input, limit, unit.key.nonce)) return false;
+    if (file_version >= 3 && (!read_string(input, limit, unit.key.key)
+                              || !read_string(input, limit, unit.key.check))) return false;
+    if (list) unit.ID = keyring::list_ID;
+
+    std::uint64_t count = 0;
+    /// A stored record takes at least 16 bytes
+    if (!read_u64(input, count) || count > limit / 16) return false;
+
+    /// The stream is not kept, so the checksums are compared against the fields written back
+    bool checked = file_version >= 4;
+    std::string written;
+    auto verified = [&]() -> bool {
+        std::string_view checksum = std::string_view(written).substr(written.size() - 4);
+        std::uint32_t computed = 0, stored = 0;
+        return read_u32(input, stored) && get_u32(checksum, computed) && stored == computed;
+    };
+
+    if (checked) {
+        put_block(written, unit, count, list, file_version);
+        if (!verified()) return false;
+    }
+
+    unit.entries.resize(count);
+    for (auto &[password_ID, value] : unit.entries) {
+        if (!read_u64(input, password_ID) || !read_string(input, limit, value)) return false;
+        if (checked) {
+            written.clear();
+            put_record(written, password_ID, value);
+            if (!verified()) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Appends a 32-bit little endian integer to the buffer.
+ */
+auto vault_file::put_u32(std::string &buffer, std::uint32_t value) -> void {
+    for (int i = 0; i < 4; ++i) {
+        buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Appends a 64-bit little endian integer to the buffer.
+ */
+auto vault_file::put_u64(std::string &buffer, std::uint64_t value) -> void {
+    for (int i = 0; i < 8; ++i) {
+        buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Appends a length prefixed string to the buffer.
+ */
+auto vault_file::put_string(std::string &buffer, std::string_view value) -> void {
+    put_u64(buffer, value.size());
+    buffer.append(value);
+}
+
+/**
+ * @brief Reads a 32-bit little endian integer and advances the cursor.
+ * @return False if the cursor holds less than 4 bytes.
+ */
+auto vault_file::get_u32(std::string_view &cursor, std::uint32_t &value) -> bool {
+    if (cursor.size() < 4) return false;
+
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(cursor[i])) << (i * 8);
+    }
+    cursor.remove_prefix(4);
+    return true;
+}
+
+/**
+ * @brief Reads a 64-bit little endian integer and advances the cursor.
+ * @return False if the cursor holds less than 8 bytes.
+ */
+auto vault_file::get_u64(std::string_view &cursor, std::uint64_t &value) -> bool {
+    if (cursor.size() < 8) return false;
+
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(cursor[i])) << (i * 8);
+    }
+    cursor.remove_prefix(8);
+    return true;
+}
+
+/**
+ * @brief Reads a length prefixed string and advances the cursor.
+ * @return False if the cursor holds less bytes than the string needs.
+ */
+auto vault_file::get_string(std::string_view &cursor, std::string &value) -> bool {
+    std::uint64_t length = 0;
+    if (!get_u64(cursor, length) || cursor.size() < length) return false;
+
+    value.assign(cursor.substr(0, length));
+    cursor.remove_prefix(length);
+    return true;
+}
+
+/**
+ * @brief Reads a 32-bit little endian integer from a stream.
+ * @return False if the stream holds less than 4 bytes.
+ */
+auto vault_file::read_u32(std::istream &input, std::uint32_t &value) -> bool {
+    std::array<char, 4> bytes { };
+    if (!input.read(bytes.data(), bytes.size())) return false;
+
+    std::string_view cursor(bytes.data(), bytes.size());
+    return get_u32(cursor, value);
+}
+
+/**
+ * @brief Reads a 64-bit little endian integer from a stream.
+ * @return False if the stream holds less than 8 bytes.
+ */
+auto vault_file::read_u64(std::istream &input, std::uint64_t &value) -> bool {
+    std::array<char, 8> bytes { };
+    if (!input.read(bytes.data(), bytes.size())) return false;
+
+    std::string_view cursor(bytes.data(), bytes.size());
+    return get_u64(cursor, value);
+}
+
+/**
+ * @brief Reads a length prefixed string from a stream.
+ * @return False if the stream ends early or the length exceeds the limit.
+ */
+auto vault_file::read_string(std::istream &input, std::uint64_t limit, std::string &value) -> bool {
+    std::uint64_t length = 0;
+    if (!read_u64(input, length) || length > limit) return false;
+
+    value.resize(length);
+    return static_cast<bool>(input.read(value.data(), static_cast<std::streamsize>(length)));
+}
@@ -0,0 +1,374 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <array>
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "../include/secure_arena.hpp"
+#include "../include/vault_server.hpp"
+
+/**
+ * @brief Serves the vault over a Unix domain socket until SIGINT or SIGTERM.
+ *
+ * A single epoll loop accepts clients and handles their requests. Requests
+ * of one client are answered in order and may be pipelined, so a client can
+ * send many lookups before reading any response. Unless the vault is sealed,
+ * it is served from a concurrent_vault, so lookups and searches read one
+ * consistent snapshot each.
+ *
+ * @param category    The categories object to serve, holds the added passwords once the daemon stopped.
+ * @param password    The passwords object to serve, holds the added passwords once the daemon stopped.
+ * @param socket_path The file system path of the socket.
+ * @param sealed      Serve this vault instead, kept encrypted in memory.
+ * @return True if the daemon stopped cleanly, false if it failed to start.
+ */
+auto vault_server::run(categories &category, passwords &password,
+                       const std::string &socket_path, sealed_vault *sealed) -> bool {
+    sockaddr_un address { };
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        fmt::print("[-] Socket Path '{}' is Too Long\n", socket_path);
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        fmt::print("[-] Failed to Create the Socket: {}\n", std::strerror(errno));
+        return false;
+    }
+
+    /// Remove a stale socket left behind by a previous run, but nothing else
+    struct stat existing { };
+    if (lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            fmt::print("[-] '{}' Exists and is Not a Socket, Refusing to Replace It\n", socket_path);
+            close(listener);
+            return false;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    /// Only the owner may talk to the daemon, the vault is served in plaintext,
+    /// so the socket is created with that mode instead of being opened up in between
+    mode_t previous_mask = umask(077);
+    bool bound = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previous_mask);
+    if (!bound || listen(listener, SOMAXCONN) < 0) {
+        fmt::print("[-] Failed to Listen on '{}': {}\n", socket_path, std::strerror(errno));
+        close(listener);
+        return false;
+    }
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event { };
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+    struct sigaction action { };
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    /// The plaintext vault is served from a copy, written back when the daemon stops
+    std::optional<concurrent_vault> shared;
+    if (sealed == nullptr) {
+        vault_state initial;
+        initial.assign(category, password);
+        shared.emplace(initial);
+    }
+    _sealed = sealed;
+    _shared = shared ? &*shared : nullptr;
+    fmt::print("[+] Serving the {}Vault on '{}'\n", sealed != nullptr ? "Sealed " : "", socket_path);
+
+    std::unordered_map<int, connection> clients;
+    std::vector<epoll_event> events(256);
+
+    while (_stop == 0) {
+        int ready = epoll_wait(epoll, events.data(), static_cast<int>(events.size()),
+                               _sealed != nullptr ? _sweep_interval_ms : -1);
+        if (_sealed != nullptr) _sealed->sweep();
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            fmt::print("[-] epoll_wait Failed: {}\n", std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == listener) {
+                /// Accept every pending client
+                int client;
+                while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    epoll_event client_event { };
+                    client_event.events = EPOLLIN | EPOLLRDHUP;
+                    client_event.data.fd = client;
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, client, &client_event);
+                    clients.emplace(client, connection { });
+                }
+                continue;
+            }
+
+            auto client_it = clients.find(fd);
+            if (client_it == clients.end()) continue;
+            connection &client = client_it->second;
+
+            /// A client that closed its end still gets the answers to its last requests
+            bool open = !(events[i].events & EPOLLERR);
+            if (open && (events[i].events & (EPOLLIN | EPOLLRDHUP))) {
+                open = read_ready(fd, client);
+            }
+            bool writable = !(events[i].events & EPOLLERR)
+                            && (client.output.empty() || write_ready(fd, client));
+
+            /// Requests left waiting while the output was full are answered once it drained
+            if (open && writable) open = answer(client);
+
+            if (!open || !writable) {
+                epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                clients.erase(client_it);
+                continue;
+            }
+
+            /// Only wait for writability while there is output left to flush,
+            /// and stop reading from a client that does not read its responses
+            bool reading = client.pending < _output_limit;
+            epoll_event client_event { };
+            client_event.events = (reading ? EPOLLIN | EPOLLRDHUP : 0U) | (client.output.empty() ? 0U : EPOLLOUT);
+            client_event.data.fd = fd;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &client_event);
+        }
+    }
+
+    for (const auto &[fd, client] : clients) close(fd);
+    close(epoll);
+    close(listener);
+    unlink(socket_path.c_str());
+
+    fmt::print("\n[+] Daemon Stopped\n");
+    if (_sealed != nullptr) _sealed->print_statistics();
+    if (_shared != nullptr) _shared->snapshot()->restore(category, password);
+    _sealed = nullptr;
+    _shared = nullptr;
+    return true;
+}
+
+/**
+ * @brief Reads everything available from a client and answers every complete frame.
+ *
+ * Reading stops early once the responses waiting for the client pass the output limit.
+ *
+ * @return False if the client disconnected or sent a malformed frame.
+ */
+auto vault_server::read_ready(int fd, connection &client) -> bool {
+    while (client.pending < _output_limit) {
+        /// Receive straight into the buffer, so no plaintext is left in a temporary one
+        std::size_t used = client.input.size();
+        client.input.resize(used + _read_size);
+        ssize_t received = recv(fd, client.input.data() + used, _read_size, 0);
+        client.input.resize(used + static_cast<std::size_t>(std::max<ssize_t>(received, 0)));
+
+        if (received > 0) {
+            if (!answer(client)) return false;
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (received < 0 && errno == EINTR) continue;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Flushes as many pending responses to a client as the socket accepts.
+ *
+ * Every response is zeroized and freed as soon as it was sent completely.
+ *
+ * @return False if the client disconnected.
+ */
+auto vault_server::write_ready(int fd, connection &client) -> bool {
+    while (!client.output.empty()) {
+        std::array<iovec, _write_batch> parts { };
+        std::size_t count = std::min(client.output.size(), parts.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t skipped = i == 0 ? client.sent : 0;
+            parts[i].iov_base = client.output[i].data() + skipped;
+            parts[i].iov_len = client.output[i].size() - skipped;
+        }
+
+        msghdr message { };
+        message.msg_iov = parts.data();
+        message.msg_iovlen = count;
+        ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+
+        auto left = static_cast<std::size_t>(sent);
+        client.pending -= left;
+        while (left > 0) {
+            std::pmr::string &front = client.output.front();
+            std::size_t rest = front.size() - client.sent;
+            if (left < rest) {
+                client.sent += left;
+                break;
+            }
+            left -= rest;
+            /// Short responses are stored inside the string object, which the arena would not clear yet
+            secure_arena::zeroize(front.data(), front.size());
+            client.output.pop_front();
+            client.sent = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Answers the complete frames a client sent, as long as its output is below the limit.
+ * @return False if the client announced a frame larger than the protocol allows.
+ */
+auto vault_server::answer(connection &client) -> bool {
+    std::string_view pending = client.input;
+    while (client.pending < _output_limit) {
+        std::optional<std::size_t> length = protocol::frame_length(pending);
+        if (!length) break;
+
+        /// Built in place, a short response moved out of a local would leave a copy on the stack
+        std::pmr::string &response = client.output.emplace_back();
+        handle_frame(pending.substr(protocol::header_size, *length), response);
+        client.pending += response.size();
+        pending.remove_prefix(protocol::header_size + *length);
+    }
+    consume_input(client, client.input.size() - pending.size());
+
+    /// Refuse frames larger than the protocol allows instead of buffering them forever
+    std::optional<std::size_t> announced = protocol::announced_length(client.input);
+    return !announced || *announced <= protocol::max_frame_size;
+}
+
+/**
+ * @brief Drops answered requests from the front of the input and zeroizes the space they leave behind.
+ */
+auto vault_server::consume_input(connection &client, std::size_t count) -> void {
+    if (count == 0) return;
+
+    std::size_t size = client.input.size();
+    client.input.erase(0, count);
+    /// The rest was moved to the front, the old tail still holds copies
+    secure_arena::zeroize(client.input.data() + client.input.size(), size - client.input.size());
+}
+
+/**
+ * @brief Dispatches a request frame to its handler.
+ * @param body   The frame body, starting with the opcode.
+ * @param output The buffer the response frame is appended to.
+ */
+auto vault_server::handle_frame(std::string_view body, std::pmr::string &output) -> void {
+    if (body.empty()) {
+        protocol::end_frame(output, protocol::begin_frame(
+                output, static_cast<std::uint8_t>(protocol::status::invalid)));
+        return;
+    }
+
+    auto op = static_cast<protocol::opcode>(body.front());
+    body.remove_prefix(1);
+
+    switch (op) {
+        case protocol::opcode::get: handle_get(body, output); break;
+        case protocol::opcode::search: handle_search(body, output); break;
+        case protocol::opcode::add: handle_add(body, output); break;
+        default:
+            protocol::end_frame(output, protocol::begin_frame(
+                    output, static_cast<std::uint8_t>(protocol::status::invalid)));
+    }
+}
+
+/**
+ * @brief Answers a lookup of a single password by category ID and password ID.
+ */
+auto vault_server::handle_get(std::string_view body, std::pmr::string &output) -> void {
+    std::optional<std::uint64_t> category_ID = protocol::get_u64(body);
+    std::optional<std::uint64_t> password_ID = protocol::get_u64(body);
+
+    std::optional<std::pmr::string> found;
+    if (category_ID && password_ID && _sealed != nullptr) found = _sealed->get(*category_ID, *password_ID);
+    else if (category_ID && password_ID) found = _shared->get(*category_ID, *password_ID);
+
+    auto result = found ? protocol::status::ok : protocol::status::not_found;
+    std::size_t frame = protocol::begin_frame(output, static_cast<std::uint8_t>(result));
+    if (found) output.append(*found);
+    protocol::end_frame(output, frame);
+}
+
+/**
+ * @brief Answers a substring search over the password list and every category.
+ */
+auto vault_server::handle_search(std::string_view body, std::pmr::string &output) -> void {
+    std::size_t frame = protocol::begin_frame(output, static_cast<std::uint8_t>(protocol::status::ok));
+    std::size_t count_offset = output.size();
+    protocol::put_u64(output, 0);
+
+    std::uint64_t count = 0;
+    auto append_match = [&](std::uint64_t category_ID, std::uint64_t password_ID, std::string_view value) {
+        protocol::put_u64(output, category_ID);
+        protocol::put_u64(output, password_ID);
+        protocol::put_u64(output, value.size());
+        output.append(value);
+        ++count;
+    };
+
+    if (_sealed != nullptr) {
+        _sealed->search(body, append_match);
+    } else {
+        for (const concurrent_vault::match &found : _shared->search(body)) {
+            append_match(found.category_ID, found.password_ID, found.password);
+        }
+    }
+
+    /// Patch the match count in place now that it is known
+    for (std::size_t i = 0; i < 8; ++i) output[count_offset + i] = static_cast<char>((count >> (i * 8)) & 0xFF);
+    protocol::end_frame(output, frame);
+}
+
+/**
+ * @brief Adds a password to a category or the password list.
+ *
+ * The password has to pass the same security check as the menu.
+ */
+auto vault_server::handle_add(std::string_view body, std::pmr::string &output) -> void {
+    std::optional<std::uint64_t> category_ID = protocol::get_u64(body);
+    std::string_view value = body;
+
+    bool valid = category_ID.has_value() && passwords::is_secure(value);
+
+    std::optional<std::size_t> password_ID;
+    if (valid && _sealed != nullptr) password_ID = _sealed->add(*category_ID, value);
+    else if (valid) password_ID = _shared->add_password(*category_ID, value);
+
+    auto result = !valid ? protocol::status::invalid
+                  : password_ID ? protocol::status::ok : protocol::status::not_found;
+    std::size_t frame = protocol::begin_frame(output, static_cast<std::uint8_t>(result));
+    if (password_ID) protocol::put_u64(output, *password_ID);
+    protocol::end_frame(output, frame);
+}
+
+/**
+ * @brief Requests the event loop to stop.
+ */
+auto vault_server::on_signal(int) -> void {
+    _stop = 1;
+}
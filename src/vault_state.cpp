@@ -0,0 +1,167 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <fmt/format.h>
+#include "../include/vault_state.hpp"
+
+/**
+ * @brief Records a category, including all of its passwords.
+ * @param category The category to record.
+ */
+auto vault_state::put_category(const categories::category &category) -> void {
+    category_version recorded;
+    recorded.ID = category.ID;
+    recorded.name = category.name;
+    recorded._pass_id = category._pass_id;
+
+    for (const auto &[key, value] : category.passwords) {
+        recorded.passwords.insert(key, value);
+    }
+
+    categories_map.insert(category.ID, std::move(recorded));
+}
+
+/**
+ * @brief Records a password added to or edited in a category.
+ *
+ * Only the path to the category and the path to the password
+ * inside of it are copied, every other node stays shared.
+ *
+ * @param category_ID The ID of the category holding the password.
+ * @param password_ID The ID of the password inside of the category.
+ * @param password    The new password value.
+ * @return False if the category does not exist.
+ */
+auto vault_state::put_password(std::size_t category_ID, std::size_t password_ID,
+                               std::string_view password) -> bool {
+    const category_version *existing = categories_map.find(category_ID);
+    if (existing == nullptr) return false;
+
+    category_version updated = *existing;
+    updated.passwords.insert(password_ID, std::pmr::string(password));
+    updated._pass_id = std::max(updated._pass_id, password_ID + 1);
+    categories_map.insert(category_ID, std::move(updated));
+    return true;
+}
+
+/**
+ * @brief Removes a password of a category.
+ * @param category_ID The ID of the category holding the password.
+ * @param password_ID The ID of the removed password.
+ * @return False if the category or the password does not exist.
+ */
+auto vault_state::erase_password(std::size_t category_ID, std::size_t password_ID) -> bool {
+    const category_version *existing = categories_map.find(category_ID);
+    if (existing == nullptr || existing->passwords.find(password_ID) == nullptr) return false;
+
+    category_version updated = *existing;
+    updated.passwords.erase(password_ID);
+    categories_map.insert(category_ID, std::move(updated));
+    return true;
+}
+
+/**
+ * @brief Replaces this version with a copy of the vault.
+ * @param category The categories object to copy.
+ * @param password The passwords object to copy.
+ */
+auto vault_state::assign(const categories &category, const passwords &password) -> void {
+    categories_map.clear();
+    uncategorized.clear();
+
+    for (const auto &element : category.categories_map) put_category(element.second);
+    for (const auto &element : password.get_passwords()) uncategorized.insert(element.first, element.second);
+}
+
+/**
+ * @brief Replaces the vault contents with this version.
+ * @param category The categories object to restore.
+ * @param password The passwords object to restore.
+ */
+auto vault_state::restore(categories &category, passwords &password) const -> void {
+    category.categories_map.clear();
+    categories_map.for_each([&](std::size_t key, const category_version &recorded) {
+        categories::category &restored = category.categories_map[key];
+        restored.ID = recorded.ID;
+        restored.name = recorded.name;
+        restored._pass_id = recorded._pass_id;
+        recorded.passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+            restored.passwords.emplace_hint(restored.passwords.end(), password_ID, value);
+        });
+    });
+
+    password._pass_without_categories.clear();
+    uncategorized.for_each([&](std::size_t key, const passwords::password &recorded) {
+        password._pass_without_categories.emplace_hint(
+                password._pass_without_categories.end(), key, recorded);
+    });
+}
+
+/**
+ * @brief Checks whether both versions share their roots, meaning nothing changed in between.
+ */
+auto vault_state::same(const vault_state &other) const -> bool {
+    return categories_map.same(other.categories_map) && uncategorized.same(other.uncategorized);
+}
+
+/**
+ * @brief Hashes a byte string with a 64-bit seed.
+ *
+ * FNV-1a over the bytes, started from the mixed seed and finished with
+ * the SplitMix64 finalizer so that every input bit affects every output bit.
+ * It detects accidental differences, it is not a cryptographic hash.
+ *
+ * @param bytes The bytes to hash.
+ * @param seed  The seed, for example the key of the hashed element.
+ * @return The 64-bit hash.
+ */
+auto vault_state::hash(std::string_view bytes, std::uint64_t seed) -> std::uint64_t {
+    auto finalize = [](std::uint64_t value) -> std::uint64_t {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9ULL;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    };
+
+    std::uint64_t state = 0xCBF29CE484222325ULL ^ finalize(seed + 0x9E3779B97F4A7C15ULL);
+    for (char c : bytes) {
+        state ^= static_cast<unsigned char>(c);
+        state *= 0x100000001B3ULL;
+    }
+    return finalize(state);
+}
+
+/**
+ * @brief Hash of a single password inside of a category.
+ */
+auto vault_state::password_digest::operator()(std::size_t key,
+                                              const std::pmr::string &value) const -> std::uint64_t {
+    return hash(value, key);
+}
+
+/**
+ * @brief Hash of a category, rolling up its name and the digest of its passwords.
+ */
+auto vault_state::category_digest::operator()(std::size_t key,
+                                              const category_version &value) const -> std::uint64_t {
+    std::string header = fmt::format("{}:{}:{}", value._pass_id, value.passwords.digest(), value.name);
+    return hash(header, key);
+}
+
+/**
+ * @brief Hash of a single password of the password list.
+ */
+auto vault_state::list_digest::operator()(std::size_t key,
+                                          const passwords::password &value) const -> std::uint64_t {
+    return hash(value.name, ~static_cast<std::uint64_t>(key));
+}
+
+/**
+ * @brief Digest of the whole vault, the root of the Merkle tree.
+ */
+auto vault_state::digest() const -> std::uint64_t {
+    return hash(fmt::format("{}:{}", categories_map.digest(), uncategorized.digest()), 0);
+}
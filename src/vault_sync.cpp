@@ -0,0 +1,188 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include "../include/vault_file.hpp"
+#include "../include/vault_sync.hpp"
+
+/**
+ * @brief Calls visit(key) for every key whose element differs between the maps.
+ *
+ * Starts from the root digests and only descends into key ranges whose
+ * digests differ, so identical parts of the maps are never enumerated.
+ */
+template <typename Map, typename Visit>
+auto vault_sync::diff_keys(const Map &source, const Map &target, Visit &&visit) -> void {
+    if (source.digest() == target.digest()) return;
+
+    const std::size_t *source_last = source.last_key();
+    const std::size_t *target_last = target.last_key();
+    std::size_t high = std::max(source_last ? *source_last : 0, target_last ? *target_last : 0);
+
+    diff_range(source, target, 0, high, visit);
+}
+
+/**
+ * @brief Recursively halves a key range until every differing key is isolated.
+ *
+ * Every differing key costs O(log n) range digests of O(log n) each.
+ */
+template <typename Map, typename Visit>
+auto vault_sync::diff_range(const Map &source, const Map &target,
+                            std::size_t low, std::size_t high, Visit &visit) -> void {
+    if (source.range_digest(low, high) == target.range_digest(low, high)) return;
+
+    if (low == high) {
+        visit(low);
+        return;
+    }
+
+    std::size_t middle = low + (high - low) / 2;
+    diff_range(source, target, low, middle, visit);
+    diff_range(source, target, middle + 1, high, visit);
+}
+
+/**
+ * @brief Lists what has to change in the target to make it equal to the source.
+ *
+ * @param source The vault to compare against.
+ * @param target The vault to compare.
+ * @return Every differing category and password.
+ */
+auto vault_sync::diff(const vault_state &source, const vault_state &target) -> std::vector<difference> {
+    std::vector<difference> differences;
+
+    diff_keys(source.categories_map, target.categories_map, [&](std::size_t category_ID) {
+        const vault_state::category_version *from = source.categories_map.find(category_ID);
+        const vault_state::category_version *to = target.categories_map.find(category_ID);
+
+        /// A category missing on either side is transferred as a whole
+        if (from == nullptr || to == nullptr) {
+            differences.push_back({ category_ID, std::nullopt });
+            return;
+        }
+
+        if (from->name != to->name || from->_pass_id != to->_pass_id) {
+            differences.push_back({ category_ID, std::nullopt });
+        }
+        diff_keys(from->passwords, to->passwords, [&](std::size_t password_ID) {
+            differences.push_back({ category_ID, password_ID });
+        });
+    });
+
+    diff_keys(source.uncategorized, target.uncategorized, [&](std::size_t password_ID) {
+        differences.push_back({ 0, password_ID });
+    });
+
+    return differences;
+}
+
+/**
+ * @brief Copies the differing parts of the source into the target.
+ *
+ * Whole categories are shared with the source instead of being copied.
+ *
+ * @param source      The vault to copy from.
+ * @param target      The vault to update.
+ * @param differences The result of diff(source, target).
+ */
+auto vault_sync::apply(const vault_state &source, vault_state &target,
+                       const std::vector<difference> &differences) -> void {
+    for (const difference &change : differences) {
+        if (change.category_ID == 0) {
+            const passwords::password *from = source.uncategorized.find(*change.password_ID);
+            if (from != nullptr) target.uncategorized.insert(*change.password_ID, *from);
+            else target.uncategorized.erase(*change.password_ID);
+            continue;
+        }
+
+        const vault_state::category_version *from = source.categories_map.find(change.category_ID);
+        const vault_state::category_version *to = target.categories_map.find(change.category_ID);
+
+        if (!change.password_ID.has_value()) {
+            if (from == nullptr) target.categories_map.erase(change.category_ID);
+            else if (to == nullptr) target.categories_map.insert(change.category_ID, *from);
+            else {
+                vault_state::category_version updated = *to;
+                updated.name = from->name;
+                updated._pass_id = from->_pass_id;
+                target.categories_map.insert(change.category_ID, std::move(updated));
+            }
+            continue;
+        }
+
+        const std::pmr::string *password = from->passwords.find(*change.password_ID);
+        vault_state::category_version updated = *target.categories_map.find(change.category_ID);
+        if (password != nullptr) updated.passwords.insert(*change.password_ID, *password);
+        else updated.passwords.erase(*change.password_ID);
+        target.categories_map.insert(change.category_ID, std::move(updated));
+    }
+}
+
+/**
+ * @brief Prints the differences between two vault files.
+ * @return True if both files could be read.
+ */
+auto vault_sync::run_diff(const std::string &source_file, const std::string &target_file) -> bool {
+    std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+    vault_state source, target;
+    if (!load(source_file, key, source) || !load(target_file, key, target)) return false;
+
+    fmt::print("[+] '{}' Digest: {:016x}\n", source_file, source.digest());
+    fmt::print("[+] '{}' Digest: {:016x}\n", target_file, target.digest());
+
+    std::vector<difference> differences = diff(source, target);
+    for (const difference &change : differences) {
+        if (!change.password_ID.has_value()) fmt::print("[Category: {}]\n", change.category_ID);
+        else if (change.category_ID == 0) fmt::print("[Password List, ID: {}]\n", *change.password_ID);
+        else fmt::print("[Category: {}, ID: {}]\n", change.category_ID, *change.password_ID);
+    }
+
+    if (differences.empty()) fmt::print("[+] The Vaults are Identical\n");
+    else fmt::print("[+] {} Differences Found\n", differences.size());
+    return true;
+}
+
+/**
+ * @brief Makes the target vault file equal to the source vault file.
+ *
+ * Only the differing categories and passwords are transferred into the
+ * in-memory target before it is written back.
+ *
+ * @return True if the target was synchronized.
+ */
+auto vault_sync::run_sync(const std::string &source_file, const std::string &target_file) -> bool {
+    std::pmr::string key = vault_file::read_key("Enter the secret key: ", true);
+    vault_state source, target;
+    if (!load(source_file, key, source) || !load(target_file, key, target)) return false;
+
+    std::vector<difference> differences = diff(source, target);
+    if (differences.empty()) {
+        fmt::print("[+] The Vaults are Already in Sync\n");
+        return true;
+    }
+    apply(source, target, differences);
+
+    categories category;
+    passwords password;
+    target.restore(category, password);
+    if (!vault_file::save(category, password, target_file, key)) return false;
+
+    fmt::print("[+] {} Differences Transferred to '{}'\n", differences.size(), target_file);
+    return true;
+}
+
+/**
+ * @brief Loads a vault file into a vault version.
+ */
+auto vault_sync::load(const std::string &filename, std::string_view key, vault_state &state) -> bool {
+    if (key.empty()) return false;
+
+    categories category;
+    passwords password;
+    if (!vault_file::load(category, password, filename, key)) return false;
+
+    state.assign(category, password);
+    return true;
+}
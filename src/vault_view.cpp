@@ -0,0 +1,241 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <cstdio>
+#include <fmt/format.h>
+#include "../include/trace.hpp"
+#include "../include/vault_view.hpp"
+
+/**
+ * @brief Creates a view on the first page of the categories.
+ * @param category  The categories to show.
+ * @param page_size The number of rows on a page.
+ */
+vault_view::vault_view(const categories &category, std::size_t page_size)
+        : _category(&category), _page_size(std::max<std::size_t>(page_size, 1)) {
+    filter("");
+}
+
+/**
+ * @brief Creates a view on the first page of the password list.
+ * @param password  The password list to show.
+ * @param page_size The number of rows on a page.
+ */
+vault_view::vault_view(const passwords &password, std::size_t page_size)
+        : _password(&password), _page_size(std::max<std::size_t>(page_size, 1)) {
+    filter("");
+}
+
+/**
+ * @brief Replaces the filter and goes back to the first page.
+ * @param text The text to look for, empty to show everything.
+ */
+auto vault_view::filter(std::string_view text) -> void {
+    _filter = text;
+    _matches = count();
+    _starts.assign(1, position { _password != nullptr ? _list_section : 0, 0 });
+    render();
+}
+
+/**
+ * @brief Moves to the next page.
+ * @return False if this was the last page.
+ */
+auto vault_view::next() -> bool {
+    if (!_next) return false;
+    _starts.push_back(*_next);
+    render();
+    return true;
+}
+
+/**
+ * @brief Moves to the previous page.
+ * @return False if this was the first page.
+ */
+auto vault_view::previous() -> bool {
+    if (_starts.size() == 1) return false;
+    _starts.pop_back();
+    render();
+    return true;
+}
+
+/**
+ * @brief Writes the current page to the standard output in one call.
+ */
+auto vault_view::print() const -> void {
+    std::fwrite(_text.data(), 1, _text.size(), stdout);
+    std::fflush(stdout);
+}
+
+auto vault_view::pages() const -> std::size_t {
+    return std::max<std::size_t>((_matches + _page_size - 1) / _page_size, 1);
+}
+
+/**
+ * @brief Shows the categories page by page, with a filter.
+ *
+ * A vault that fits on one page is printed without asking for anything.
+ */
+auto vault_view::browse(const categories &category) -> void {
+    vault_view view(category);
+    view.print();
+    if (view.pages() == 1) return;
+
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::string command;
+    while (true) {
+        fmt::print("[N]ext, [P]revious, [F]ilter <Text>, [Q]uit: ");
+        if (!std::getline(std::cin, command)) return;
+
+        char action = command.empty() ? 'N' : static_cast<char>(std::toupper(static_cast<unsigned char>(command[0])));
+        if (action == 'Q') return;
+
+        if (action == 'N' && !view.next()) fmt::print("\n[-] This is the Last Page\n");
+        else if (action == 'P' && !view.previous()) fmt::print("\n[-] This is the First Page\n");
+        else if (action == 'F') {
+            std::size_t begin = std::min(command.find_first_not_of(' ', 1), command.size());
+            view.filter(std::string_view(command).substr(begin));
+            view.print();
+        } else if (action != 'N' && action != 'P') fmt::print("\n[-] Invalid Input, Try Again\n");
+        else view.print();
+    }
+}
+
+/**
+ * @brief Prints the first page, for the prompts that ask to pick from the vault.
+ */
+auto vault_view::preview(const categories &category) -> void {
+    vault_view view(category);
+    view.print();
+    if (view.pages() > 1) fmt::print("[+] Use Print Category to Browse and Filter the Rest\n");
+}
+
+auto vault_view::preview(const passwords &password) -> void {
+    vault_view view(password);
+    view.print();
+    if (view.pages() > 1) fmt::print("[+] Use Search for Passwords to Find the Rest\n");
+}
+
+/**
+ * @brief Returns the rows per page, GUARDCIPHER_PAGE_SIZE or 25 by default.
+ */
+auto vault_view::configured_page_size() -> std::size_t {
+    static const std::size_t page_size = []() -> std::size_t {
+        const char *setting = std::getenv("GUARDCIPHER_PAGE_SIZE");
+        std::size_t value = setting != nullptr ? std::strtoull(setting, nullptr, 10) : 0;
+        return value > 0 ? value : _default_page_size;
+    }();
+    return page_size;
+}
+
+/**
+ * @brief Formats the current page and finds where the next one starts.
+ *
+ * Every password is a row, and so is an empty category. Category headers
+ * are not counted, a category that goes on from the previous page gets
+ * its header repeated.
+ */
+auto vault_view::render() -> void {
+    TRACE_SPAN("vault_view::render");
+    const position &from = _starts.back();
+    fmt::memory_buffer buffer;
+    auto out = std::back_inserter(buffer);
+    std::size_t rows = 0;
+    _next.reset();
+
+    /// Formats the rows of one section, returns false once the page is full
+    auto section = [&](std::size_t ID, bool name_matches, const auto &map, auto value_of, auto write_header) -> bool {
+        auto it = ID == from.section ? map.lower_bound(from.password_ID) : map.begin();
+        bool continued = it != map.begin();
+        bool header_written = false;
+
+        if (map.empty() && ID != _list_section) {
+            if (!name_matches) return true;
+            if (rows == _page_size) {
+                _next = position { ID, 0 };
+                return false;
+            }
+            write_header(false);
+            ++rows;
+            return true;
+        }
+
+        for (; it != map.end(); ++it) {
+            std::string_view value = value_of(it->second);
+            if (!name_matches && value.find(_filter) == std::string_view::npos) continue;
+            if (rows == _page_size) {
+                _next = position { ID, it->first };
+                return false;
+            }
+            if (!header_written) {
+                write_header(continued);
+                header_written = true;
+            }
+            fmt::format_to(out, "ID: {}, {}\n", it->first, value);
+            ++rows;
+        }
+        return true;
+    };
+
+    if (_category != nullptr) {
+        if (_matches > 0) fmt::format_to(out, "\n----------- Categories -----------\n");
+        for (auto it = _category->categories_map.lower_bound(from.section); it != _category->categories_map.end(); ++it) {
+            const categories::category &element = it->second;
+            bool name_matches = element.name.find(_filter) != std::string::npos;
+            auto header = [&](bool continued) {
+                fmt::format_to(out, "\n[+] ID: {} Name: {}{}\n Passwords:\n",
+                               element.ID, element.name, continued ? " (Continued)" : "");
+            };
+            if (!section(it->first, name_matches, element.passwords,
+                         [](const std::pmr::string &value) -> std::string_view { return value; }, header)) break;
+        }
+    } else {
+        auto header = [&](bool continued) {
+            fmt::format_to(out, "\n[+] Password List{}\n", continued ? " (Continued)" : "");
+        };
+        section(_list_section, _filter.empty(), _password->get_passwords(),
+                [](const passwords::password &value) -> std::string_view { return value.name; }, header);
+    }
+
+    std::string_view shown = _category != nullptr ? "Category" : "Password";
+    if (_matches == 0 && _filter.empty()) {
+        fmt::format_to(out, "\n[-] No {} Found\n", shown);
+    } else if (_matches == 0) {
+        fmt::format_to(out, "\n[-] Nothing Matches '{}'\n", _filter);
+    } else {
+        std::size_t first_row = (_starts.size() - 1) * _page_size + 1;
+        fmt::format_to(out, "\n[+] Page {} of {}, Rows {} to {} of {}{}\n", _starts.size(), pages(),
+                       first_row, first_row + rows - 1, _matches,
+                       _filter.empty() ? "" : fmt::format(" Matching '{}'", _filter));
+    }
+    _text.assign(buffer.data(), buffer.size());
+}
+
+/**
+ * @brief Counts the rows of every page, without formatting them.
+ */
+auto vault_view::count() const -> std::size_t {
+    TRACE_SPAN("vault_view::count");
+    std::size_t rows = 0;
+
+    if (_password != nullptr) {
+        if (_filter.empty()) return _password->get_passwords().size();
+        for (const auto &[ID, value] : _password->get_passwords()) {
+            rows += value.name.find(_filter) != std::string::npos ? 1 : 0;
+        }
+        return rows;
+    }
+
+    for (const auto &[ID, element] : _category->categories_map) {
+        if (element.name.find(_filter) != std::string::npos) {
+            rows += std::max<std::size_t>(element.passwords.size(), 1);
+            continue;
+        }
+        for (const auto &[password_ID, value] : element.passwords) {
+            rows += value.find(_filter) != std::string::npos ? 1 : 0;
+        }
+    }
+    return rows;
+}
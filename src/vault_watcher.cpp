@@ -0,0 +1,317 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include "../include/trace.hpp"
+#include "../include/history.hpp"
+#include "../include/keyring.hpp"
+#include "../include/secure_arena.hpp"
+#include "../include/vault_file.hpp"
+#include "../include/vault_watcher.hpp"
+
+/**
+ * @brief Starts following a vault file, in place of the one followed so far.
+ *
+ * The watch starts after the file was written or read, so this process
+ * never sees its own save as a change.
+ *
+ * @param filename The vault file.
+ * @param secret   The secret of the vault file, kept to decrypt new versions.
+ * @param base     The vault as it is in the file now.
+ */
+auto vault_watcher::watch(const std::string &filename, std::string_view secret, const vault_state &base) -> void {
+    stop();
+    {
+        std::lock_guard guard(_lock);
+        _base = base;
+    }
+    _filename = filename;
+    _thread = std::jthread(&vault_watcher::run, filename, std::pmr::string(secret));
+}
+
+/**
+ * @brief Merges a version of the file read in the background, if there is one.
+ *
+ * Called by the menu between two commands. Every change on disk that does
+ * not conflict with an unsaved local edit is applied through history, so
+ * the merge is one undo step. The file as read becomes the new base.
+ *
+ * @param category The categories object to merge into.
+ * @param password The passwords object to merge into.
+ */
+auto vault_watcher::poll(categories &category, passwords &password) -> void {
+    std::optional<reload> arrived;
+    {
+        std::lock_guard guard(_lock);
+        if (!_pending) return;
+        arrived.swap(_pending);
+        _base = arrived->incoming;
+    }
+
+    TRACE_SPAN("vault_watcher::merge");
+    vault_state live = history::snapshot();
+    local_edits local = collect(vault_sync::diff(live, arrived->base));
+
+    std::size_t merged = 0;
+    std::vector<vault_sync::difference> conflicting;
+    for (const vault_sync::difference &change : arrived->changes) {
+        if (!conflicts(local, change)) {
+            apply(arrived->incoming, change, category, password);
+            ++merged;
+        } else if (!same(live, arrived->incoming, change)) conflicting.push_back(change);
+    }
+    history::commit("Merge Changes From Disk");
+
+    fmt::print("\n[+] '{}' Changed on Disk, {} Changes Merged\n", _filename, merged);
+    for (std::size_t i = 0; i < std::min(conflicting.size(), _listed_conflicts); ++i) {
+        fmt::print("[-] {} Changed Both Here and on Disk, Keeping the Local Version\n", describe(conflicting[i]));
+    }
+    if (conflicting.size() > _listed_conflicts) {
+        fmt::print("[-] ... and {} More Conflicts\n", conflicting.size() - _listed_conflicts);
+    }
+    if (!conflicting.empty()) fmt::print("[-] Saving the Vault Overwrites Their Version on Disk\n");
+}
+
+/**
+ * @brief Waits for a version of the file that is still being read and merges it.
+ *
+ * Called before saving, so a save never overwrites a change it has not seen.
+ *
+ * @param category The categories object to merge into.
+ * @param password The passwords object to merge into.
+ */
+auto vault_watcher::settle(categories &category, passwords &password) -> void {
+    if (!_thread.joinable()) return;
+    {
+        std::unique_lock guard(_lock);
+        _settled.wait(guard, [] { return !_reading; });
+    }
+    poll(category, password);
+}
+
+/**
+ * @brief Stops following the vault file and drops what was not merged yet,
+ * along with the version the watcher compared it against.
+ */
+auto vault_watcher::stop() -> void {
+    if (_thread.joinable()) {
+        _thread.request_stop();
+        _thread.join();
+    }
+
+    std::lock_guard guard(_lock);
+    _pending.reset();
+    _base = {};
+    _reading = false;
+}
+
+/**
+ * @brief Body of the watcher thread.
+ *
+ * Watches the directory rather than the file, since a writer replacing the
+ * file by renaming a temporary one over it leaves a watch on the old inode.
+ */
+auto vault_watcher::run(std::stop_token stop, std::string filename, std::pmr::string secret) -> void {
+    std::filesystem::path path(filename);
+    std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    std::string name = path.filename().string();
+
+    int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify < 0 || inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fmt::print("\n[-] Cannot Watch '{}' for Changes: {}\n", filename, std::strerror(errno));
+        if (notify >= 0) close(notify);
+        return;
+    }
+
+    while (!stop.stop_requested()) {
+        if (!wait_for_change(notify, name, _poll_interval_ms)) continue;
+        {
+            std::lock_guard guard(_lock);
+            _reading = true;
+        }
+
+        /// A writer may close the file several times, it is read once it stays unchanged
+        while (!stop.stop_requested() && wait_for_change(notify, name, _settle_ms)) { }
+
+        std::optional<reload> arrived = stop.stop_requested() ? std::nullopt : read(filename, secret);
+        {
+            std::lock_guard guard(_lock);
+            if (arrived) _pending = std::move(arrived);
+            _reading = false;
+        }
+        _settled.notify_all();
+    }
+
+    secure_arena::zeroize(secret.data(), secret.capacity());
+    close(notify);
+}
+
+/**
+ * @brief Waits for inotify events and drains them.
+ * @return True if one of the events was about the file.
+ */
+auto vault_watcher::wait_for_change(int notify, const std::string &name, int timeout_ms) -> bool {
+    pollfd watched { notify, POLLIN, 0 };
+    if (::poll(&watched, 1, timeout_ms) <= 0) return false;
+
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = ::read(notify, buffer, sizeof(buffer))) > 0) {
+        for (char *cursor = buffer; cursor < buffer + length;) {
+            auto *event = reinterpret_cast<inotify_event*>(cursor);
+            if (event->len > 0 && name == event->name) changed = true;
+            cursor += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Decrypts the file and lists how it differs from the base.
+ * @return The new version, or nullopt if it cannot be read or nothing changed.
+ */
+auto vault_watcher::read(const std::string &filename, std::string_view secret) -> std::optional<reload> {
+    TRACE_SPAN("vault_watcher::read");
+    categories category;
+    passwords password;
+    std::pmr::map<std::size_t, std::pmr::string> loaded_keys;
+    if (!vault_file::load(category, password, filename, secret, loaded_keys)) return std::nullopt;
+
+    reload arrived;
+    arrived.incoming.assign(category, password);
+    {
+        std::lock_guard guard(_lock);
+        arrived.base = _base;
+    }
+
+    arrived.changes = vault_sync::diff(arrived.incoming, arrived.base);
+    if (arrived.changes.empty()) return std::nullopt;
+    return arrived;
+}
+
+/**
+ * @brief Sorts the local edits by what they touch.
+ */
+auto vault_watcher::collect(const std::vector<vault_sync::difference> &differences) -> local_edits {
+    local_edits local;
+    for (const vault_sync::difference &change : differences) {
+        local.touched.insert(change.category_ID);
+        if (!change.password_ID) local.replaced.insert(change.category_ID);
+        else local.passwords.emplace(change.category_ID, *change.password_ID);
+    }
+    return local;
+}
+
+/**
+ * @brief Checks whether a change on disk touches something that was edited locally.
+ */
+auto vault_watcher::conflicts(const local_edits &local, const vault_sync::difference &change) -> bool {
+    if (!change.password_ID) return local.touched.contains(change.category_ID);
+    return local.replaced.contains(change.category_ID)
+           || local.passwords.contains({ change.category_ID, *change.password_ID });
+}
+
+/**
+ * @brief Checks whether both versions agree on what a change touches.
+ */
+auto vault_watcher::same(const vault_state &left, const vault_state &right,
+                         const vault_sync::difference &change) -> bool {
+    if (change.category_ID == keyring::list_ID) {
+        const passwords::password *ours = left.uncategorized.find(*change.password_ID);
+        const passwords::password *theirs = right.uncategorized.find(*change.password_ID);
+        return ours == nullptr ? theirs == nullptr : theirs != nullptr && ours->name == theirs->name;
+    }
+
+    if (!change.password_ID) {
+        return left.categories_map.range_digest(change.category_ID, change.category_ID)
+               == right.categories_map.range_digest(change.category_ID, change.category_ID);
+    }
+
+    const vault_state::category_version *ours = left.categories_map.find(change.category_ID);
+    const vault_state::category_version *theirs = right.categories_map.find(change.category_ID);
+    const std::pmr::string *our_value = ours != nullptr ? ours->passwords.find(*change.password_ID) : nullptr;
+    const std::pmr::string *their_value = theirs != nullptr ? theirs->passwords.find(*change.password_ID) : nullptr;
+    return our_value == nullptr ? their_value == nullptr : their_value != nullptr && *our_value == *their_value;
+}
+
+/**
+ * @brief Applies one change from disk to the vault, through history.
+ *
+ * A changed category only takes over its name and password counter,
+ * its changed passwords follow as changes of their own.
+ *
+ * @param incoming The version of the file the change comes from.
+ * @param change   The change.
+ * @param category The categories object to update.
+ * @param password The passwords object to update.
+ */
+auto vault_watcher::apply(const vault_state &incoming, const vault_sync::difference &change,
+                          categories &category, passwords &password) -> void {
+    if (change.category_ID == keyring::list_ID) {
+        std::size_t password_ID = *change.password_ID;
+        const passwords::password *from = incoming.uncategorized.find(password_ID);
+        if (from != nullptr) {
+            password._pass_without_categories.insert_or_assign(password_ID, *from);
+            password._current_ID = std::max(password._current_ID, password_ID + 1);
+            history::put_uncategorized(*from);
+        } else if (password._pass_without_categories.erase(password_ID) > 0) {
+            history::erase_uncategorized(password_ID);
+        }
+        return;
+    }
+
+    const vault_state::category_version *from = incoming.categories_map.find(change.category_ID);
+    auto category_it = category.categories_map.find(change.category_ID);
+
+    if (!change.password_ID) {
+        if (from == nullptr) {
+            if (category_it == category.categories_map.end()) return;
+            category.categories_map.erase(category_it);
+            history::erase_category(change.category_ID);
+            return;
+        }
+
+        if (category_it == category.categories_map.end()) {
+            categories::category added;
+            added.ID = from->ID;
+            from->passwords.for_each([&](std::size_t password_ID, const std::pmr::string &value) {
+                added.passwords.emplace_hint(added.passwords.end(), password_ID, value);
+            });
+            category_it = category.categories_map.emplace(change.category_ID, std::move(added)).first;
+            category._current_ID = std::max(category._current_ID, change.category_ID + 1);
+        }
+        category_it->second.name = from->name;
+        category_it->second._pass_id = from->_pass_id;
+        history::put_category(category_it->second);
+        return;
+    }
+
+    if (category_it == category.categories_map.end()) return;
+    std::size_t password_ID = *change.password_ID;
+    const std::pmr::string *value = from != nullptr ? from->passwords.find(password_ID) : nullptr;
+    if (value != nullptr) {
+        category_it->second.passwords.insert_or_assign(password_ID, *value);
+        category_it->second._pass_id = std::max(category_it->second._pass_id, password_ID + 1);
+        history::put_password(change.category_ID, password_ID, *value);
+    } else if (category_it->second.passwords.erase(password_ID) > 0) {
+        history::erase_password(change.category_ID, password_ID);
+    }
+}
+
+/**
+ * @brief Names what a change touches, for the conflict report.
+ */
+auto vault_watcher::describe(const vault_sync::difference &change) -> std::string {
+    if (change.category_ID == keyring::list_ID) return fmt::format("Password {} of the Password List", *change.password_ID);
+    if (!change.password_ID) return fmt::format("Category {}", change.category_ID);
+    return fmt::format("Password {} of Category {}", *change.password_ID, change.category_ID);
+}
@@ -0,0 +1,246 @@
+/*
+ * (C)opyright 2023 Ramiz Abbasov <ramizna@code.edu.az>
+ * See LICENSE file for license details
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <array>
+#include <cstdio>
+#include <sstream>
+#include <filesystem>
+#include "../include/workload.hpp"
+
+/**
+ * @param source The stream buffer the input is read from.
+ * @param script The script every input line is appended to.
+ */
+workload::recorder::recorder(std::streambuf *source, std::ofstream &script)
+        : _source(source), _script(script), _start(std::chrono::steady_clock::now()) { }
+
+/**
+ * @brief Reads the next line from the source and records it with its timestamp.
+ */
+auto workload::recorder::underflow() -> int_type {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    _line.clear();
+    int_type next = _source->sbumpc();
+    while (!traits_type::eq_int_type(next, traits_type::eof())) {
+        _line.push_back(traits_type::to_char_type(next));
+        if (_line.back() == '\n') break;
+        next = _source->sbumpc();
+    }
+    if (_line.empty()) return traits_type::eof();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - _start).count();
+    std::string_view recorded(_line);
+    if (recorded.ends_with('\n')) recorded.remove_suffix(1);
+    _script << elapsed << '\t' << recorded << '\n' << std::flush;
+
+    setg(_line.data(), _line.data(), _line.data() + _line.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+/**
+ * @brief Runs the menu while recording everything typed into a script.
+ *
+ * The script holds passwords and keys in plaintext, so it is only readable by the owner.
+ *
+ * @param password The passwords object.
+ * @param category The categories object.
+ * @param filename The script to write.
+ * @return True if the script could be created.
+ */
+auto workload::record(passwords &password, categories &category, const std::string &filename) -> bool {
+    std::ofstream script(filename, std::ios::trunc);
+    if (!script) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::permissions(filename, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                                 std::filesystem::perm_options::replace, error);
+    fmt::print("[+] Recording Input to '{}', It Will Contain Everything Typed, Including Passwords\n", filename);
+
+    recorder input(std::cin.rdbuf(), script);
+    std::streambuf *previous = std::cin.rdbuf(&input);
+    menu::process(password, category);
+    std::cin.rdbuf(previous);
+    return true;
+}
+
+/**
+ * @brief Feeds a script to the menu at full speed and reports how long every operation took.
+ *
+ * Timestamps are ignored. The script is repeated scale times, a final
+ * exit command is dropped from every copy and appended once at the end.
+ * Menu output is discarded while the script runs.
+ *
+ * @param password The passwords object.
+ * @param category The categories object.
+ * @param filename The script to replay.
+ * @param scale    How many times the script is repeated.
+ * @return True if the script could be read.
+ */
+auto workload::replay(passwords &password, categories &category,
+                      const std::string &filename, std::size_t scale) -> bool {
+    std::ifstream script(filename);
+    if (!script) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(script, line);) {
+        std::size_t tab = line.find('\t');
+        lines.push_back(tab == std::string::npos ? line : line.substr(tab + 1));
+    }
+    std::string leave = std::to_string(menu::option_ID("Exit").value_or(0));
+    if (!lines.empty() && lines.back() == leave) lines.pop_back();
+
+    std::string input;
+    for (std::size_t i = 0; i < scale; ++i) {
+        for (const std::string &line : lines) {
+            input.append(line);
+            input.push_back('\n');
+        }
+    }
+    input.append(leave);
+    input.push_back('\n');
+
+    std::istringstream stream(std::move(input));
+    std::streambuf *previous = std::cin.rdbuf(stream.rdbuf());
+
+    /// Silence the menu by pointing the standard output at /dev/null
+    std::fflush(stdout);
+    std::cout.flush();
+    int saved_output = dup(STDOUT_FILENO);
+    int null_output = open("/dev/null", O_WRONLY);
+    if (null_output >= 0) {
+        dup2(null_output, STDOUT_FILENO);
+        close(null_output);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    menu::process(password, category);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::fflush(stdout);
+    std::cout.flush();
+    if (saved_output >= 0) {
+        dup2(saved_output, STDOUT_FILENO);
+        close(saved_output);
+    }
+    std::cin.rdbuf(previous);
+
+    std::size_t replayed = lines.size() * scale;
+    fmt::print("[+] Replayed {} Input Lines ({} x {}) in {:.3f}s, {:.0f} Lines/s\n", replayed, lines.size(),
+               scale, elapsed.count(), elapsed.count() > 0 ? static_cast<double>(replayed) / elapsed.count() : 0.0);
+    metrics::print();
+    return true;
+}
+
+/**
+ * @brief Writes a synthetic script that mixes adds, searches, sorts and saves.
+ *
+ * Roughly 45% adds a password (to a random category once there is one),
+ * 30% searches, 10% adds a category, 10% sorts and 5% saves the vault to
+ * "workload.gcv". The same seed always produces the same script.
+ *
+ * @param filename   The script to write.
+ * @param operations The number of menu operations.
+ * @param seed       The seed of the random engine.
+ * @return True if the script was written.
+ */
+auto workload::generate(const std::string &filename, std::size_t operations, std::uint64_t seed) -> bool {
+    std::ofstream script(filename, std::ios::trunc);
+    if (!script) {
+        fmt::print("[-] Failed to Open the File '{}'\n", filename);
+        return false;
+    }
+
+    /// The options are looked up by label, so the script follows the menu if it is renumbered
+    std::array<std::string, 6> option_IDs;
+    constexpr std::array<std::string_view, 6> labels {
+            "Add Password", "Search for Passwords", "Add Category", "Sort Passwords", "Save Vault", "Exit",
+    };
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        std::optional<std::size_t> ID = menu::option_ID(labels[i]);
+        if (!ID) {
+            fmt::print("[-] The Menu Has No '{}' Option\n", labels[i]);
+            return false;
+        }
+        option_IDs[i] = std::to_string(*ID);
+    }
+    const auto &[add_password, search, add_category, sort, save, leave] = option_IDs;
+
+    std::mt19937_64 engine(seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::size_t category_count = 0;
+
+    auto emit = [&script](std::string_view line) { script << "0\t" << line << '\n'; };
+
+    for (std::size_t i = 0; i < operations; ++i) {
+        int roll = percent(engine);
+
+        if (roll < 45) {
+            emit(add_password);
+            emit("2");
+            emit(generated_password(engine));
+            if (category_count > 0 && percent(engine) < 70) {
+                std::uniform_int_distribution<std::size_t> pick(1, category_count);
+                emit("Y");
+                emit(std::to_string(pick(engine)));
+                emit("Y");
+            } else emit("N");
+        } else if (roll < 75) {
+            emit(search);
+            emit(std::string { static_cast<char>(letter(engine)), static_cast<char>(letter(engine)) });
+        } else if (roll < 85) {
+            emit(add_category);
+            emit(fmt::format("Category {}", ++category_count));
+        } else if (roll < 95) {
+            emit(sort);
+            emit(percent(engine) < 50 ? "1" : "2");
+        } else {
+            emit(save);
+            emit("workload.gcv");
+            emit("workload");
+        }
+    }
+
+    emit(leave);
+    return static_cast<bool>(script);
+}
+
+/**
+ * @brief Generates a random password that passes passwords::is_secure.
+ *
+ * Starts with one character of every required class and never repeats
+ * a character three times in a row.
+ */
+auto workload::generated_password(std::mt19937_64 &engine) -> std::string {
+    constexpr std::string_view upper = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    constexpr std::string_view lower = "abcdefghijklmnopqrstuvwxyz";
+    constexpr std::string_view digits = "0123456789";
+    constexpr std::string_view special = "!@#$%^&*";
+    constexpr std::string_view all = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789!@#$%^&*";
+
+    auto pick = [&engine](std::string_view characters) -> char {
+        std::uniform_int_distribution<std::size_t> index(0, characters.size() - 1);
+        return characters[index(engine)];
+    };
+
+    std::string password { pick(upper), pick(lower), pick(digits), pick(special) };
+    while (password.size() < 14) {
+        char next = pick(all);
+        std::size_t size = password.size();
+        if (password[size - 1] == next && password[size - 2] == next) continue;
+        password.push_back(next);
+    }
+    return password;
+}